@@ -0,0 +1,809 @@
+#ifndef _ASYNC_FILE_H
+#define _ASYNC_FILE_H
+
+// Header inclusion
+#include "file.h"             // for File, file_detail positional helpers
+#include "thread_pool.h"      // for the fallback backend
+#include <algorithm>          // for std::max
+#include <atomic>             // for std::atomic_ref on the shared ring indices
+#include <condition_variable> // for waiting on queue space and drain
+#include <cstddef>            // for std::byte
+#include <functional>         // for completion callbacks
+#include <future>             // for std::future completions
+#include <memory>             // for shared promise ownership
+#include <mutex>              // for guarding the submission side
+#include <system_error>       // for reporting failed operations through futures
+#include <thread>             // for the io_uring completion thread
+#include <vector>             // for batched pool tasks
+#include <sys/uio.h>          // for struct iovec (POSIX only)
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define FILE_HAS_IO_URING 1
+#include <linux/io_uring.h>   // for the io_uring ABI
+#include <sys/mman.h>         // for mapping the rings
+#include <sys/syscall.h>      // for io_uring_setup / io_uring_enter
+#endif
+
+
+
+// Enum class for async backend selection
+enum class AsyncBackend
+{
+    Auto,      // io_uring when the kernel supports it, otherwise ThreadPool
+    IoUring,   // io_uring only, construction fails without kernel support
+    ThreadPool // pread/pwrite on worker threads
+};
+
+// Completion callback: bytes transferred, or -errno on failure
+using AsyncCallback = std::function<void(int64_t result)>;
+
+
+
+//==================== AsyncIoEngine Class ====================
+// Queue of positional reads and writes on any descriptor. Operations are
+// prepared into a batch and handed to the kernel (or the worker pool) by
+// submit(), so a burst of N operations costs one io_uring_enter. At most
+// queue_depth operations are outstanding; prepare blocks, submitting the
+// current batch, while the queue is full. Callbacks run on the engine's
+// completion thread (io_uring) or a worker thread (ThreadPool) and must not
+// block; in particular they must not prepare new work into a full queue.
+// Both backends transfer the whole buffer unless end of file or an error
+// stops them: io_uring resubmits the rest of a short read or write.
+// If the kernel refuses io_uring_enter for good, every operation queued on
+// the ring completes with that -errno, and so does every later one.
+class AsyncIoEngine
+{
+    private:
+        // One queued operation, owned by the engine until its callback ran
+        struct Operation
+        {
+            struct iovec iov;   // buffer of the operation
+            int fd;             // target descriptor
+            int64_t offset;     // target offset
+            bool is_write;      // write instead of read
+            AsyncCallback callback;
+            int64_t done = 0;   // bytes transferred by earlier short completions
+            Operation* prev = NULL; // neighbours in the list of ring operations
+            Operation* next = NULL;
+        };
+
+        AsyncBackend m_backend;      // backend actually in use
+        unsigned m_queue_depth;      // limit of outstanding operations
+        unsigned m_outstanding;      // prepared plus in flight, guarded by m_mutex
+        unsigned m_pending;          // prepared but not yet submitted, guarded by m_mutex
+        std::mutex m_mutex;          // guards the submission side
+        std::condition_variable m_cv;// signalled on every completion
+
+        // ThreadPool backend
+        std::unique_ptr<ThreadPool> m_pool;               // workers for the fallback
+        std::vector<std::function<void()>> m_batch;       // prepared pool tasks
+
+#ifdef FILE_HAS_IO_URING
+        // io_uring backend
+        int m_ring_fd;               // io_uring instance, -1 when not in use
+        void* m_sq_ring;             // mapped submission ring
+        size_t m_sq_ring_size;
+        void* m_cq_ring;             // mapped completion ring, may alias m_sq_ring
+        size_t m_cq_ring_size;
+        io_uring_sqe* m_sqes;        // mapped submission entries
+        size_t m_sqes_size;
+        unsigned* m_sq_tail;
+        unsigned* m_sq_mask;
+        unsigned* m_sq_array;
+        unsigned m_sq_local_tail;    // tail including not yet published entries
+        unsigned* m_cq_head;
+        unsigned* m_cq_tail;
+        unsigned* m_cq_mask;
+        io_uring_cqe* m_cqes;
+        Operation* m_in_flight;      // operations queued on the ring, guarded by m_mutex
+        int m_ring_error;            // errno that made the ring unusable, 0 while it works, guarded by m_mutex
+        bool m_timed_wait;           // kernel takes a timeout on io_uring_enter (IORING_FEAT_EXT_ARG)
+        std::atomic<bool> m_stop;    // completion thread exits on its next wake
+        std::thread m_reaper;        // completion thread
+#endif
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Creates the engine.
+        *
+        * @param[in]   queue_depth: maximum number of outstanding operations.
+        * @param[in]   backend: Auto, IoUring or ThreadPool.
+        * @param[in]   worker_count: threads of the ThreadPool backend, 0 means one per hardware thread.
+        *
+        * @throws      std::system_error: If IoUring was requested and is not available.
+        */
+        explicit AsyncIoEngine(unsigned queue_depth = 128, AsyncBackend backend = AsyncBackend::Auto,
+                               unsigned worker_count = 0)
+            : m_backend(AsyncBackend::ThreadPool), m_queue_depth(queue_depth ? queue_depth : 1),
+              m_outstanding(0), m_pending(0)
+#ifdef FILE_HAS_IO_URING
+              , m_ring_fd(-1), m_sq_ring(NULL), m_sq_ring_size(0), m_cq_ring(NULL), m_cq_ring_size(0),
+              m_sqes(NULL), m_sqes_size(0), m_sq_tail(NULL), m_sq_mask(NULL), m_sq_array(NULL),
+              m_sq_local_tail(0), m_cq_head(NULL), m_cq_tail(NULL), m_cq_mask(NULL), m_cqes(NULL),
+              m_in_flight(NULL), m_ring_error(0), m_timed_wait(false), m_stop(false)
+#endif
+        {
+#ifdef FILE_HAS_IO_URING
+            if(backend != AsyncBackend::ThreadPool)
+            {
+                if(setup_ring())
+                {
+                    m_backend = AsyncBackend::IoUring;
+                    m_reaper = std::thread([this] { reap(); });
+                    return;
+                }
+                if(backend == AsyncBackend::IoUring)
+                {
+                    throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+                }
+            }
+#else
+            if(backend == AsyncBackend::IoUring)
+            {
+                throw std::system_error(ENOSYS, std::generic_category(), "io_uring_setup");
+            }
+#endif
+            m_pool = std::make_unique<ThreadPool>(worker_count);
+        }
+
+        AsyncIoEngine(const AsyncIoEngine&) = delete;
+        AsyncIoEngine& operator=(const AsyncIoEngine&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Submits and waits for every outstanding operation, then tears down the backend.
+        */
+        ~AsyncIoEngine() noexcept
+        {
+            drain();
+
+#ifdef FILE_HAS_IO_URING
+            if(m_backend == AsyncBackend::IoUring)
+            {
+                {
+                    // a NOP with user_data 0 tells the completion thread to exit,
+                    // unless a broken ring already made it exit. If the kernel
+                    // refuses the NOP, the thread sees m_stop on its next timed wake.
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    if(m_ring_error == 0)
+                    {
+                        io_uring_sqe* sqe = next_sqe();
+                        sqe->opcode = IORING_OP_NOP;
+                        sqe->user_data = 0;
+                        ++m_pending;
+                        if(submit_locked(lock) == 0)
+                        {
+                            m_ring_error = ECANCELED;
+                            m_stop.store(true, std::memory_order_release);
+                        }
+                    }
+                }
+                m_reaper.join();
+                teardown_ring();
+            }
+#endif
+            m_pool.reset();
+        }
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Adds a positional read to the current batch.
+        *
+        * @param[in]   fd: descriptor to read from.
+        * @param[in]   offset: byte offset to read at.
+        * @param[out]  buffer: destination, must stay valid until the callback ran.
+        * @param[in]   len: number of bytes to read.
+        * @param[in]   callback: receives bytes read or -errno.
+        */
+        void prepare_read(int fd, int64_t offset, void* buffer, size_t len, AsyncCallback callback)
+        {
+            prepare(fd, offset, buffer, len, false, std::move(callback));
+        }
+
+        /***
+        * @brief       Adds a positional write to the current batch.
+        *
+        * @param[in]   fd: descriptor to write to.
+        * @param[in]   offset: byte offset to write at.
+        * @param[in]   buffer: source, must stay valid until the callback ran.
+        * @param[in]   len: number of bytes to write.
+        * @param[in]   callback: receives bytes written or -errno.
+        */
+        void prepare_write(int fd, int64_t offset, const void* buffer, size_t len, AsyncCallback callback)
+        {
+            prepare(fd, offset, const_cast<void*>(buffer), len, true, std::move(callback));
+        }
+
+        /***
+        * @brief   Hands the current batch to the backend.
+        *
+        * @details Operations the kernel refuses complete with -errno instead.
+        *
+        * @return  number of operations submitted.
+        */
+        unsigned submit()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return submit_locked(lock);
+        }
+
+        /***
+        * @brief   Submits the current batch and waits until no operation is outstanding.
+        */
+        void drain()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            submit_locked(lock);
+            m_cv.wait(lock, [this] { return m_outstanding == 0; });
+        }
+
+
+
+        //==================== GETTER FUNCTIONS ====================
+        /***
+        * @brief   To get the backend in use, never Auto.
+        */
+        AsyncBackend backend() const
+        {
+            return m_backend;
+        }
+
+        /***
+        * @brief   To get the maximum number of outstanding operations.
+        */
+        unsigned queue_depth() const
+        {
+            return m_queue_depth;
+        }
+
+    private:
+        /***
+        * @brief   Queues one operation, waiting for queue space if needed.
+        */
+        void prepare(int fd, int64_t offset, void* buffer, size_t len, bool is_write, AsyncCallback callback)
+        {
+            Operation* op = new Operation{{buffer, len}, fd, offset, is_write, std::move(callback)};
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_outstanding >= m_queue_depth)
+            {
+                submit_locked(lock); // a full queue of unsubmitted work would never drain
+                m_cv.wait(lock);
+            }
+
+#ifdef FILE_HAS_IO_URING
+            if(m_backend == AsyncBackend::IoUring)
+            {
+                if(m_ring_error != 0)
+                {
+                    int error = m_ring_error;
+                    lock.unlock();
+                    if(op->callback)
+                    {
+                        op->callback(-static_cast<int64_t>(error));
+                    }
+                    delete op;
+                    return;
+                }
+                ++m_outstanding;
+                ++m_pending;
+                op->next = m_in_flight;
+                if(m_in_flight)
+                {
+                    m_in_flight->prev = op;
+                }
+                m_in_flight = op;
+                queue_sqe(op);
+                return;
+            }
+#endif
+            ++m_outstanding;
+            ++m_pending;
+            m_batch.push_back([this, op] {
+                errno = 0;
+                size_t done = op->is_write
+                    ? file_detail::pwrite_full(op->fd, op->iov.iov_base, op->iov.iov_len, op->offset)
+                    : file_detail::pread_full(op->fd, op->iov.iov_base, op->iov.iov_len, op->offset);
+                int64_t result = (done == 0 && errno != 0) ? -static_cast<int64_t>(errno) : static_cast<int64_t>(done);
+                complete(op, result);
+            });
+        }
+
+        /***
+        * @brief   Publishes prepared operations, lock must hold m_mutex.
+        *
+        * @details Never throws: when io_uring_enter fails with anything but a
+        *          transient error, the entries the kernel did not consume are
+        *          taken back off the ring and their operations complete with
+        *          -errno, with lock released while the callbacks run.
+        *
+        * @return  number of operations the backend accepted.
+        */
+        unsigned submit_locked(std::unique_lock<std::mutex>& lock)
+        {
+            unsigned count = m_pending;
+            if(count == 0)
+            {
+                return 0;
+            }
+
+#ifdef FILE_HAS_IO_URING
+            if(m_backend == AsyncBackend::IoUring)
+            {
+                unsigned accepted = 0;
+                while(m_pending > 0)
+                {
+                    // published on every pass, entries may be prepared while the lock is released below
+                    std::atomic_ref<unsigned>(*m_sq_tail).store(m_sq_local_tail, std::memory_order_release);
+                    int ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring_fd, m_pending, 0, 0, NULL, 0));
+                    if(ret < 0)
+                    {
+                        if(errno == EINTR || errno == EAGAIN || errno == EBUSY)
+                        {
+                            // the completion thread needs m_mutex to make room
+                            lock.unlock();
+                            std::this_thread::yield();
+                            lock.lock();
+                            continue;
+                        }
+                        fail_operations(take_unsubmitted(), errno, lock);
+                        return accepted;
+                    }
+                    m_pending -= static_cast<unsigned>(ret);
+                    accepted += static_cast<unsigned>(ret);
+                }
+                return accepted;
+            }
+#else
+            (void)lock;
+#endif
+            m_pending = 0;
+            m_pool->post(m_batch);
+            return count;
+        }
+
+        /***
+        * @brief   Runs the callback of a finished operation and frees its queue slot.
+        */
+        void complete(Operation* op, int64_t result)
+        {
+            if(op->callback)
+            {
+                op->callback(result);
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                unlink(op);
+                --m_outstanding;
+            }
+            delete op;
+            m_cv.notify_all();
+        }
+
+        /***
+        * @brief   Completes operations the backend never ran with -error, lock must hold m_mutex.
+        *
+        * @details An operation that already transferred part of its buffer
+        *          reports those bytes instead, as a short transfer would.
+        */
+        void fail_operations(std::vector<Operation*> ops, int error, std::unique_lock<std::mutex>& lock)
+        {
+            if(ops.empty())
+            {
+                return;
+            }
+            for(Operation* op : ops)
+            {
+                unlink(op);
+            }
+            lock.unlock();
+            for(Operation* op : ops)
+            {
+                if(op->callback)
+                {
+                    op->callback(op->done > 0 ? op->done : -static_cast<int64_t>(error));
+                }
+                delete op;
+            }
+            lock.lock();
+            m_outstanding -= static_cast<unsigned>(ops.size());
+            m_cv.notify_all();
+        }
+
+        /***
+        * @brief   Removes op from the list of ring operations, m_mutex must be held.
+        */
+        void unlink(Operation* op)
+        {
+#ifdef FILE_HAS_IO_URING
+            if(op->prev)
+            {
+                op->prev->next = op->next;
+            }
+            else if(m_in_flight == op)
+            {
+                m_in_flight = op->next;
+            }
+            if(op->next)
+            {
+                op->next->prev = op->prev;
+            }
+            op->prev = op->next = NULL;
+#else
+            (void)op;
+#endif
+        }
+
+#ifdef FILE_HAS_IO_URING
+        /***
+        * @brief   Creates the ring and maps its queues.
+        *
+        * @return  true on success otherwise false with errno set.
+        */
+        bool setup_ring()
+        {
+            struct io_uring_params params;
+            memset(&params, 0, sizeof(params));
+            int fd = static_cast<int>(syscall(__NR_io_uring_setup, m_queue_depth, &params));
+            if(fd < 0)
+            {
+                return false;
+            }
+            m_ring_fd = fd;
+
+            m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+            m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+            if(single_mmap)
+            {
+                m_sq_ring_size = m_cq_ring_size = std::max(m_sq_ring_size, m_cq_ring_size);
+            }
+
+            m_sq_ring = mmap(NULL, m_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+            if(m_sq_ring == MAP_FAILED)
+            {
+                m_sq_ring = NULL;
+                teardown_ring();
+                return false;
+            }
+            m_cq_ring = single_mmap ? m_sq_ring
+                                    : mmap(NULL, m_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if(m_cq_ring == MAP_FAILED)
+            {
+                m_cq_ring = NULL;
+                teardown_ring();
+                return false;
+            }
+            m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = mmap(NULL, m_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+            if(sqes == MAP_FAILED)
+            {
+                teardown_ring();
+                return false;
+            }
+            m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+            char* sq = static_cast<char*>(m_sq_ring);
+            m_sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+            m_sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+            m_sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+            m_sq_local_tail = *m_sq_tail;
+
+            char* cq = static_cast<char*>(m_cq_ring);
+            m_cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+            m_cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+            m_cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+            m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+#ifdef IORING_FEAT_EXT_ARG
+            m_timed_wait = (params.features & IORING_FEAT_EXT_ARG) != 0;
+#endif
+
+            // the kernel may round the depth up, never outrun the real ring
+            if(params.sq_entries < m_queue_depth)
+            {
+                m_queue_depth = params.sq_entries;
+            }
+            return true;
+        }
+
+        /***
+        * @brief   Unmaps the queues and closes the ring.
+        */
+        void teardown_ring()
+        {
+            int saved_errno = errno;
+            if(m_sqes)
+            {
+                munmap(m_sqes, m_sqes_size);
+                m_sqes = NULL;
+            }
+            if(m_cq_ring && m_cq_ring != m_sq_ring)
+            {
+                munmap(m_cq_ring, m_cq_ring_size);
+            }
+            m_cq_ring = NULL;
+            if(m_sq_ring)
+            {
+                munmap(m_sq_ring, m_sq_ring_size);
+                m_sq_ring = NULL;
+            }
+            if(m_ring_fd >= 0)
+            {
+                ::close(m_ring_fd);
+                m_ring_fd = -1;
+            }
+            errno = saved_errno;
+        }
+
+        /***
+        * @brief   Claims the next submission entry, m_mutex must be held.
+        *
+        * @details Entries are free because outstanding operations never exceed
+        *          the ring size and the kernel consumes them on io_uring_enter.
+        */
+        io_uring_sqe* next_sqe()
+        {
+            unsigned index = m_sq_local_tail & *m_sq_mask;
+            io_uring_sqe* sqe = &m_sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            m_sq_array[index] = index;
+            ++m_sq_local_tail;
+            return sqe;
+        }
+
+        /***
+        * @brief   Fills the next submission entry with the rest of op, m_mutex must be held.
+        */
+        void queue_sqe(Operation* op)
+        {
+            io_uring_sqe* sqe = next_sqe();
+            sqe->opcode = op->is_write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe->fd = op->fd;
+            sqe->off = static_cast<uint64_t>(op->offset);
+            sqe->addr = reinterpret_cast<uint64_t>(&op->iov);
+            sqe->len = 1;
+            sqe->user_data = reinterpret_cast<uint64_t>(op);
+        }
+
+        /***
+        * @brief   Takes the entries the kernel has not consumed back off the ring, m_mutex must be held.
+        *
+        * @details Without SQPOLL the kernel only reads the ring inside
+        *          io_uring_enter, so moving the tail back is safe here.
+        *
+        * @return  operations of the withdrawn entries.
+        */
+        std::vector<Operation*> take_unsubmitted()
+        {
+            std::vector<Operation*> ops;
+            unsigned first = m_sq_local_tail - m_pending;
+            for(unsigned i = first; i != m_sq_local_tail; ++i)
+            {
+                Operation* op = reinterpret_cast<Operation*>(m_sqes[m_sq_array[i & *m_sq_mask]].user_data);
+                if(op)
+                {
+                    ops.push_back(op);
+                }
+            }
+            m_sq_local_tail = first;
+            m_pending = 0;
+            std::atomic_ref<unsigned>(*m_sq_tail).store(first, std::memory_order_release);
+            return ops;
+        }
+
+        /***
+        * @brief   Handles one completion, resubmitting the rest of a short transfer.
+        */
+        void finish(Operation* op, int64_t result)
+        {
+            if(result > 0 && static_cast<size_t>(result) < op->iov.iov_len)
+            {
+                op->done += result;
+                op->offset += result;
+                op->iov.iov_base = static_cast<char*>(op->iov.iov_base) + result;
+                op->iov.iov_len -= static_cast<size_t>(result);
+
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if(m_ring_error == 0)
+                {
+                    queue_sqe(op);
+                    ++m_pending;
+                    submit_locked(lock); // reports a refusal through the callback
+                    return;
+                }
+                lock.unlock();
+                complete(op, op->done);
+                return;
+            }
+            // end of file or an error after a partial transfer reports what was done
+            complete(op, (op->done > 0 && result <= 0) ? op->done : op->done + result);
+        }
+
+        /***
+        * @brief   Completes every ring operation with -error and marks the ring unusable.
+        */
+        void fail_ring(int error)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_ring_error = error;
+            take_unsubmitted();
+            std::vector<Operation*> ops;
+            for(Operation* op = m_in_flight; op; op = op->next)
+            {
+                ops.push_back(op);
+            }
+            fail_operations(std::move(ops), error, lock);
+        }
+
+        /***
+        * @brief   Completion thread, runs until it sees the shutdown NOP.
+        *
+        * @details If io_uring_enter fails for good the completions can never
+        *          arrive, so every ring operation fails with its errno rather
+        *          than leaving drain() and the destructor waiting forever.
+        *          Where the kernel supports it the wait times out every 100 ms,
+        *          so m_stop is seen even without a completion (Linux 5.11+).
+        */
+        void reap()
+        {
+            for(;;)
+            {
+                int ret;
+#ifdef IORING_ENTER_EXT_ARG
+                if(m_timed_wait)
+                {
+                    struct __kernel_timespec timeout = {0, 100 * 1000 * 1000};
+                    struct io_uring_getevents_arg arg;
+                    memset(&arg, 0, sizeof(arg));
+                    arg.ts = reinterpret_cast<uint64_t>(&timeout);
+                    ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring_fd, 0, 1,
+                                                   IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg)));
+                }
+                else
+#endif
+                {
+                    ret = static_cast<int>(syscall(__NR_io_uring_enter, m_ring_fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0));
+                }
+                if(ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY && errno != ETIME)
+                {
+                    fail_ring(errno);
+                    return;
+                }
+
+                bool stop = false;
+                unsigned head = *m_cq_head; // only this thread writes the head
+                unsigned tail = std::atomic_ref<unsigned>(*m_cq_tail).load(std::memory_order_acquire);
+                while(head != tail)
+                {
+                    const io_uring_cqe& cqe = m_cqes[head & *m_cq_mask];
+                    Operation* op = reinterpret_cast<Operation*>(cqe.user_data);
+                    int64_t result = cqe.res;
+                    ++head;
+                    std::atomic_ref<unsigned>(*m_cq_head).store(head, std::memory_order_release);
+
+                    if(op)
+                    {
+                        finish(op, result);
+                    }
+                    else
+                    {
+                        stop = true;
+                    }
+                }
+                if(stop || m_stop.load(std::memory_order_acquire))
+                {
+                    return;
+                }
+            }
+        }
+#endif
+};
+
+
+
+//==================== AsyncFile Class ====================
+// Asynchronous positional reads and writes on an open File. The File must
+// stay open, and buffers must stay valid, until the operations completed.
+class AsyncFile
+{
+    private:
+        int m_fd;                 // descriptor of the File
+        AsyncIoEngine& m_engine;  // engine the operations are queued on
+
+    public:
+        /***
+        * @brief       Binds file to engine.
+        *
+        * @details     Pending buffered output of file is flushed so asynchronous
+        *              reads see it.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename ThreadingPolicy>
+        AsyncFile(BasicFile<ThreadingPolicy>& file, AsyncIoEngine& engine)
+            : m_fd(file.get_descriptor()), m_engine(engine)
+        {
+            file.flush();
+        }
+
+        /***
+        * @brief       Queues a read, the callback receives bytes read or -errno.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        void async_read(int64_t offset, std::span<T, Extent> items, AsyncCallback callback)
+        {
+            m_engine.prepare_read(m_fd, offset, items.data(), items.size_bytes(), std::move(callback));
+        }
+
+        /***
+        * @brief       Queues a write, the callback receives bytes written or -errno.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        void async_write(int64_t offset, std::span<T, Extent> items, AsyncCallback callback)
+        {
+            m_engine.prepare_write(m_fd, offset, items.data(), items.size_bytes(), std::move(callback));
+        }
+
+        /***
+        * @brief       Queues a read.
+        *
+        * @return      future of the bytes read, holding std::system_error on failure.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        std::future<size_t> async_read(int64_t offset, std::span<T, Extent> items)
+        {
+            auto promise = std::make_shared<std::promise<size_t>>();
+            std::future<size_t> future = promise->get_future();
+            async_read(offset, items, [promise](int64_t result) { fulfil(*promise, result); });
+            return future;
+        }
+
+        /***
+        * @brief       Queues a write.
+        *
+        * @return      future of the bytes written, holding std::system_error on failure.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        std::future<size_t> async_write(int64_t offset, std::span<T, Extent> items)
+        {
+            auto promise = std::make_shared<std::promise<size_t>>();
+            std::future<size_t> future = promise->get_future();
+            async_write(offset, items, [promise](int64_t result) { fulfil(*promise, result); });
+            return future;
+        }
+
+        /***
+        * @brief   Hands the queued operations to the engine's backend.
+        */
+        unsigned submit()
+        {
+            return m_engine.submit();
+        }
+
+    private:
+        static void fulfil(std::promise<size_t>& promise, int64_t result)
+        {
+            if(result < 0)
+            {
+                promise.set_exception(std::make_exception_ptr(
+                    std::system_error(static_cast<int>(-result), std::generic_category(), "async file operation")));
+            }
+            else
+            {
+                promise.set_value(static_cast<size_t>(result));
+            }
+        }
+};
+
+
+#endif  // _ASYNC_FILE_H
@@ -0,0 +1,251 @@
+#ifndef _ATOMIC_FILE_H
+#define _ATOMIC_FILE_H
+
+// Header inclusion
+#include "file.h"         // for File, FileResult and the descriptor helpers
+#include <atomic>         // for unique temporary names
+#include <optional>       // for the File, empty once committed or aborted
+#include <string>         // for paths
+#include <fcntl.h>        // for O_TMPFILE, linkat
+#include <stdio.h>        // for rename
+#include <sys/stat.h>     // for fchmod
+#include <unistd.h>       // for getpid, unlink
+
+
+
+//==================== AtomicFileWriter Class ====================
+// Replaces a file so that readers see either the old or the new contents,
+// never a mix. Data goes to an unnamed O_TMPFILE inode in the target's
+// directory, or to a hidden mkstemp file there where O_TMPFILE is not
+// available. commit() syncs it and publishes it with one metadata
+// operation: linkat when the target does not exist yet, rename over it
+// otherwise, then syncs the directory. No copy of the data is made.
+// Destroying an uncommitted writer discards the new contents. POSIX only.
+class AtomicFileWriter
+{
+    private:
+        std::string m_target;      // name the contents are published under
+        std::string m_temp_name;   // name of the mkstemp file, empty for O_TMPFILE
+        std::optional<File> m_file; // new contents, open until commit() or abort()
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Starts writing a new version of target.
+        *
+        * @details     target itself is not touched until commit().
+        *
+        * @param[in]   target: file to replace or create.
+        * @param[in]   permissions: mode bits of the new file, applied with fchmod
+        *              so the umask does not change them.
+        *
+        * @throws      error_opning_file: If no temporary file can be created next to target.
+        */
+        explicit AtomicFileWriter(const std::string& target, mode_t permissions = 0644) : m_target(target)
+        {
+            std::string directory = file_detail::parent_directory(m_target);
+            int fd = -1;
+#if defined(O_TMPFILE)
+            fd = ::open(directory.c_str(), O_TMPFILE | O_RDWR | O_CLOEXEC, permissions);
+#endif
+            if(fd < 0)
+            {
+                // No O_TMPFILE on this system or file system, use a named temporary file
+                std::string pattern = temp_prefix() + "XXXXXX";
+                fd = ::mkstemp(pattern.data());
+                if(fd >= 0)
+                {
+                    m_temp_name = pattern;
+                }
+            }
+            if(fd < 0 || ::fchmod(fd, permissions) != 0)
+            {
+                FileError error = FileError::from_errno();
+                discard_descriptor(fd);
+                throw error_opning_file("Error: Failed to create a temporary file for \"" + m_target + "\" - Reason: " + error.message());
+            }
+
+            FileResult<File> file = File::try_from_descriptor(fd, "w+b", m_temp_name.empty() ? m_target : m_temp_name);
+            if(!file)
+            {
+                discard_name();
+                throw error_opning_file("Error: Failed to create a temporary file for \"" + m_target + "\" - Reason: " + file.error().message());
+            }
+            m_file.emplace(std::move(*file));
+        }
+
+        AtomicFileWriter(const AtomicFileWriter&) = delete;
+        AtomicFileWriter& operator=(const AtomicFileWriter&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Discards the new contents unless they were committed.
+        */
+        ~AtomicFileWriter() noexcept
+        {
+            abort();
+        }
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       To get the File receiving the new contents.
+        *
+        * @throws      bad_file_discriptor: If the writer was already committed or aborted.
+        */
+        File& file()
+        {
+            if(!m_file)
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+            return *m_file;
+        }
+
+        /***
+        * @brief       Makes the new contents durable and publishes them under the target name.
+        *
+        * @details     Afterwards the writer is closed. On failure the target keeps its
+        *              previous contents and the new ones are discarded.
+        *
+        * @return      returns true on success otherwise false.
+        */
+        bool commit()
+        {
+            return try_commit().has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of commit() that keeps the errno.
+        *
+        * @return      nothing on success otherwise the errno of the failed step,
+        *              EBADF if the writer was already committed or aborted.
+        */
+        FileResult<void> try_commit(std::source_location location = std::source_location::current())
+        {
+            if(!m_file)
+            {
+                return FileError(EBADF, location);
+            }
+
+            FileResult<void> synced = m_file->try_sync_all(location);
+            if(!synced)
+            {
+                abort();
+                return synced;
+            }
+
+            int ret = 0;
+            if(m_temp_name.empty())
+            {
+                // Give the O_TMPFILE inode a name: directly the target if it is free
+                std::string proc_path = "/proc/self/fd/" + std::to_string(m_file->get_descriptor());
+                ret = ::linkat(AT_FDCWD, proc_path.c_str(), AT_FDCWD, m_target.c_str(), AT_SYMLINK_FOLLOW);
+                if(ret != 0 && errno == EEXIST)
+                {
+                    ret = link_to_temp_name(proc_path);
+                }
+            }
+            if(ret == 0 && !m_temp_name.empty())
+            {
+                ret = ::rename(m_temp_name.c_str(), m_target.c_str());
+            }
+            if(ret != 0)
+            {
+                FileError error = FileError::from_errno(location);
+                abort();
+                return error;
+            }
+
+            m_temp_name.clear(); // published, nothing left to remove
+            m_file.reset();
+            if(file_detail::sync_parent_directory(m_target) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+        }
+
+        /***
+        * @brief       Discards the new contents, the target is left as it was.
+        */
+        void abort() noexcept
+        {
+            m_file.reset();
+            discard_name();
+        }
+
+        /***
+        * @brief   To check whether the new contents live in an unnamed O_TMPFILE inode.
+        */
+        bool uses_tmpfile() const
+        {
+            return m_file.has_value() && m_temp_name.empty();
+        }
+
+    private:
+        // Hidden name prefix next to the target, e.g. dir/.config.json.tmp.
+        std::string temp_prefix() const
+        {
+            std::string directory = file_detail::parent_directory(m_target);
+            size_t slash = m_target.find_last_of('/');
+            std::string base = (slash == std::string::npos) ? m_target : m_target.substr(slash + 1);
+            return directory + "/." + base + ".tmp.";
+        }
+
+        /***
+        * @brief       Links the O_TMPFILE inode under a fresh temporary name for rename().
+        *
+        * @return      0 on success otherwise -1 with errno set.
+        */
+        int link_to_temp_name(const std::string& proc_path)
+        {
+            static std::atomic<unsigned> counter(0);
+            for(int attempt = 0; attempt < 100; ++attempt)
+            {
+                std::string name = temp_prefix() + std::to_string(::getpid()) + "." + std::to_string(counter.fetch_add(1));
+                if(::linkat(AT_FDCWD, proc_path.c_str(), AT_FDCWD, name.c_str(), AT_SYMLINK_FOLLOW) == 0)
+                {
+                    m_temp_name = name;
+                    return 0;
+                }
+                if(errno != EEXIST)
+                {
+                    return -1;
+                }
+            }
+            return -1;
+        }
+
+        // Removes the temporary name, if any
+        void discard_name() noexcept
+        {
+            if(!m_temp_name.empty())
+            {
+                ::unlink(m_temp_name.c_str());
+                m_temp_name.clear();
+            }
+        }
+
+        // Closes fd and removes the temporary name after a failed construction
+        void discard_descriptor(int fd) noexcept
+        {
+            if(fd >= 0)
+            {
+                ::close(fd);
+            }
+            discard_name();
+        }
+
+        [[noreturn]] FILE_COLD_NOINLINE static void throw_bad_file_discriptor(const char* function, int line)
+        {
+            throw bad_file_discriptor("Error: AtomicFileWriter was already committed or aborted. Line[" + std::to_string(line) +
+                                      "], Function[" + function + "], File[" + __FILE__ + "]");
+        }
+};
+
+
+#endif  // _ATOMIC_FILE_H
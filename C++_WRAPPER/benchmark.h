@@ -0,0 +1,73 @@
+#ifndef _BENCHMARK_H
+#define _BENCHMARK_H
+
+// Header inclusion
+#include <chrono>    // for steady_clock timing
+#include <cstdio>    // for printing results
+#include <cstdint>   // for uint64_t
+
+
+
+// Helpers shared by the benchmark_*.cpp programs.
+
+/***
+* @brief       Runs fn repeat times and keeps the fastest run.
+*
+* @details     The fastest run is the least disturbed by other processes,
+*              page cache misses and frequency scaling.
+* 
+* @param[in]   repeat: number of timed runs.
+* @param[in]   fn: callable to time.
+*
+* @return      best wall clock time in nanoseconds.
+*/
+template <typename Fn>
+double best_of(int repeat, Fn&& fn)
+{
+    double best = 0.0;
+    for(int i = 0; i < repeat; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        auto stop = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        if(i == 0 || ns < best)
+        {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+/***
+* @brief       Prints one result row.
+* 
+* @param[in]   name: label of the measurement.
+* @param[in]   ns: total time of the run in nanoseconds.
+* @param[in]   ops: number of operations done by the run.
+* @param[in]   bytes: number of bytes moved by the run, 0 to skip the MB/s column.
+*/
+inline void report(const char* name, double ns, double ops, double bytes = 0.0)
+{
+    printf("%-40s %10.2f ns/op %12.2f Mop/s", name, ns / ops, ops * 1e3 / ns);
+    if(bytes > 0.0)
+    {
+        printf(" %10.1f MB/s", bytes * 1e3 / ns);
+    }
+    printf("\n");
+}
+
+// Written by keep_result(), never read
+inline volatile uint64_t benchmark_sink;
+
+/***
+* @brief       Keeps the optimizer from removing a computation whose result is unused.
+*/
+inline void keep_result(uint64_t value)
+{
+    benchmark_sink = value;
+}
+
+
+#endif  // _BENCHMARK_H
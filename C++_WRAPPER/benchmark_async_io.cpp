@@ -0,0 +1,99 @@
+#include "file.h"
+#include "async_file.h"
+#include "benchmark.h"
+#include <random>
+#include <vector>
+
+// Random 4 KiB reads through the synchronous read()/read_at() calls and
+// through AsyncIoEngine at queue depths 1 to 128, for both backends. The
+// test file is small enough to sit in the page cache, so the numbers show
+// submission overhead; point filename at a cold file on NVMe (or drop the
+// page cache first) to see device queue depth at work.
+
+const size_t block_size = 4096;
+const size_t file_size = 64 * 1024 * 1024;
+const size_t read_count = 32 * 1024;
+const int repeat = 3;
+
+int main(int argc, char* argv[])
+{
+    const char* filename = argc > 1 ? argv[1] : "benchmark_async_io.tmp";
+
+    {
+        File writer(filename, "wb", BufferMode::Full, 1024 * 1024);
+        std::vector<char> block(block_size, 'x');
+        for(size_t done = 0; done < file_size; done += block_size)
+        {
+            writer.write(std::span(block));
+        }
+    }
+
+    std::mt19937_64 rng(42);
+    std::vector<int64_t> offsets(read_count);
+    for(int64_t& offset : offsets)
+    {
+        offset = static_cast<int64_t>(rng() % (file_size / block_size) * block_size);
+    }
+
+    File fp(filename, "rb");
+    std::vector<char> buffer(block_size);
+    printf("%zu random %zu byte reads per run, best of %d\n\n", read_count, block_size, repeat);
+
+    double ns = best_of(repeat, [&] {
+        for(int64_t offset : offsets)
+        {
+            fp.seek(static_cast<long>(offset), SeekOrigin::Set);
+            fp.read(buffer.data(), 1, block_size);
+        }
+    });
+    report("sync seek+read", ns, read_count, read_count * block_size);
+
+    ns = best_of(repeat, [&] {
+        for(int64_t offset : offsets)
+        {
+            fp.read_at(offset, std::span(buffer));
+        }
+    });
+    report("sync read_at", ns, read_count, read_count * block_size);
+
+    const AsyncBackend backends[] = {AsyncBackend::IoUring, AsyncBackend::ThreadPool};
+    for(AsyncBackend backend : backends)
+    {
+        for(unsigned depth = 1; depth <= 128; depth *= 2)
+        {
+            std::unique_ptr<AsyncIoEngine> engine;
+            try
+            {
+                engine = std::make_unique<AsyncIoEngine>(depth, backend, std::min(depth, 64u));
+            }
+            catch(const std::system_error&)
+            {
+                printf("io_uring not available, skipped\n");
+                break;
+            }
+            AsyncFile async_fp(fp, *engine);
+            std::vector<char> buffers(static_cast<size_t>(depth) * block_size);
+
+            ns = best_of(repeat, [&] {
+                for(size_t i = 0; i < read_count; i += depth)
+                {
+                    for(size_t slot = 0; slot < depth && i + slot < read_count; ++slot)
+                    {
+                        async_fp.async_read(offsets[i + slot], std::span(buffers.data() + slot * block_size, block_size),
+                                            AsyncCallback());
+                    }
+                    engine->drain();
+                }
+            });
+
+            char name[64];
+            snprintf(name, sizeof(name), "async %s qd=%u", backend == AsyncBackend::IoUring ? "io_uring" : "pool", depth);
+            report(name, ns, read_count, read_count * block_size);
+        }
+    }
+
+    fp.close();
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,140 @@
+#include "file.h"
+#include "benchmark.h"
+#include <vector>
+
+// Newline kernels on an in-memory buffer (scalar, SSE2, AVX2 and the
+// dispatched choice against a byte loop and memchr), then line counting on
+// a file: fgets and lines() against count_lines().
+
+const size_t buffer_size = 64 << 20;
+const size_t line_count = 4000000;
+const int repeat = 5;
+
+int main(void)
+{
+    std::vector<char> data(buffer_size);
+    size_t newline_count = 0;
+    for(size_t i = 0; i < buffer_size; ++i)
+    {
+        data[i] = (i * 2654435761u) % 61 == 0 ? '\n' : static_cast<char>('a' + i % 26); // about one line per 61 bytes
+        newline_count += data[i] == '\n';
+    }
+    const double bytes = static_cast<double>(buffer_size);
+
+    printf("%zu MiB buffer, %zu newlines, dispatched kernels: %s, best of %d\n\n",
+           buffer_size >> 20, newline_count, file_detail::byte_scan_kernels().name, repeat);
+
+    double ns = best_of(repeat, [&] {
+        size_t count = 0;
+        for(size_t i = 0; i < buffer_size; ++i)
+        {
+            count += data[i] == '\n';
+        }
+        keep_result(count);
+    });
+    report("count: byte loop", ns, bytes, bytes);
+
+    ns = best_of(repeat, [&] {
+        size_t count = 0;
+        const char* pos = data.data();
+        const char* end = pos + buffer_size;
+        while((pos = static_cast<const char*>(memchr(pos, '\n', static_cast<size_t>(end - pos)))) != NULL)
+        {
+            ++count;
+            ++pos;
+        }
+        keep_result(count);
+    });
+    report("count: memchr loop", ns, bytes, bytes);
+
+    struct { const char* name; size_t (*count)(const char*, size_t, char); } counters[] = {
+        {"count: scalar kernel", file_detail::count_byte_scalar},
+#if defined(__x86_64__) || defined(_M_X64)
+        {"count: sse2 kernel", file_detail::count_byte_sse2},
+#endif
+        {"count: dispatched", file_detail::count_byte},
+    };
+    for(const auto& counter : counters)
+    {
+        ns = best_of(repeat, [&] {
+            keep_result(counter.count(data.data(), buffer_size, '\n'));
+        });
+        report(counter.name, ns, bytes, bytes);
+    }
+
+    // glibc's memchr is what find_byte dispatches to there; these rows show why
+    struct { const char* name; const char* (*find)(const char*, size_t, char); } finders[] = {
+        {"split: memchr loop", file_detail::find_byte_scalar},
+#if defined(__x86_64__) || defined(_M_X64)
+        {"split: sse2 find loop", file_detail::find_byte_sse2},
+#endif
+#if defined(FILE_HAS_AVX2_DISPATCH)
+        {"split: avx2 find loop", file_detail::find_byte_avx2},
+#endif
+        {"split: find_byte loop", file_detail::find_byte},
+    };
+    for(const auto& finder : finders)
+    {
+        ns = best_of(repeat, [&] {
+            size_t count = 0;
+            const char* pos = data.data();
+            const char* end = pos + buffer_size;
+            while((pos = finder.find(pos, static_cast<size_t>(end - pos), '\n')) != NULL)
+            {
+                ++count;
+                ++pos;
+            }
+            keep_result(count);
+        });
+        report(finder.name, ns, bytes, bytes);
+    }
+
+    const char* filename = "benchmark_byte_scan.tmp";
+    {
+        File fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.print("{},sensor_{},{}\n", i, i % 16, (i * 2654435761u) % 100000);
+        }
+    }
+    double file_bytes = 0.0;
+    {
+        File fp(filename, "rb");
+        fp.seek(0, SeekOrigin::End);
+        file_bytes = static_cast<double>(fp.tell());
+    }
+    printf("\n%zu lines (%.1f MB) file\n\n", line_count, file_bytes / 1e6);
+
+    ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        char line[256];
+        size_t count = 0;
+        while(fp.getstring(line, sizeof(line)))
+        {
+            ++count;
+        }
+        keep_result(count);
+    });
+    report("fgets (getstring)", ns, line_count, file_bytes);
+
+    ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        size_t count = 0;
+        for(std::string_view line : fp.lines())
+        {
+            count += !line.empty() || true;
+        }
+        keep_result(count);
+    });
+    report("lines()", ns, line_count, file_bytes);
+
+    ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        keep_result(fp.count_lines());
+    });
+    report("count_lines()", ns, line_count, file_bytes);
+
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,91 @@
+#include "file.h"
+#include "concurrent_appender.h"
+#include "benchmark.h"
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Many threads appending 128 byte records to one file: File::write on the
+// shared stream (stdio lock), pwrite at an offset taken under a mutex, and
+// ConcurrentAppender reserving offsets with an atomic fetch-add. Scaling
+// shows with as many cores as writers.
+
+const size_t record_count = 1 << 19; // split between the writers
+const size_t record_size = 128;
+const int repeat = 3;
+
+enum class Method
+{
+    FileWrite,
+    MutexPwrite,
+    Appender
+};
+
+/***
+* @brief       Times thread_count writers appending record_count records in total with method.
+*/
+double run_writers(const char* filename, unsigned thread_count, Method method)
+{
+    return best_of(repeat, [&] {
+        File fp(filename, "wb");
+        ConcurrentAppender appender(fp);
+        std::mutex mutex;
+        int64_t offset = 0;
+        std::vector<std::thread> writers;
+        for(unsigned t = 0; t < thread_count; ++t)
+        {
+            writers.emplace_back([&, t] {
+                char record[record_size];
+                memset(record, 'a' + static_cast<int>(t % 26), sizeof(record));
+                record[sizeof(record) - 1] = '\n';
+                for(size_t i = 0; i < record_count / thread_count; ++i)
+                {
+                    if(method == Method::FileWrite)
+                    {
+                        fp.write(record, 1, sizeof(record));
+                    }
+                    else if(method == Method::MutexPwrite)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        fp.write_at(offset, std::span<const char>(record, sizeof(record)));
+                        offset += static_cast<int64_t>(sizeof(record));
+                    }
+                    else
+                    {
+                        appender.append(record, sizeof(record));
+                    }
+                }
+            });
+        }
+        for(std::thread& writer : writers)
+        {
+            writer.join();
+        }
+    });
+}
+
+int main(void)
+{
+    const char* filename = "benchmark_concurrent_append.tmp";
+    const unsigned thread_counts[] = {1, 4, 32};
+    const double bytes = static_cast<double>(record_count * record_size);
+
+    printf("%zu records of %zu bytes, %u hardware threads, best of %d\n\n", record_count, record_size,
+           std::thread::hardware_concurrency(), repeat);
+
+    for(unsigned thread_count : thread_counts)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "%2u writers  File::write", thread_count);
+        report(name, run_writers(filename, thread_count, Method::FileWrite), record_count, bytes);
+        snprintf(name, sizeof(name), "%2u writers  mutex + pwrite", thread_count);
+        report(name, run_writers(filename, thread_count, Method::MutexPwrite), record_count, bytes);
+        snprintf(name, sizeof(name), "%2u writers  ConcurrentAppender", thread_count);
+        report(name, run_writers(filename, thread_count, Method::Appender), record_count, bytes);
+        printf("\n");
+    }
+
+    std::remove(filename);
+
+    return(0);
+}
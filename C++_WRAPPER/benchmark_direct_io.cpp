@@ -0,0 +1,102 @@
+#include "file.h"
+#include "direct_file.h"
+#include "benchmark.h"
+#include <string>
+#include <vector>
+
+// Writing and reading back a 512 MiB export through File (page cache)
+// against DirectFile (O_DIRECT, and the fallback that drops the cache
+// behind it). Besides throughput it prints how much the page cache grew,
+// which is what other processes on the host pay for. Run it on a real disk.
+
+const size_t file_size = 512 << 20;
+const size_t chunk_size = 64 << 10;
+const int repeat = 2;
+
+/***
+* @brief       "Cached:" of /proc/meminfo in MiB, 0 where it does not exist.
+*/
+double cached_mib()
+{
+    File meminfo("/proc/meminfo", "r");
+    for(std::string_view line : meminfo.lines())
+    {
+        if(line.substr(0, 7) == "Cached:")
+        {
+            return std::stod(std::string(line.substr(7))) / 1024.0;
+        }
+    }
+    return 0.0;
+}
+
+int main(void)
+{
+    const std::string filename = "benchmark_direct_io.tmp";
+    std::vector<char> chunk(chunk_size);
+    for(size_t i = 0; i < chunk_size; ++i)
+    {
+        chunk[i] = static_cast<char>('a' + i % 26);
+    }
+
+    printf("%zu MiB file in %zu KiB writes, best of %d\n\n", file_size >> 20, chunk_size >> 10, repeat);
+
+    auto run = [&](const char* name, auto&& write_all, auto&& read_all) {
+        std::remove(filename.c_str());
+        double before = cached_mib();
+        double ns = best_of(repeat, write_all);
+        double grown = cached_mib() - before;
+        report(name, ns, 1, static_cast<double>(file_size));
+        printf("%-40s page cache grew by %.0f MiB\n", "", grown);
+
+        ns = best_of(repeat, read_all);
+        report("  read back", ns, 1, static_cast<double>(file_size));
+    };
+
+    run("File::write",
+        [&] {
+            File fp(filename, "wb", BufferMode::Full, 1 << 20);
+            for(size_t done = 0; done < file_size; done += chunk_size)
+            {
+                fp.write(chunk.data(), 1, chunk_size);
+            }
+            fp.sync_data();
+        },
+        [&] {
+            File fp(filename, "rb", BufferMode::Full, 1 << 20);
+            size_t total = 0;
+            while(size_t got = fp.read(chunk.data(), 1, chunk_size))
+            {
+                total += got;
+            }
+            keep_result(total);
+        });
+
+    for(DirectIo mode : {DirectIo::Auto, DirectIo::Fallback})
+    {
+        bool direct = false;
+        auto write_all = [&] {
+            DirectFile fp(filename, "w", mode);
+            direct = fp.is_direct();
+            for(size_t done = 0; done < file_size; done += chunk_size)
+            {
+                fp.write(chunk.data(), chunk_size);
+            }
+            fp.sync_data();
+        };
+        auto read_all = [&] {
+            DirectFile fp(filename, "r", mode);
+            size_t total = 0;
+            while(size_t got = fp.read(chunk.data(), chunk_size))
+            {
+                total += got;
+            }
+            keep_result(total);
+        };
+        write_all();
+        run(direct ? "DirectFile::write (O_DIRECT)" : "DirectFile::write (fallback)", write_all, read_all);
+    }
+
+    std::remove(filename.c_str());
+
+    return(0);
+}
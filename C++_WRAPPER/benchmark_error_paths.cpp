@@ -0,0 +1,78 @@
+#include "file.h"
+#include "benchmark.h"
+#include <string>
+
+// Cost of an expected failure, e.g. probing a cache file that is not there:
+// the throwing constructor against File::try_open(), and a closed-file read
+// through read() against try_read().
+
+const size_t probe_count = 100000;
+const int repeat = 5;
+
+int main(void)
+{
+    const std::string missing = "benchmark_error_paths.missing";
+    std::remove(missing.c_str());
+
+    printf("%zu probes per run, best of %d\n\n", probe_count, repeat);
+
+    double throwing = best_of(repeat, [&] {
+        uint64_t misses = 0;
+        for(size_t i = 0; i < probe_count; ++i)
+        {
+            try
+            {
+                File fp(missing, "rb");
+            }
+            catch(const error_opning_file&)
+            {
+                ++misses;
+            }
+        }
+        keep_result(misses);
+    });
+    double non_throwing = best_of(repeat, [&] {
+        uint64_t misses = 0;
+        for(size_t i = 0; i < probe_count; ++i)
+        {
+            FileResult<File> fp = File::try_open(missing, "rb");
+            misses += !fp;
+        }
+        keep_result(misses);
+    });
+    report("open miss  File(filename, mode)", throwing, probe_count);
+    report("open miss  File::try_open", non_throwing, probe_count);
+    printf("%-40s %10.2fx\n\n", "open miss  speedup", throwing / non_throwing);
+
+    File closed;
+    closed.close();
+    char byte;
+    throwing = best_of(repeat, [&] {
+        uint64_t failures = 0;
+        for(size_t i = 0; i < probe_count; ++i)
+        {
+            try
+            {
+                closed.read(&byte, 1, 1);
+            }
+            catch(const bad_file_discriptor&)
+            {
+                ++failures;
+            }
+        }
+        keep_result(failures);
+    });
+    non_throwing = best_of(repeat, [&] {
+        uint64_t failures = 0;
+        for(size_t i = 0; i < probe_count; ++i)
+        {
+            failures += !closed.try_read(&byte, 1, 1);
+        }
+        keep_result(failures);
+    });
+    report("closed     read()", throwing, probe_count);
+    report("closed     try_read()", non_throwing, probe_count);
+    printf("%-40s %10.2fx\n", "closed     speedup", throwing / non_throwing);
+
+    return(0);
+}
@@ -0,0 +1,111 @@
+#include "file.h"
+#include "benchmark.h"
+#include <vector>
+
+// Cost of the I/O statistics and the trace recorder per call. Build it once
+// per configuration and compare the rows:
+//
+//   g++ -std=c++20 -O2 -pthread -o benchmark_file_stats benchmark_file_stats.cpp
+//   g++ -std=c++20 -O2 -pthread -DFILE_ENABLE_STATS -o benchmark_file_stats_on benchmark_file_stats.cpp
+//   g++ -std=c++20 -O2 -pthread -DFILE_ENABLE_TRACE -o benchmark_file_trace_on benchmark_file_stats.cpp
+//
+// The instrumented builds also print what FileStatsRegistry collected, or
+// write the last events of the trace to benchmark_file_trace.json.
+
+const size_t call_count = 8 << 20;
+const size_t block_size = 64;
+const int repeat = 5;
+
+template <typename FileType>
+void run(const char* label, const char* filename)
+{
+    char name[64];
+    std::vector<char> block(block_size, 'b');
+
+    double ns = best_of(repeat, [&] {
+        FileType fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < call_count; ++i)
+        {
+            fp.putchar(static_cast<char>('a' + i % 26));
+        }
+    });
+    snprintf(name, sizeof(name), "putchar     %s", label);
+    report(name, ns, call_count);
+
+    ns = best_of(repeat, [&] {
+        FileType fp(filename, "rb", BufferMode::Full, 1 << 20);
+        uint64_t sum = 0;
+        int c;
+        while((c = fp.getchar()) != EOF)
+        {
+            sum += static_cast<uint64_t>(c);
+        }
+        keep_result(sum);
+    });
+    snprintf(name, sizeof(name), "getchar     %s", label);
+    report(name, ns, call_count);
+
+    const size_t block_count = call_count / 8;
+    ns = best_of(repeat, [&] {
+        FileType fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < block_count; ++i)
+        {
+            fp.write(block.data(), 1, block_size);
+        }
+    });
+    snprintf(name, sizeof(name), "write 64 B  %s", label);
+    report(name, ns, block_count, static_cast<double>(block_count * block_size));
+
+    ns = best_of(repeat, [&] {
+        FileType fp(filename, "rb", BufferMode::Full, 1 << 20);
+        size_t total = 0;
+        while(size_t got = fp.read(block.data(), 1, block_size))
+        {
+            total += got;
+        }
+        keep_result(total);
+    });
+    snprintf(name, sizeof(name), "read 64 B   %s", label);
+    report(name, ns, block_count, static_cast<double>(block_count * block_size));
+
+    ns = best_of(repeat, [&] {
+        FileType fp(filename, "rb");
+        for(size_t i = 0; i < block_count; ++i)
+        {
+            fp.seek(static_cast<long>(i % 4096) * 64, SeekOrigin::Set);
+        }
+    });
+    snprintf(name, sizeof(name), "seek        %s", label);
+    report(name, ns, block_count);
+    printf("\n");
+}
+
+int main(void)
+{
+    const char* filename = "benchmark_file_stats.tmp";
+
+#if defined(FILE_ENABLE_STATS)
+    printf("statistics compiled in, ");
+#else
+    printf("statistics compiled out, ");
+#endif
+#if defined(FILE_ENABLE_TRACE)
+    printf("trace compiled in, best of %d\n\n", repeat);
+#else
+    printf("trace compiled out, best of %d\n\n", repeat);
+#endif
+
+    run<File>("File", filename);
+    run<UnlockedFile>("UnlockedFile", filename);
+
+#if defined(FILE_ENABLE_STATS)
+    FileStatsRegistry::instance().dump(stdout);
+#endif
+#if defined(FILE_ENABLE_TRACE)
+    FileTraceRegistry::instance().save("benchmark_file_trace.json");
+#endif
+
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,78 @@
+#include "file.h"
+#include "group_commit.h"
+#include "benchmark.h"
+#include <thread>
+#include <vector>
+
+// Durable appends from several writer threads: every writer syncing its own
+// record (sync_data per commit) against GroupCommit sharing one fdatasync
+// between all writers waiting at the same time. Run it on a real disk, on
+// tmpfs every sync is free.
+
+const size_t commits_per_thread = 200;
+const int repeat = 3;
+
+/***
+* @brief       Times thread_count writers each appending and committing commits_per_thread records.
+*
+* @param[out]  sync_count: fdatasync calls of the last run.
+*/
+double run_writers(const char* filename, unsigned thread_count, bool grouped, uint64_t& sync_count)
+{
+    return best_of(repeat, [&] {
+        File fp(filename, "wb");
+        GroupCommit group(fp);
+        std::vector<std::thread> writers;
+        for(unsigned t = 0; t < thread_count; ++t)
+        {
+            writers.emplace_back([&, t] {
+                char record[128];
+                memset(record, 'a' + static_cast<int>(t % 26), sizeof(record));
+                record[sizeof(record) - 1] = '\n';
+                for(size_t i = 0; i < commits_per_thread; ++i)
+                {
+                    fp.write(record, 1, sizeof(record));
+                    if(grouped)
+                    {
+                        group.commit();
+                    }
+                    else
+                    {
+                        fp.sync_data();
+                    }
+                }
+            });
+        }
+        for(std::thread& writer : writers)
+        {
+            writer.join();
+        }
+        sync_count = grouped ? group.sync_count() : thread_count * commits_per_thread;
+    });
+}
+
+int main(void)
+{
+    const char* filename = "benchmark_group_commit.tmp";
+    const unsigned thread_counts[] = {1, 4, 16};
+
+    printf("%zu commits per writer, best of %d\n\n", commits_per_thread, repeat);
+
+    for(unsigned thread_count : thread_counts)
+    {
+        double commits = static_cast<double>(thread_count * commits_per_thread);
+        uint64_t syncs = 0;
+
+        double per_call = run_writers(filename, thread_count, false, syncs);
+        double grouped = run_writers(filename, thread_count, true, syncs);
+
+        printf("%2u writers  sync_data per commit %12.0f commits/s\n", thread_count, commits * 1e9 / per_call);
+        printf("%2u writers  GroupCommit          %12.0f commits/s  (%.1f commits per fdatasync)\n",
+               thread_count, commits * 1e9 / grouped, commits / static_cast<double>(syncs));
+        printf("%-32s %12.2fx\n\n", "            speedup", per_call / grouped);
+    }
+
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,96 @@
+#include "file.h"
+#include "log_file.h"
+#include "benchmark.h"
+#include <thread>
+#include <vector>
+
+// 100 byte records into a LogFile: batched appends synced by the flusher
+// thread every commit interval, against syncing after every record, plus
+// the recovery scan over the result. Run it on a real disk, on tmpfs every
+// sync is free.
+
+const size_t record_size = 100;
+const size_t batched_records = 2000000;
+const size_t synced_records = 2000;
+const int repeat = 3;
+
+/***
+* @brief       Removes every segment of the log at path.
+*/
+void remove_log(const std::string& path)
+{
+    for(uint64_t index = 1; std::remove(LogFile::segment_name(path, index).c_str()) == 0; ++index)
+    {
+    }
+}
+
+/***
+* @brief       Times thread_count writers appending record_count records in total,
+*              then waits for all of them to be durable.
+*
+* @param[in]   sync_each: wait for every record to be durable before the next one.
+*/
+double run_appends(const std::string& path, const LogOptions& options, unsigned thread_count, size_t record_count, bool sync_each)
+{
+    return best_of(repeat, [&] {
+        remove_log(path);
+        LogFile log(path, options);
+        std::vector<std::thread> writers;
+        for(unsigned t = 0; t < thread_count; ++t)
+        {
+            writers.emplace_back([&, t] {
+                std::vector<std::byte> record(record_size, static_cast<std::byte>('a' + t % 26));
+                for(size_t i = 0; i < record_count / thread_count; ++i)
+                {
+                    uint64_t sequence = log.append(record);
+                    if(sync_each)
+                    {
+                        log.sync();
+                    }
+                    keep_result(sequence);
+                }
+            });
+        }
+        for(std::thread& writer : writers)
+        {
+            writer.join();
+        }
+        log.sync();
+    });
+}
+
+int main(void)
+{
+    const std::string path = "benchmark_log_file.wal";
+    const double record_bytes = static_cast<double>(record_size + LogFile::record_overhead);
+
+    LogOptions options;
+    options.segment_size = 256ULL << 20;
+
+    printf("%zu byte records, best of %d\n\n", record_size, repeat);
+
+    double ns = run_appends(path, options, 1, synced_records, true);
+    report("sync per record, 1 writer", ns, synced_records, synced_records * record_bytes);
+
+    const unsigned thread_counts[] = {1, 4};
+    for(unsigned thread_count : thread_counts)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "batched 1ms commits, %u writer%s", thread_count, thread_count == 1 ? "" : "s");
+        ns = run_appends(path, options, thread_count, batched_records, false);
+        report(name, ns, batched_records, batched_records * record_bytes);
+    }
+
+    uint64_t records = 0;
+    ns = best_of(repeat, [&] {
+        LogRecovery recovery = LogFile::replay(path, [](uint64_t, std::span<const std::byte> payload) {
+            keep_result(payload.size());
+        });
+        records = recovery.records;
+    });
+    report("recovery scan", ns, static_cast<double>(records), static_cast<double>(records) * record_bytes);
+
+    remove_log(path);
+
+    return(0);
+}
@@ -0,0 +1,98 @@
+#include "file.h"
+#include "parallel_lines.h"
+#include "benchmark.h"
+#include <charconv>
+#include <thread>
+
+// Aggregating a newline-delimited dump: sum of the value column of the
+// lines matching a filter. Single-threaded getstring() and lines() against
+// parallel_lines() on 1 worker up to one per hardware thread. The page
+// cache is warm, so this measures parsing, which is what scales with cores.
+
+const size_t line_count = 4000000;
+const int repeat = 3;
+
+// "id,sensor_N,value": value of the lines of sensor_7, 0 otherwise
+uint64_t parse_line(std::string_view line)
+{
+    size_t first = line.find(',');
+    size_t second = line.find(',', first + 1);
+    if(first == std::string_view::npos || second == std::string_view::npos || line.substr(first + 1, second - first - 1) != "sensor_7")
+    {
+        return 0;
+    }
+    uint64_t value = 0;
+    std::from_chars(line.data() + second + 1, line.data() + line.size(), value);
+    return value;
+}
+
+int main(void)
+{
+    const char* filename = "benchmark_parallel_lines.tmp";
+    {
+        File fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.print("{},sensor_{},{}\n", i, i % 16, (i * 2654435761u) % 100000);
+        }
+    }
+    double file_bytes = 0.0;
+    {
+        File fp(filename, "rb");
+        fp.seek(0, SeekOrigin::End);
+        file_bytes = static_cast<double>(fp.tell());
+    }
+
+    printf("%zu lines (%.1f MB) per run, best of %d\n\n", line_count, file_bytes / 1e6, repeat);
+
+    double ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        char line[256];
+        uint64_t sum = 0;
+        while(fp.getstring(line, sizeof(line)))
+        {
+            sum += parse_line(std::string_view(line, strcspn(line, "\n")));
+        }
+        keep_result(sum);
+    });
+    report("getstring, 1 thread", ns, line_count, file_bytes);
+
+    ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        uint64_t sum = 0;
+        for(std::string_view line : fp.lines())
+        {
+            sum += parse_line(line);
+        }
+        keep_result(sum);
+    });
+    report("lines(), 1 thread", ns, line_count, file_bytes);
+
+    unsigned hardware = std::thread::hardware_concurrency();
+    for(unsigned workers = 1; ; workers *= 2)
+    {
+        if(workers > hardware)
+        {
+            workers = hardware;
+        }
+        ThreadPool pool(workers);
+        ns = best_of(repeat, [&] {
+            File fp(filename, "rb");
+            uint64_t sum = parallel_lines(fp, pool, uint64_t(0),
+                                          [](uint64_t& total, std::string_view line) { total += parse_line(line); },
+                                          [](uint64_t a, uint64_t b) { return a + b; });
+            keep_result(sum);
+        });
+        char name[64];
+        snprintf(name, sizeof(name), "parallel_lines, %u worker%s", workers, workers == 1 ? "" : "s");
+        report(name, ns, line_count, file_bytes);
+        if(workers >= hardware)
+        {
+            break;
+        }
+    }
+
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,59 @@
+#include "file.h"
+#include "benchmark.h"
+
+// Structured log lines through printInFile (vfprintf, format parsed on every
+// call) against print (format parsed while compiling, to_chars conversions).
+
+const size_t line_count = 1000000;
+const int repeat = 5;
+
+template <typename FileType>
+double bench_printInFile(const char* filename)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.printInFile("ts=%llu level=%s req=%x status=%d bytes=%zu latency_ms=%.3f path=%s\n",
+                           static_cast<unsigned long long>(1700000000000ULL + i), "INFO", static_cast<unsigned>(i * 2654435761u),
+                           200 + static_cast<int>(i % 5), i * 37 % 65536, static_cast<double>(i % 1000) * 0.0137, "/api/v1/items");
+        }
+    });
+}
+
+template <typename FileType>
+double bench_print(const char* filename)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.print("ts={} level={} req={:x} status={} bytes={} latency_ms={:.3f} path={}\n",
+                     1700000000000ULL + i, "INFO", static_cast<unsigned>(i * 2654435761u),
+                     200 + static_cast<int>(i % 5), i * 37 % 65536, static_cast<double>(i % 1000) * 0.0137, "/api/v1/items");
+        }
+    });
+}
+
+int main(void)
+{
+    const char* filename = "benchmark_print.tmp";
+
+    printf("%zu log lines per run, best of %d\n\n", line_count, repeat);
+
+    double printf_ns = bench_printInFile<File>(filename);
+    double print_ns = bench_print<File>(filename);
+    report("printInFile File", printf_ns, line_count);
+    report("print       File", print_ns, line_count);
+    printf("%-40s %10.2fx\n\n", "print speedup", printf_ns / print_ns);
+
+    printf_ns = bench_printInFile<UnlockedFile>(filename);
+    print_ns = bench_print<UnlockedFile>(filename);
+    report("printInFile UnlockedFile", printf_ns, line_count);
+    report("print       UnlockedFile", print_ns, line_count);
+    printf("%-40s %10.2fx\n", "print speedup", printf_ns / print_ns);
+
+    std::remove(filename);
+
+    return(0);
+}
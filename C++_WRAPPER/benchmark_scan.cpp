@@ -0,0 +1,65 @@
+#include "file.h"
+#include "benchmark.h"
+
+// Loading a numeric text dump ("id value label" per line) through
+// scanInFile (vfscanf) against the typed scan<> (getline + from_chars).
+
+const size_t line_count = 2000000;
+const int repeat = 5;
+
+int main(void)
+{
+    const char* filename = "benchmark_scan.tmp";
+    {
+        File fp(filename, "wb", BufferMode::Full, 1 << 20);
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.print("{} {:.6f} sensor_{}\n", i, static_cast<double>(i % 100000) * 0.731, i % 64);
+        }
+    }
+    double file_bytes = 0.0;
+    {
+        File fp(filename, "rb");
+        fp.seek(0, SeekOrigin::End);
+        file_bytes = static_cast<double>(fp.tell());
+    }
+
+    printf("%zu lines (%.1f MB) per run, best of %d\n\n", line_count, file_bytes / 1e6, repeat);
+
+    double scanf_ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        long id;
+        double value;
+        char label[64];
+        uint64_t sum = 0;
+        while(fp.scanInFile("%ld %lf %63s", &id, &value, label))
+        {
+            sum += static_cast<uint64_t>(id) + static_cast<uint64_t>(value) + label[0];
+        }
+        keep_result(sum);
+    });
+
+    double scan_ns = best_of(repeat, [&] {
+        File fp(filename, "rb");
+        uint64_t sum = 0;
+        for(;;)
+        {
+            ScanResult<long, double, std::string_view> row = fp.scan<long, double, std::string_view>();
+            if(!row)
+            {
+                break;
+            }
+            auto [id, value, label] = row.values;
+            sum += static_cast<uint64_t>(id) + static_cast<uint64_t>(value) + label[0];
+        }
+        keep_result(sum);
+    });
+
+    report("scanInFile", scanf_ns, line_count, file_bytes);
+    report("scan<long, double, string_view>", scan_ns, line_count, file_bytes);
+    printf("%-40s %10.2fx\n", "scan speedup", scanf_ns / scan_ns);
+
+    std::remove(filename);
+
+    return(0);
+}
@@ -0,0 +1,520 @@
+#include "file.h"
+#include "benchmark.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <sys/vfs.h>
+#endif
+
+// Overhead of File against the interfaces it competes with: every File
+// operation next to raw FILE*, std::fstream and read(2)/write(2), on each
+// storage directory given (tmpfs and the current directory by default).
+// Prints ns per call and MB/s, and with --csv/--json writes the same rows
+// in machine-readable form for tracking regressions between commits.
+//
+// Usage: benchmark_suite [--dir PATH]... [--repeat N] [--csv FILE] [--json FILE]
+//
+// POSIX read(2)/write(2) has no user space buffer, so the character, line
+// and small block rows show the per-syscall cost; those rows run 1/16 of the
+// operations to keep the suite short. It has no formatted input, so there
+// is no scanInFile row for it.
+
+const size_t char_ops = 4 << 20;
+const size_t line_ops = 1 << 20;
+const size_t record_ops = 1 << 20;
+const size_t seek_ops = 1 << 20;
+const size_t block_ops = 1 << 20;
+const size_t max_block_bytes = 64 << 20;
+const size_t unbuffered_divisor = 16;
+const size_t block_sizes[] = {16, 256, 4096, 65536, 1 << 20};
+const char line_text[] = "a short log line of about forty bytes..\n";
+const size_t line_length = sizeof(line_text) - 1;
+
+
+
+//==================== Interfaces ====================
+// One adapter per interface, all with the same members, so each operation
+// is written once as a template.
+
+struct FileApi
+{
+    static constexpr const char* name = "File";
+    static constexpr const char* tag = "file"; // file name part
+    static constexpr bool buffered = true;
+    File fp;
+
+    FileApi(const std::string& path, bool writing) : fp(path, writing ? "wb" : "rb") {}
+    void put_char(char c) { fp.putchar(c); }
+    int get_char() { return fp.getchar(); }
+    void put_line(const char* line) { fp.putstring(line); }
+    bool get_line(char* line, int size) { return fp.getstring(line, size) != NULL; }
+    void write(const char* data, size_t size) { fp.write(data, 1, size); }
+    size_t read(char* data, size_t size) { return fp.read(data, 1, size); }
+    void print_record(int value, const char* word) { fp.printInFile("%d %s\n", value, word); }
+    bool scan_record(int& value, char (&word)[32]) { return fp.scanInFile("%d %31s", &value, word); }
+    void seek(long offset) { fp.seek(offset, SeekOrigin::Set); }
+    long tell() { return fp.tell(); }
+};
+
+struct StdioApi
+{
+    static constexpr const char* name = "FILE*";
+    static constexpr const char* tag = "stdio"; // file name part
+    static constexpr bool buffered = true;
+    FILE* fp;
+
+    StdioApi(const std::string& path, bool writing) : fp(fopen(path.c_str(), writing ? "wb" : "rb")) {}
+    ~StdioApi() { fclose(fp); }
+    void put_char(char c) { putc(c, fp); }
+    int get_char() { return getc(fp); }
+    void put_line(const char* line) { fputs(line, fp); }
+    bool get_line(char* line, int size) { return fgets(line, size, fp) != NULL; }
+    void write(const char* data, size_t size) { fwrite(data, 1, size, fp); }
+    size_t read(char* data, size_t size) { return fread(data, 1, size, fp); }
+    void print_record(int value, const char* word) { fprintf(fp, "%d %s\n", value, word); }
+    bool scan_record(int& value, char (&word)[32]) { return fscanf(fp, "%d %31s", &value, word) == 2; }
+    void seek(long offset) { fseek(fp, offset, SEEK_SET); }
+    long tell() { return ftell(fp); }
+};
+
+struct FstreamApi
+{
+    static constexpr const char* name = "std::fstream";
+    static constexpr const char* tag = "fstream"; // file name part
+    static constexpr bool buffered = true;
+    std::fstream fs;
+
+    FstreamApi(const std::string& path, bool writing)
+        : fs(path, std::ios::binary | (writing ? std::ios::out | std::ios::trunc : std::ios::in)) {}
+    void put_char(char c) { fs.put(c); }
+    int get_char() { return fs.get(); }
+    void put_line(const char* line) { fs << line; }
+    bool get_line(char* line, int size) { return static_cast<bool>(fs.getline(line, size)); }
+    void write(const char* data, size_t size) { fs.write(data, static_cast<std::streamsize>(size)); }
+    size_t read(char* data, size_t size) { fs.read(data, static_cast<std::streamsize>(size)); return static_cast<size_t>(fs.gcount()); }
+    void print_record(int value, const char* word) { fs << value << ' ' << word << '\n'; }
+    bool scan_record(int& value, char (&word)[32]) { return static_cast<bool>(fs >> value >> word); }
+    void seek(long offset) { fs.seekg(offset); }
+    long tell() { return static_cast<long>(fs.tellg()); }
+};
+
+struct PosixApi
+{
+    static constexpr const char* name = "read/write";
+    static constexpr const char* tag = "posix"; // file name part
+    static constexpr bool buffered = false;
+    int fd;
+
+    PosixApi(const std::string& path, bool writing)
+        : fd(::open(path.c_str(), writing ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY, 0644)) {}
+    ~PosixApi() { ::close(fd); }
+    void put_char(char c) { keep_result(static_cast<uint64_t>(::write(fd, &c, 1))); }
+    int get_char()
+    {
+        unsigned char c;
+        return ::read(fd, &c, 1) == 1 ? c : EOF;
+    }
+    void put_line(const char* line) { keep_result(static_cast<uint64_t>(::write(fd, line, strlen(line)))); }
+    bool get_line(char* line, int size)
+    {
+        // No buffer to search, so a line costs one syscall per byte
+        int length = 0;
+        while(length < size - 1 && ::read(fd, line + length, 1) == 1)
+        {
+            if(line[length++] == '\n')
+            {
+                break;
+            }
+        }
+        line[length] = '\0';
+        return length > 0;
+    }
+    void write(const char* data, size_t size) { keep_result(static_cast<uint64_t>(::write(fd, data, size))); }
+    size_t read(char* data, size_t size) { ssize_t got = ::read(fd, data, size); return got > 0 ? static_cast<size_t>(got) : 0; }
+    void print_record(int value, const char* word)
+    {
+        char record[64];
+        int length = snprintf(record, sizeof(record), "%d %s\n", value, word);
+        keep_result(static_cast<uint64_t>(::write(fd, record, static_cast<size_t>(length))));
+    }
+    bool scan_record(int&, char (&)[32]) { return false; }
+    void seek(long offset) { lseek(fd, offset, SEEK_SET); }
+    long tell() { return static_cast<long>(lseek(fd, 0, SEEK_CUR)); }
+};
+
+
+
+//==================== Results ====================
+struct Result
+{
+    std::string storage;        // directory the file lived in
+    std::string filesystem;     // its file system type
+    std::string operation;      // e.g. "getchar" or "read"
+    std::string implementation; // adapter name
+    size_t block_size;          // bytes per call, 0 where it does not apply
+    size_t ops;                 // calls per run
+    double ns_per_op;           // best run
+    double mb_per_s;            // bytes moved per second of the best run
+};
+
+struct Suite
+{
+    std::string storage;
+    std::string filesystem;
+    int repeat = 3;
+    std::vector<Result> results;
+
+    /***
+    * @brief       Times fn, prints the row and keeps it for --csv/--json.
+    */
+    template <typename Fn>
+    void measure(const char* operation, const char* implementation, size_t block_size, size_t ops, double bytes, Fn&& fn)
+    {
+        double ns = best_of(repeat, fn);
+        char name[64];
+        if(block_size)
+        {
+            snprintf(name, sizeof(name), "%-10s %-7zu %s", operation, block_size, implementation);
+        }
+        else
+        {
+            snprintf(name, sizeof(name), "%-18s %s", operation, implementation);
+        }
+        report(name, ns, static_cast<double>(ops), bytes);
+        results.push_back(Result{storage, filesystem, operation, implementation, block_size, ops,
+                                 ns / static_cast<double>(ops), bytes * 1e3 / ns});
+    }
+
+    /***
+    * @brief       Prints how much slower File is than raw FILE* for the last operation.
+    */
+    void overhead()
+    {
+        const Result* file = NULL;
+        const Result* stdio = NULL;
+        for(const Result& result : results)
+        {
+            if(result.storage == storage && result.implementation == FileApi::name)
+            {
+                file = &result;
+            }
+            if(result.storage == storage && result.implementation == StdioApi::name)
+            {
+                stdio = &result;
+            }
+        }
+        if(file && stdio && file->operation == stdio->operation && file->block_size == stdio->block_size)
+        {
+            printf("%-40s %10.2fx\n\n", "File / FILE*", file->ns_per_op / stdio->ns_per_op);
+        }
+    }
+};
+
+template <typename Api>
+size_t scaled(size_t ops)
+{
+    return Api::buffered ? ops : ops / unbuffered_divisor;
+}
+
+
+
+//==================== Operations ====================
+template <typename Api>
+void bench_chars(Api*, Suite& suite, const std::string& path, bool reading)
+{
+    const size_t ops = scaled<Api>(char_ops);
+    if(!reading)
+    {
+        suite.measure("putchar", Api::name, 0, ops, static_cast<double>(ops), [&] {
+            Api api(path, true);
+            for(size_t i = 0; i < ops; ++i)
+            {
+                api.put_char(static_cast<char>('a' + i % 26));
+            }
+        });
+        return;
+    }
+    suite.measure("getchar", Api::name, 0, ops, static_cast<double>(ops), [&] {
+        Api api(path, false);
+        uint64_t sum = 0;
+        int c;
+        while((c = api.get_char()) != EOF)
+        {
+            sum += static_cast<uint64_t>(c);
+        }
+        keep_result(sum);
+    });
+}
+
+template <typename Api>
+void bench_lines(Api*, Suite& suite, const std::string& path, bool reading)
+{
+    const size_t ops = scaled<Api>(line_ops);
+    const double bytes = static_cast<double>(ops * line_length);
+    if(!reading)
+    {
+        suite.measure("putstring", Api::name, 0, ops, bytes, [&] {
+            Api api(path, true);
+            for(size_t i = 0; i < ops; ++i)
+            {
+                api.put_line(line_text);
+            }
+        });
+        return;
+    }
+    suite.measure("getstring", Api::name, 0, ops, bytes, [&] {
+        Api api(path, false);
+        char line[64];
+        uint64_t count = 0;
+        while(api.get_line(line, sizeof(line)))
+        {
+            ++count;
+        }
+        keep_result(count);
+    });
+}
+
+template <typename Api>
+void bench_blocks(Api*, Suite& suite, const std::string& path, size_t block_size, bool reading)
+{
+    const size_t ops = std::min(scaled<Api>(block_ops), max_block_bytes / block_size);
+    const double bytes = static_cast<double>(ops * block_size);
+    std::vector<char> block(block_size, 'b');
+    if(!reading)
+    {
+        suite.measure("write", Api::name, block_size, ops, bytes, [&] {
+            Api api(path, true);
+            for(size_t i = 0; i < ops; ++i)
+            {
+                api.write(block.data(), block_size);
+            }
+        });
+        return;
+    }
+    suite.measure("read", Api::name, block_size, ops, bytes, [&] {
+        Api api(path, false);
+        size_t total = 0;
+        while(size_t got = api.read(block.data(), block_size))
+        {
+            total += got;
+        }
+        keep_result(total);
+    });
+}
+
+template <typename Api>
+void bench_records(Api*, Suite& suite, const std::string& path, bool reading)
+{
+    const size_t ops = scaled<Api>(record_ops);
+    if(!reading)
+    {
+        suite.measure("printInFile", Api::name, 0, ops, 0.0, [&] {
+            Api api(path, true);
+            for(size_t i = 0; i < ops; ++i)
+            {
+                api.print_record(static_cast<int>(i), "record");
+            }
+        });
+        return;
+    }
+    if(!Api::buffered)
+    {
+        return; // no formatted input on a raw descriptor
+    }
+    suite.measure("scanInFile", Api::name, 0, ops, 0.0, [&] {
+        Api api(path, false);
+        int value;
+        char word[32];
+        uint64_t sum = 0;
+        while(api.scan_record(value, word))
+        {
+            sum += static_cast<uint64_t>(value);
+        }
+        keep_result(sum);
+    });
+}
+
+template <typename Api>
+void bench_seek(Api*, Suite& suite, const std::string& path, const std::vector<long>& offsets)
+{
+    suite.measure("seek+tell", Api::name, 0, offsets.size(), 0.0, [&] {
+        Api api(path, false);
+        uint64_t sum = 0;
+        for(long offset : offsets)
+        {
+            api.seek(offset);
+            sum += static_cast<uint64_t>(api.tell());
+        }
+        keep_result(sum);
+    });
+}
+
+/***
+* @brief       Calls op(Api*, path) once per adapter in table order, each on its
+*              own file in directory, then prints the File overhead.
+*/
+template <typename Op>
+void for_each_api(Suite& suite, const std::string& directory, Op&& op)
+{
+    auto run = [&](auto* tag) {
+        using Api = std::remove_pointer_t<decltype(tag)>;
+        op(tag, directory + "/benchmark_suite." + Api::tag + ".tmp");
+    };
+    run(static_cast<FileApi*>(NULL));
+    run(static_cast<StdioApi*>(NULL));
+    run(static_cast<FstreamApi*>(NULL));
+    run(static_cast<PosixApi*>(NULL));
+    suite.overhead();
+}
+
+
+
+//==================== Output ====================
+/***
+* @brief       File system type of directory, e.g. "tmpfs" or "ext4".
+*/
+std::string filesystem_name(const std::string& directory)
+{
+#if defined(__linux__)
+    struct statfs info;
+    if(statfs(directory.c_str(), &info) == 0)
+    {
+        switch(static_cast<unsigned long>(info.f_type))
+        {
+            case 0x01021994: return "tmpfs";
+            case 0xEF53: return "ext4";
+            case 0x58465342: return "xfs";
+            case 0x9123683E: return "btrfs";
+            case 0x794C7630: return "overlayfs";
+            case 0x6969: return "nfs";
+        }
+    }
+#else
+    (void)directory;
+#endif
+    return "unknown";
+}
+
+void write_csv(const std::string& filename, const std::vector<Result>& results)
+{
+    File out(filename, "w");
+    out.print("storage,filesystem,operation,implementation,block_size,ops,ns_per_op,mb_per_s\n");
+    for(const Result& r : results)
+    {
+        out.print("{},{},{},{},{},{},{:.3f},{:.1f}\n", r.storage, r.filesystem, r.operation, r.implementation,
+                  r.block_size, r.ops, r.ns_per_op, r.mb_per_s);
+    }
+}
+
+void write_json(const std::string& filename, const std::vector<Result>& results)
+{
+    File out(filename, "w");
+    out.print("{{\n  \"results\": [\n");
+    for(size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& r = results[i];
+        out.print("    {{\"storage\": \"{}\", \"filesystem\": \"{}\", \"operation\": \"{}\", \"implementation\": \"{}\", "
+                  "\"block_size\": {}, \"ops\": {}, \"ns_per_op\": {:.3f}, \"mb_per_s\": {:.1f}}}{}\n",
+                  r.storage, r.filesystem, r.operation, r.implementation, r.block_size, r.ops, r.ns_per_op, r.mb_per_s,
+                  i + 1 < results.size() ? "," : "");
+    }
+    out.print("  ]\n}}\n");
+}
+
+
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> directories;
+    std::string csv_file;
+    std::string json_file;
+    int repeat = 3;
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if(i + 1 < argc && arg == "--dir")
+        {
+            directories.push_back(argv[++i]);
+        }
+        else if(i + 1 < argc && arg == "--csv")
+        {
+            csv_file = argv[++i];
+        }
+        else if(i + 1 < argc && arg == "--json")
+        {
+            json_file = argv[++i];
+        }
+        else if(i + 1 < argc && arg == "--repeat")
+        {
+            repeat = std::max(1, atoi(argv[++i]));
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--dir PATH]... [--repeat N] [--csv FILE] [--json FILE]\n", argv[0]);
+            return(1);
+        }
+    }
+    if(directories.empty())
+    {
+        struct stat info;
+        if(stat("/dev/shm", &info) == 0 && S_ISDIR(info.st_mode))
+        {
+            directories.push_back("/dev/shm");
+        }
+        directories.push_back(".");
+    }
+
+    std::vector<long> offsets(seek_ops);
+    std::mt19937_64 rng(42);
+    for(long& offset : offsets)
+    {
+        offset = static_cast<long>(rng() % max_block_bytes);
+    }
+
+    Suite suite;
+    suite.repeat = repeat;
+    for(const std::string& directory : directories)
+    {
+        suite.storage = directory;
+        suite.filesystem = filesystem_name(directory);
+        printf("==================== %s (%s), best of %d ====================\n\n",
+               directory.c_str(), suite.filesystem.c_str(), repeat);
+
+        // Each operation receives the adapter as a null Api* tag and its own file
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_chars(api, suite, path, false); });
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_chars(api, suite, path, true); });
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_lines(api, suite, path, false); });
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_lines(api, suite, path, true); });
+        for(size_t block_size : block_sizes)
+        {
+            for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_blocks(api, suite, path, block_size, false); });
+            for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_blocks(api, suite, path, block_size, true); });
+        }
+        // Seeks run on the 64 MiB files of the last block size
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_seek(api, suite, path, offsets); });
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_records(api, suite, path, false); });
+        for_each_api(suite, directory, [&](auto* api, const std::string& path) { bench_records(api, suite, path, true); });
+        std::remove((directory + "/benchmark_suite." + FileApi::tag + ".tmp").c_str());
+        std::remove((directory + "/benchmark_suite." + StdioApi::tag + ".tmp").c_str());
+        std::remove((directory + "/benchmark_suite." + FstreamApi::tag + ".tmp").c_str());
+        std::remove((directory + "/benchmark_suite." + PosixApi::tag + ".tmp").c_str());
+    }
+
+    if(!csv_file.empty())
+    {
+        write_csv(csv_file, suite.results);
+    }
+    if(!json_file.empty())
+    {
+        write_json(json_file, suite.results);
+    }
+
+    return(0);
+}
@@ -0,0 +1,113 @@
+#include "file.h"
+#include "benchmark.h"
+#include <string>
+#include <thread>
+#include <atomic>
+
+// Per-byte cost of the locking (File) and unlocked (UnlockedFile) character
+// and string paths, i.e. the tight putchar/getchar loop of test_case_5.
+
+const size_t byte_count = 16 * 1024 * 1024;
+const int repeat = 5;
+
+template <typename FileType>
+double bench_putchar(const char* filename)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "wb");
+        for(size_t i = 0; i < byte_count; ++i)
+        {
+            fp.putchar(static_cast<char>('a' + i % 26));
+        }
+    });
+}
+
+template <typename FileType>
+double bench_getchar(const char* filename)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "rb");
+        uint64_t sum = 0;
+        int c;
+        while((c = fp.getchar()) != EOF)
+        {
+            sum += static_cast<uint64_t>(c);
+        }
+        keep_result(sum);
+    });
+}
+
+template <typename FileType>
+double bench_putstring(const char* filename, size_t line_count)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "wb");
+        for(size_t i = 0; i < line_count; ++i)
+        {
+            fp.putstring("a short log line of about forty bytes..\n");
+        }
+    });
+}
+
+template <typename FileType>
+double bench_getstring(const char* filename)
+{
+    return best_of(repeat, [&] {
+        FileType fp(filename, "rb");
+        char line[64];
+        uint64_t count = 0;
+        while(fp.getstring(line, sizeof(line)) != NULL)
+        {
+            ++count;
+        }
+        keep_result(count);
+    });
+}
+
+int main(void)
+{
+    // glibc skips stdio locking while the process has a single thread. Keep a
+    // second thread alive so File pays the lock cost it pays in a real service.
+    std::atomic<bool> done(false);
+    std::thread idle([&] {
+        while(!done.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+
+    const char* filename = "benchmark_unlocked_io.tmp";
+    const size_t line_count = byte_count / 40;
+
+    printf("%zu bytes per run, best of %d\n\n", byte_count, repeat);
+
+    double locked = bench_putchar<File>(filename);
+    double unlocked = bench_putchar<UnlockedFile>(filename);
+    report("putchar   File", locked, byte_count, byte_count);
+    report("putchar   UnlockedFile", unlocked, byte_count, byte_count);
+    printf("%-40s %10.2fx\n\n", "putchar   speedup", locked / unlocked);
+
+    locked = bench_getchar<File>(filename);
+    unlocked = bench_getchar<UnlockedFile>(filename);
+    report("getchar   File", locked, byte_count, byte_count);
+    report("getchar   UnlockedFile", unlocked, byte_count, byte_count);
+    printf("%-40s %10.2fx\n\n", "getchar   speedup", locked / unlocked);
+
+    locked = bench_putstring<File>(filename, line_count);
+    unlocked = bench_putstring<UnlockedFile>(filename, line_count);
+    report("putstring File", locked, line_count, line_count * 40.0);
+    report("putstring UnlockedFile", unlocked, line_count, line_count * 40.0);
+    printf("%-40s %10.2fx\n\n", "putstring speedup", locked / unlocked);
+
+    locked = bench_getstring<File>(filename);
+    unlocked = bench_getstring<UnlockedFile>(filename);
+    report("getstring File", locked, line_count, line_count * 40.0);
+    report("getstring UnlockedFile", unlocked, line_count, line_count * 40.0);
+    printf("%-40s %10.2fx\n", "getstring speedup", locked / unlocked);
+
+    std::remove(filename);
+    done.store(true);
+    idle.join();
+
+    return(0);
+}
@@ -0,0 +1,337 @@
+#ifndef _CONCURRENT_APPENDER_H
+#define _CONCURRENT_APPENDER_H
+
+// Header inclusion
+#include "file.h"      // for File, FileResult and the descriptor helpers
+#include <atomic>      // for the reservation and watermark words
+#include <cstdint>     // for offsets
+#include <memory>      // for the in-flight slots
+#include <span>        // for typed records
+#include <string_view> // for text records
+#include <thread>      // for yielding while a slot drains
+
+
+
+//==================== ConcurrentAppender Class ====================
+// Appends records from many threads to one File without a lock. Every
+// append() reserves its offset with one atomic fetch-add and writes the
+// record with pwrite, so writers neither contend on the stdio lock nor
+// interleave records. Because records finish out of order, written()
+// reports the contiguous "written up to" offset: each finished record
+// publishes itself in an in-flight slot, and whichever writer finds the
+// record at the watermark finished moves the watermark past it and every
+// finished record after it with a compare-and-swap. sync() makes
+// everything below the watermark durable and moves durable() up to it.
+// Disk space is preallocated ahead of the writers on Linux. A File opened
+// in append mode works too: O_APPEND would make pwrite ignore the reserved
+// offsets, so it is cleared while the appender exists. POSIX only. Must
+// not outlive its File, and the File must not be written through other
+// calls while the appender is in use.
+class ConcurrentAppender
+{
+    private:
+        // The reservation and written words pack a record sequence number
+        // in the top 16 bits and an offset relative to m_base in the low 48.
+        static constexpr int offset_bits = 48;
+        static constexpr uint64_t offset_mask = (uint64_t(1) << offset_bits) - 1;
+        static constexpr uint64_t max_offset = uint64_t(1) << (offset_bits - 1); // leaves room for in-flight records
+        static constexpr size_t slot_count = 1024;                               // records in flight at once
+        static constexpr uint64_t free_slot = UINT64_MAX;
+
+        // Finished record waiting for the watermark to reach it
+        struct Slot
+        {
+            std::atomic<uint64_t> start{free_slot}; // relative offset of the record, free_slot when unused
+            std::atomic<uint64_t> end{0};           // relative offset just past it
+        };
+
+        int m_fd;                                 // descriptor written
+        uint64_t m_base;                          // file size when the appender was created
+        const uint64_t m_chunk;                   // bytes preallocated per step, 0 to disable
+        std::unique_ptr<Slot[]> m_slots;          // slot_count slots
+        alignas(64) std::atomic<uint64_t> m_reserved;  // sequence and offset of the next record
+        alignas(64) std::atomic<uint64_t> m_written;   // sequence and offset of the first unfinished record
+        alignas(64) std::atomic<uint64_t> m_durable;   // relative offset synced to disk
+        std::atomic<uint64_t> m_allocated;        // relative offset preallocated up to
+        std::atomic<bool> m_allocating;           // a writer is preallocating
+        std::atomic<int> m_error;                 // errno of the first failed write or sync, 0 while none failed
+        bool m_restore_append;                    // O_APPEND was cleared and is set again on destruction
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Prepares concurrent appends at the current end of file.
+        *
+        * @details     Pending buffered output of file is flushed first, so it lands
+        *              before the first record. If file was opened in append mode,
+        *              O_APPEND is cleared until the appender is destroyed; if that
+        *              fails, every append fails with the errno of fcntl.
+        *
+        * @param[in]   file: open File the writers share, opened for writing.
+        * @param[in]   preallocate: bytes of disk space reserved ahead of the writers
+        *              at a time (fallocate with FALLOC_FL_KEEP_SIZE, Linux only);
+        *              0 disables preallocation.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename ThreadingPolicy>
+        explicit ConcurrentAppender(BasicFile<ThreadingPolicy>& file, uint64_t preallocate = 64 << 20)
+            : m_fd(file.get_descriptor()), m_base(0), m_chunk(preallocate), m_slots(new Slot[slot_count]),
+              m_reserved(0), m_written(0), m_durable(0), m_allocated(0), m_allocating(false), m_error(0),
+              m_restore_append(false)
+        {
+            struct stat st;
+            if(!file.flush() || fstat(m_fd, &st) != 0)
+            {
+                m_error.store(errno ? errno : EIO, std::memory_order_relaxed);
+                return;
+            }
+            m_base = static_cast<uint64_t>(st.st_size);
+
+            // Under O_APPEND Linux writes at the end of file whatever offset pwrite gets
+            int flags = fcntl(m_fd, F_GETFL);
+            if(flags == -1 || ((flags & O_APPEND) && fcntl(m_fd, F_SETFL, flags & ~O_APPEND) != 0))
+            {
+                m_error.store(errno ? errno : EIO, std::memory_order_relaxed);
+                return;
+            }
+            m_restore_append = (flags & O_APPEND) != 0;
+        }
+
+        ConcurrentAppender(const ConcurrentAppender&) = delete;
+        ConcurrentAppender& operator=(const ConcurrentAppender&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Sets O_APPEND again if the constructor cleared it.
+        */
+        ~ConcurrentAppender() noexcept
+        {
+            if(m_restore_append)
+            {
+                int flags = fcntl(m_fd, F_GETFL);
+                if(flags != -1)
+                {
+                    fcntl(m_fd, F_SETFL, flags | O_APPEND);
+                }
+            }
+        }
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Appends one record, thread safe.
+        *
+        * @return      returns true on success otherwise false.
+        */
+        bool append(const void* data, size_t size)
+        {
+            return try_append(data, size).has_value();
+        }
+
+        bool append(std::string_view record)
+        {
+            return try_append(record.data(), record.size()).has_value();
+        }
+
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        bool append(std::span<T, Extent> items)
+        {
+            return try_append(items.data(), items.size_bytes()).has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of append() that reports where the record went.
+        *
+        * @details     A failed write is sticky: the watermark can not pass the hole
+        *              it leaves, so every later append fails with the same errno.
+        *
+        * @return      file offset of the record on success, otherwise EFBIG for records
+        *              of 4 GiB or more or past 128 TiB appended, or the errno of pwrite.
+        */
+        FileResult<uint64_t> try_append(const void* data, size_t size,
+                                        std::source_location location = std::source_location::current()) noexcept
+        {
+            int error = m_error.load(std::memory_order_relaxed);
+            if(error != 0)
+            {
+                return FileError(error, location);
+            }
+            if(size >= (uint64_t(1) << 32))
+            {
+                return FileError(EFBIG, location);
+            }
+            if(size == 0)
+            {
+                return m_base + (m_reserved.load(std::memory_order_relaxed) & offset_mask); // nothing to order
+            }
+
+            uint64_t ticket = m_reserved.fetch_add((uint64_t(1) << offset_bits) + size, std::memory_order_relaxed);
+            uint64_t start = ticket & offset_mask;
+            uint64_t end = start + size;
+            if(end > max_offset)
+            {
+                return fail(EFBIG, location);
+            }
+            preallocate_ahead(end);
+
+            errno = 0;
+            if(file_detail::pwrite_full(m_fd, data, size, static_cast<int64_t>(m_base + start)) != size)
+            {
+                return fail(errno ? errno : EIO, location);
+            }
+
+            // Publish the finished record once the watermark is less than
+            // slot_count records behind it, so the slot belongs to it alone
+            uint64_t sequence = ticket >> offset_bits;
+            Slot& slot = m_slots[sequence % slot_count];
+            while(static_cast<uint16_t>(sequence - (m_written.load(std::memory_order_acquire) >> offset_bits)) >= slot_count ||
+                  slot.start.load(std::memory_order_acquire) != free_slot)
+            {
+                if((error = m_error.load(std::memory_order_relaxed)) != 0)
+                {
+                    return FileError(error, location);
+                }
+                std::this_thread::yield();
+            }
+            slot.end.store(end, std::memory_order_relaxed);
+            slot.start.store(start, std::memory_order_release);
+            advance_written();
+            return m_base + start;
+        }
+
+        /***
+        * @brief       Makes every record below written() durable with fdatasync.
+        *
+        * @details     Records still in flight are not waited for. A failed sync is
+        *              sticky, as in GroupCommit.
+        *
+        * @return      returns true on success otherwise false.
+        */
+        bool sync()
+        {
+            return try_sync().has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of sync().
+        *
+        * @return      the new durable() offset on success, otherwise the errno of fdatasync.
+        */
+        FileResult<uint64_t> try_sync(std::source_location location = std::source_location::current()) noexcept
+        {
+            int error = m_error.load(std::memory_order_relaxed);
+            if(error != 0)
+            {
+                return FileError(error, location);
+            }
+            uint64_t target = m_written.load(std::memory_order_acquire) & offset_mask;
+            uint64_t durable = m_durable.load(std::memory_order_acquire);
+            if(durable >= target)
+            {
+                return m_base + durable; // covered by an earlier sync
+            }
+            if(file_detail::sync_descriptor(m_fd, true) != 0)
+            {
+                return fail(errno ? errno : EIO, location);
+            }
+            while(durable < target && !m_durable.compare_exchange_weak(durable, target, std::memory_order_release,
+                                                                        std::memory_order_acquire))
+            {
+            }
+            return m_base + (durable > target ? durable : target);
+        }
+
+
+
+        //==================== WATERMARKS ====================
+        /***
+        * @brief   File offset below which every appended record is completely written.
+        */
+        uint64_t written() const noexcept
+        {
+            return m_base + (m_written.load(std::memory_order_acquire) & offset_mask);
+        }
+
+        /***
+        * @brief   File offset below which every appended record is durable.
+        */
+        uint64_t durable() const noexcept
+        {
+            return m_base + m_durable.load(std::memory_order_acquire);
+        }
+
+        /***
+        * @brief   File offset the next record will be appended at.
+        */
+        uint64_t reserved() const noexcept
+        {
+            return m_base + (m_reserved.load(std::memory_order_relaxed) & offset_mask);
+        }
+
+    private:
+        FileError fail(int error, std::source_location location) noexcept
+        {
+            int expected = 0;
+            m_error.compare_exchange_strong(expected, error, std::memory_order_relaxed);
+            return FileError(error, location);
+        }
+
+        // Moves the watermark past the record at it while that record is finished
+        void advance_written() noexcept
+        {
+            uint64_t current = m_written.load(std::memory_order_acquire);
+            for(;;)
+            {
+                Slot& slot = m_slots[(current >> offset_bits) % slot_count];
+                if(slot.start.load(std::memory_order_acquire) != (current & offset_mask))
+                {
+                    return; // still in flight, its writer moves the watermark on
+                }
+                uint64_t end = slot.end.load(std::memory_order_relaxed);
+                uint64_t next = ((current >> offset_bits) + 1) << offset_bits | end;
+                if(m_written.compare_exchange_strong(current, next, std::memory_order_acq_rel, std::memory_order_acquire))
+                {
+                    slot.start.store(free_slot, std::memory_order_release);
+                    current = next;
+                }
+            }
+        }
+
+        // Keeps m_chunk bytes preallocated past end; one writer at a time, others carry on
+        void preallocate_ahead(uint64_t end) noexcept
+        {
+#if defined(__linux__)
+            if(m_chunk == 0 || end + m_chunk / 2 <= m_allocated.load(std::memory_order_relaxed) ||
+               m_allocating.exchange(true, std::memory_order_acquire))
+            {
+                return;
+            }
+            uint64_t allocated = m_allocated.load(std::memory_order_relaxed);
+            while(allocated < end + m_chunk)
+            {
+                if(fallocate(m_fd, FALLOC_FL_KEEP_SIZE, static_cast<off_t>(m_base + allocated), static_cast<off_t>(m_chunk)) != 0)
+                {
+                    if(errno == EINTR)
+                    {
+                        continue;
+                    }
+                    allocated = UINT64_MAX >> 1; // not supported or no space: writes allocate on their own
+                    break;
+                }
+                allocated += m_chunk;
+            }
+            m_allocated.store(allocated, std::memory_order_relaxed);
+            m_allocating.store(false, std::memory_order_release);
+#else
+            (void)end;
+#endif
+        }
+};
+
+
+#endif  // _CONCURRENT_APPENDER_H
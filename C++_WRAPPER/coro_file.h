@@ -0,0 +1,521 @@
+#ifndef _CORO_FILE_H
+#define _CORO_FILE_H
+
+// Header inclusion
+#include "file.h"             // for File and its exception classes
+#include "async_file.h"       // for AsyncIoEngine
+#include <condition_variable> // for waiting on completions
+#include <coroutine>          // for C++20 coroutines
+#include <deque>              // for the ready queue
+#include <exception>          // for carrying exceptions into the awaiting coroutine
+#include <mutex>              // for guarding the ready queue
+#include <optional>           // for Task results
+#include <system_error>       // for failed operations
+
+
+
+template <typename T = void>
+class Task;
+
+// Promise parts shared by Task<T> and Task<void>
+class TaskPromiseBase
+{
+    public:
+        std::coroutine_handle<> m_continuation; // coroutine awaiting this task
+        std::exception_ptr m_exception;         // exception escaping the task body
+
+        // Resumes the awaiting coroutine once the task body finished
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept
+            {
+                return false;
+            }
+
+            template <typename Promise>
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+            {
+                std::coroutine_handle<> continuation = handle.promise().m_continuation;
+                return continuation ? continuation : std::noop_coroutine();
+            }
+
+            void await_resume() noexcept {}
+        };
+
+        std::suspend_always initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        FinalAwaiter final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void unhandled_exception()
+        {
+            m_exception = std::current_exception();
+        }
+};
+
+template <typename T>
+class TaskPromise : public TaskPromiseBase
+{
+    public:
+        std::optional<T> m_value; // result of co_return
+
+        Task<T> get_return_object();
+
+        void return_value(T value)
+        {
+            m_value.emplace(std::move(value));
+        }
+
+        T result()
+        {
+            if(m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+            return std::move(*m_value);
+        }
+};
+
+template <>
+class TaskPromise<void> : public TaskPromiseBase
+{
+    public:
+        Task<void> get_return_object();
+
+        void return_void() {}
+
+        void result()
+        {
+            if(m_exception)
+            {
+                std::rethrow_exception(m_exception);
+            }
+        }
+};
+
+
+
+//==================== Task Class ====================
+// Lazily started coroutine returning T. Awaiting it starts the body and
+// resumes the awaiting coroutine when it finishes; exceptions escaping the
+// body are rethrown at the co_await.
+template <typename T>
+class Task
+{
+    public:
+        using promise_type = TaskPromise<T>;
+
+    private:
+        std::coroutine_handle<promise_type> m_handle;
+
+    public:
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        Task(Task&& other) noexcept : m_handle(other.m_handle)
+        {
+            other.m_handle = NULL;
+        }
+
+        Task& operator=(Task&& other) noexcept
+        {
+            if(this != &other)
+            {
+                if(m_handle)
+                {
+                    m_handle.destroy();
+                }
+                m_handle = other.m_handle;
+                other.m_handle = NULL;
+            }
+            return *this;
+        }
+
+        ~Task()
+        {
+            if(m_handle)
+            {
+                m_handle.destroy();
+            }
+        }
+
+        bool await_ready() const noexcept
+        {
+            return !m_handle || m_handle.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_handle.promise().m_continuation = awaiting;
+            return m_handle;
+        }
+
+        T await_resume()
+        {
+            return m_handle.promise().result();
+        }
+};
+
+template <typename T>
+inline Task<T> TaskPromise<T>::get_return_object()
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object()
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+
+
+//==================== IoExecutor Class ====================
+// Single-threaded executor for coroutines doing file I/O. All coroutines run
+// on the thread calling run(); their reads and writes go to an AsyncIoEngine,
+// and everything awaited during one round of resumptions is submitted as one
+// batch. One thread can so keep thousands of operations in flight.
+class IoExecutor
+{
+    private:
+        // Fire-and-forget coroutine wrapping a spawned Task
+        struct Detached
+        {
+            struct promise_type
+            {
+                Detached get_return_object() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never initial_suspend() noexcept
+                {
+                    return {};
+                }
+
+                std::suspend_never final_suspend() noexcept
+                {
+                    return {};
+                }
+
+                void return_void() noexcept {}
+
+                void unhandled_exception() noexcept
+                {
+                    std::terminate(); // run_root catches everything
+                }
+            };
+        };
+
+        // Suspends and puts the coroutine on the ready queue
+        struct ScheduleAwaiter
+        {
+            IoExecutor* m_executor;
+
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_executor->schedule(handle);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        std::mutex m_mutex;                          // guards m_ready and m_active
+        std::condition_variable m_cv;                // signals newly ready coroutines
+        std::deque<std::coroutine_handle<>> m_ready; // coroutines to resume
+        size_t m_active;                             // spawned tasks not finished yet
+        std::exception_ptr m_exception;              // first exception escaping a spawned task
+        AsyncIoEngine m_engine;                      // backend of all awaited operations, declared last so it
+                                                     // drains before the members its callbacks use are destroyed
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Creates the executor and its engine.
+        *
+        * @param[in]   queue_depth: maximum number of operations in flight.
+        * @param[in]   backend: AsyncIoEngine backend.
+        */
+        explicit IoExecutor(unsigned queue_depth = 1024, AsyncBackend backend = AsyncBackend::Auto)
+            : m_active(0), m_engine(queue_depth, backend)
+        {
+        }
+
+        IoExecutor(const IoExecutor&) = delete;
+        IoExecutor& operator=(const IoExecutor&) = delete;
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Adds a task to run on the next run().
+        */
+        void spawn(Task<void> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ++m_active;
+            }
+            run_root(std::move(task));
+        }
+
+        /***
+        * @brief       Runs coroutines until every spawned task finished.
+        *
+        * @throws      The first exception that escaped a spawned task.
+        */
+        void run()
+        {
+            for(;;)
+            {
+                std::coroutine_handle<> handle;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    if(m_ready.empty())
+                    {
+                        if(m_active == 0)
+                        {
+                            break;
+                        }
+                        lock.unlock();
+                        m_engine.submit(); // one batch for everything awaited this round
+                        lock.lock();
+                        m_cv.wait(lock, [this] { return !m_ready.empty() || m_active == 0; });
+                        continue;
+                    }
+                    handle = m_ready.front();
+                    m_ready.pop_front();
+                }
+                handle.resume();
+            }
+
+            if(m_exception)
+            {
+                std::exception_ptr exception = m_exception;
+                m_exception = NULL;
+                std::rethrow_exception(exception);
+            }
+        }
+
+        /***
+        * @brief       Queues a suspended coroutine for resumption, callable from any thread.
+        *
+        * @details     Notifies while holding the lock, so the executor can not return
+        *              from run() and be destroyed between the push and the notify.
+        */
+        void schedule(std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_ready.push_back(handle);
+            m_cv.notify_one();
+        }
+
+        /***
+        * @brief   To get the engine operations are queued on.
+        */
+        AsyncIoEngine& engine()
+        {
+            return m_engine;
+        }
+
+    private:
+        Detached run_root(Task<void> task)
+        {
+            co_await ScheduleAwaiter{this};
+            try
+            {
+                co_await task;
+            }
+            catch(...)
+            {
+                if(!m_exception)
+                {
+                    m_exception = std::current_exception();
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_active;
+        }
+};
+
+
+
+//==================== CoFile Class ====================
+// Coroutine front end of an open File: co_await read_async(span) and
+// write_async(span) suspend the calling coroutine instead of the thread.
+// The sequential forms use and advance the CoFile's own offset, like a
+// FileCursor, so only one of them may be in flight per CoFile; the File
+// must outlive every operation awaited on it.
+template <typename ThreadingPolicy>
+class BasicCoFile
+{
+    private:
+        BasicFile<ThreadingPolicy>* m_file; // File the operations go to
+        IoExecutor& m_executor;             // executor resuming the coroutines
+        int64_t m_offset;                   // position of the sequential forms
+
+        // Awaitable of one read or write
+        class Operation
+        {
+            private:
+                BasicCoFile* m_owner;          // NULL for the positional forms
+                IoExecutor& m_executor;
+                int m_fd;
+                int64_t m_offset;
+                void* m_buffer;
+                size_t m_len;
+                bool m_is_write;
+                int64_t m_result;               // bytes or -errno
+                std::exception_ptr m_exception; // set when the File was closed
+
+            public:
+                Operation(BasicCoFile* owner, BasicFile<ThreadingPolicy>& file, IoExecutor& executor,
+                          int64_t offset, void* buffer, size_t len, bool is_write)
+                    : m_owner(owner), m_executor(executor), m_fd(-1), m_offset(offset), m_buffer(buffer),
+                      m_len(len), m_is_write(is_write), m_result(0)
+                {
+                    try
+                    {
+                        m_fd = file.get_descriptor();
+                    }
+                    catch(...)
+                    {
+                        m_exception = std::current_exception();
+                    }
+                }
+
+                bool await_ready() const noexcept
+                {
+                    return m_exception != NULL;
+                }
+
+                void await_suspend(std::coroutine_handle<> handle)
+                {
+                    AsyncCallback callback = [this, handle](int64_t result) {
+                        m_result = result;
+                        m_executor.schedule(handle);
+                    };
+                    if(m_is_write)
+                    {
+                        m_executor.engine().prepare_write(m_fd, m_offset, m_buffer, m_len, std::move(callback));
+                    }
+                    else
+                    {
+                        m_executor.engine().prepare_read(m_fd, m_offset, m_buffer, m_len, std::move(callback));
+                    }
+                }
+
+                size_t await_resume()
+                {
+                    if(m_exception)
+                    {
+                        std::rethrow_exception(m_exception);
+                    }
+                    if(m_result < 0)
+                    {
+                        throw std::system_error(static_cast<int>(-m_result), std::generic_category(),
+                                                m_is_write ? "write_async" : "read_async");
+                    }
+                    if(m_owner)
+                    {
+                        m_owner->m_offset += m_result;
+                    }
+                    return static_cast<size_t>(m_result);
+                }
+        };
+
+    public:
+        /***
+        * @brief       Binds file to executor, starting at offset.
+        *
+        * @details     Pending buffered output of file is flushed so the reads see it.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        BasicCoFile(BasicFile<ThreadingPolicy>& file, IoExecutor& executor, int64_t offset = 0)
+            : m_file(&file), m_executor(executor), m_offset(offset)
+        {
+            file.flush();
+        }
+
+        /***
+        * @brief       Reads at the CoFile's offset and advances it by the bytes read.
+        *
+        * @return      awaitable of the bytes read. Awaiting throws bad_file_discriptor
+        *              if the File was closed, std::system_error if the read failed.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        Operation read_async(std::span<T, Extent> items)
+        {
+            return Operation(this, *m_file, m_executor, m_offset, items.data(), items.size_bytes(), false);
+        }
+
+        /***
+        * @brief       Reads at offset, the CoFile's offset is left alone.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        Operation read_async(int64_t offset, std::span<T, Extent> items)
+        {
+            return Operation(NULL, *m_file, m_executor, offset, items.data(), items.size_bytes(), false);
+        }
+
+        /***
+        * @brief       Writes at the CoFile's offset and advances it by the bytes written.
+        *
+        * @return      awaitable of the bytes written. Awaiting throws bad_file_discriptor
+        *              if the File was closed, std::system_error if the write failed.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        Operation write_async(std::span<T, Extent> items)
+        {
+            return Operation(this, *m_file, m_executor, m_offset,
+                             const_cast<std::remove_const_t<T>*>(items.data()), items.size_bytes(), true);
+        }
+
+        /***
+        * @brief       Writes at offset, the CoFile's offset is left alone.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        Operation write_async(int64_t offset, std::span<T, Extent> items)
+        {
+            return Operation(NULL, *m_file, m_executor, offset,
+                             const_cast<std::remove_const_t<T>*>(items.data()), items.size_bytes(), true);
+        }
+
+        /***
+        * @brief       Moves the sequential offset.
+        */
+        void seek(int64_t offset)
+        {
+            m_offset = offset;
+        }
+
+        /***
+        * @brief   To get the sequential offset.
+        */
+        int64_t tell() const
+        {
+            return m_offset;
+        }
+};
+
+using CoFile = BasicCoFile<MultiThreaded>;
+
+
+#endif  // _CORO_FILE_H
@@ -0,0 +1,489 @@
+#ifndef _DIRECT_FILE_H
+#define _DIRECT_FILE_H
+
+// Header inclusion
+#include "file.h"      // for BufferPool, FileError and the positional I/O helpers
+#include <cstdint>     // for file offsets
+#include <cstring>     // for memcpy, memset
+#include <string>      // for the filename
+#include <fcntl.h>     // for O_DIRECT, posix_fadvise, sync_file_range
+#include <sys/stat.h>  // for statx
+#include <unistd.h>    // for close, ftruncate
+
+
+
+// How DirectFile treats the page cache
+enum class DirectIo
+{
+    Auto,     // O_DIRECT, or the Fallback path on file systems that reject it
+    Required, // O_DIRECT only, opening fails where it is rejected
+    Fallback  // never O_DIRECT: write through the page cache and drop it behind
+};
+
+
+
+//==================== AlignedBuffer Class ====================
+// Page aligned buffer from BufferPool, returned on destruction. Page
+// alignment satisfies the O_DIRECT memory alignment of common block devices
+// (512 or 4096 bytes), and a full AlignedBuffer handed to DirectFile::write()
+// goes to the disk without being copied.
+class AlignedBuffer
+{
+    private:
+        char* m_data;    // page aligned memory
+        size_t m_size;   // size class, a power of two
+
+    public:
+        /***
+        * @brief       Takes a buffer of at least size bytes from BufferPool.
+        *
+        * @throws      std::bad_alloc: If a new buffer can not be allocated.
+        */
+        explicit AlignedBuffer(size_t size)
+            : m_data(NULL), m_size(BufferPool::round_size(size))
+        {
+            m_data = BufferPool::instance().acquire(m_size);
+        }
+
+        AlignedBuffer(const AlignedBuffer&) = delete;
+        AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+        ~AlignedBuffer() noexcept
+        {
+            BufferPool::instance().release(m_data, m_size);
+        }
+
+        char* data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+};
+
+
+
+//==================== DirectFile Class ====================
+// Sequential bulk reader or writer that keeps its data out of the page
+// cache, so exporting or scanning hundreds of GB does not evict the hot data
+// of other processes. With O_DIRECT every transfer is a whole number of
+// aligned blocks from an aligned staging buffer; the unaligned tail of a
+// written file is padded, written and cut back with ftruncate on close().
+// Where O_DIRECT is rejected the same calls go through the page cache and
+// each chunk is written back and dropped with sync_file_range and
+// POSIX_FADV_DONTNEED. stdio can not do O_DIRECT, hence a companion class
+// rather than a File mode. Used by one thread at a time. POSIX only.
+class DirectFile
+{
+    public:
+        static constexpr size_t default_buffer_size = 1 << 20; // staging buffer, one transfer
+        static constexpr size_t default_alignment = 4096;      // when the kernel does not report it
+
+    private:
+        int m_fd;                 // descriptor, -1 once closed
+        std::string m_filename;   // for error messages
+        bool m_writing;           // opened with "w"
+        bool m_direct;            // O_DIRECT is in effect
+        size_t m_alignment;       // offset and length alignment of transfers
+        AlignedBuffer m_buffer;   // staging buffer
+        size_t m_fill;            // bytes staged for writing, or valid for reading
+        size_t m_pos;             // next byte to hand out when reading
+        int64_t m_offset;         // file offset of the staging buffer
+        int64_t m_dropped;        // Fallback: bytes before this are written back and dropped
+        int m_error;              // errno of the first failed transfer, sticky
+        bool m_at_end;            // reading reached end of file
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Opens filename for sequential direct I/O.
+        *
+        * @param[in]   filename: name of the file to open/create.
+        * @param[in]   mode: "r" to read, "w" to create or truncate and write.
+        * @param[in]   direct: Auto, Required or Fallback.
+        * @param[in]   buffer_size: bytes per transfer, rounded up to a power of two.
+        *
+        * @throws      error_opning_file: If Unable to open the file, or O_DIRECT is
+        *              Required and rejected.
+        * @throws      std::invalid_argument: If mode is neither "r" nor "w".
+        */
+        DirectFile(const std::string& filename, const std::string& mode, DirectIo direct = DirectIo::Auto,
+                   size_t buffer_size = default_buffer_size)
+            : m_fd(-1), m_filename(filename), m_writing(mode == "w" || mode == "wb"), m_direct(false),
+              m_alignment(default_alignment), m_buffer(buffer_size < default_alignment ? default_alignment : buffer_size),
+              m_fill(0), m_pos(0), m_offset(0), m_dropped(0), m_error(0), m_at_end(false)
+        {
+            if(!m_writing && mode != "r" && mode != "rb")
+            {
+                throw std::invalid_argument("Error: DirectFile mode must be \"r\" or \"w\", got \"" + mode + "\"");
+            }
+
+            int flags = (m_writing ? (O_WRONLY | O_CREAT | O_TRUNC) : O_RDONLY) | O_CLOEXEC;
+            if(direct != DirectIo::Fallback)
+            {
+                m_fd = ::open(m_filename.c_str(), flags | O_DIRECT, 0666);
+                m_direct = m_fd >= 0;
+                if(m_fd < 0 && (errno != EINVAL || direct == DirectIo::Required))
+                {
+                    throw_open_error(mode, __func__, __LINE__);
+                }
+            }
+            if(m_fd < 0)
+            {
+                m_fd = ::open(m_filename.c_str(), flags, 0666);
+                if(m_fd < 0)
+                {
+                    throw_open_error(mode, __func__, __LINE__);
+                }
+            }
+
+            if(m_direct)
+            {
+                m_alignment = query_alignment();
+                if(m_alignment > BufferPool::alignment || m_buffer.size() % m_alignment != 0)
+                {
+                    // the staging buffer can not satisfy this device, keep the data out of the cache the other way
+                    if(direct == DirectIo::Required || !disable_direct())
+                    {
+                        int saved_errno = errno ? errno : EINVAL;
+                        ::close(m_fd);
+                        m_fd = -1;
+                        errno = saved_errno;
+                        throw_open_error(mode, __func__, __LINE__);
+                    }
+                }
+            }
+            if(!m_writing)
+            {
+                posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            }
+        }
+
+        DirectFile(const DirectFile&) = delete;
+        DirectFile& operator=(const DirectFile&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Writes the staged tail and closes the file.
+        */
+        ~DirectFile() noexcept
+        {
+            close();
+        }
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Appends size bytes.
+        *
+        * @details     Bytes are staged and written one full buffer at a time. When
+        *              nothing is staged, whole buffers of an aligned source, such as
+        *              an AlignedBuffer, are written straight from it.
+        *
+        * @return      number of bytes accepted, less than size after a failed transfer.
+        *
+        * @throws      bad_file_discriptor: If the file is not open for writing.
+        */
+        size_t write(const void* data, size_t size)
+        {
+            if(m_fd < 0 || !m_writing)
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            const char* bytes = static_cast<const char*>(data);
+            size_t done = 0;
+            while(done < size && m_error == 0)
+            {
+                size_t left = size - done;
+                if(m_fill == 0 && left >= m_buffer.size() && reinterpret_cast<uintptr_t>(bytes + done) % BufferPool::alignment == 0)
+                {
+                    size_t whole = left - left % m_buffer.size();
+                    if(!transfer_out(bytes + done, whole))
+                    {
+                        break;
+                    }
+                    done += whole;
+                    continue;
+                }
+
+                size_t take = m_buffer.size() - m_fill < left ? m_buffer.size() - m_fill : left;
+                memcpy(m_buffer.data() + m_fill, bytes + done, take);
+                m_fill += take;
+                done += take;
+                if(m_fill == m_buffer.size())
+                {
+                    if(!transfer_out(m_buffer.data(), m_fill))
+                    {
+                        break;
+                    }
+                    m_fill = 0;
+                }
+            }
+            return done;
+        }
+
+        /***
+        * @brief       Reads up to size bytes.
+        *
+        * @return      number of bytes read, less than size only at end of file or
+        *              after a failed transfer.
+        *
+        * @throws      bad_file_discriptor: If the file is not open for reading.
+        */
+        size_t read(void* data, size_t size)
+        {
+            if(m_fd < 0 || m_writing)
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            char* bytes = static_cast<char*>(data);
+            size_t done = 0;
+            while(done < size)
+            {
+                if(m_pos == m_fill)
+                {
+                    m_offset += static_cast<int64_t>(m_fill);
+                    m_pos = 0;
+                    m_fill = 0;
+                    if(m_at_end || m_error != 0 || !transfer_in())
+                    {
+                        break;
+                    }
+                    if(m_fill == 0)
+                    {
+                        break; // end of file
+                    }
+                }
+                size_t take = m_fill - m_pos < size - done ? m_fill - m_pos : size - done;
+                memcpy(bytes + done, m_buffer.data() + m_pos, take);
+                m_pos += take;
+                done += take;
+            }
+            return done;
+        }
+
+        /***
+        * @brief       Writes the staged bytes, pads the last block as O_DIRECT requires
+        *              and closes the file.
+        *
+        * @details     The padding is cut off again with ftruncate, so the file ends up
+        *              with exactly the bytes written. Safe to call twice.
+        *
+        * @return      true if every write, the truncate and close succeeded.
+        */
+        bool close() noexcept
+        {
+            if(m_fd < 0)
+            {
+                return m_error == 0;
+            }
+
+            if(m_writing && m_fill > 0 && m_error == 0)
+            {
+                int64_t end = m_offset + static_cast<int64_t>(m_fill);
+                size_t padded = m_direct ? (m_fill + m_alignment - 1) / m_alignment * m_alignment : m_fill;
+                memset(m_buffer.data() + m_fill, 0, padded - m_fill);
+                if(transfer_out(m_buffer.data(), padded) && padded != m_fill && ::ftruncate(m_fd, static_cast<off_t>(end)) != 0)
+                {
+                    m_error = errno;
+                }
+                m_fill = 0;
+            }
+            if(m_writing && !m_direct && m_error == 0)
+            {
+                drop_cache_behind(m_offset, true); // write back and drop what the last chunks left in the cache
+            }
+
+            if(::close(m_fd) != 0 && m_error == 0)
+            {
+                m_error = errno;
+            }
+            m_fd = -1;
+            return m_error == 0;
+        }
+
+        /***
+        * @brief       Makes everything written so far, except the staged tail, durable.
+        *
+        * @return      returns true on success otherwise false.
+        */
+        bool sync_data()
+        {
+            if(m_fd < 0)
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+            return m_error == 0 && file_detail::sync_descriptor(m_fd, true) == 0;
+        }
+
+
+
+        //==================== GETTER FUNCTIONS ====================
+        /***
+        * @brief   To check whether O_DIRECT is in effect, false on the Fallback path.
+        */
+        bool is_direct() const
+        {
+            return m_direct;
+        }
+
+        /***
+        * @brief   To get the offset and length alignment of transfers.
+        */
+        size_t alignment() const
+        {
+            return m_alignment;
+        }
+
+        /***
+        * @brief   To get the errno of the first failed transfer, 0 if none.
+        */
+        int error() const
+        {
+            return m_error;
+        }
+
+        /***
+        * @brief   To get the descriptor, -1 once closed.
+        */
+        int get_descriptor() const
+        {
+            return m_fd;
+        }
+
+    private:
+        /***
+        * @brief       Offset alignment O_DIRECT needs on this file, from statx where the
+        *              kernel reports it (Linux 6.1), otherwise default_alignment.
+        */
+        size_t query_alignment() const
+        {
+#if defined(__linux__) && defined(STATX_DIOALIGN)
+            struct statx info;
+            if(::statx(m_fd, "", AT_EMPTY_PATH, STATX_DIOALIGN, &info) == 0 && (info.stx_mask & STATX_DIOALIGN) &&
+               info.stx_dio_offset_align != 0)
+            {
+                size_t alignment = info.stx_dio_offset_align > info.stx_dio_mem_align ? info.stx_dio_offset_align : info.stx_dio_mem_align;
+                return alignment;
+            }
+#endif
+            return default_alignment;
+        }
+
+        // Switches an open descriptor to the Fallback path
+        bool disable_direct()
+        {
+            int flags = fcntl(m_fd, F_GETFL);
+            if(flags < 0 || fcntl(m_fd, F_SETFL, flags & ~O_DIRECT) != 0)
+            {
+                return false;
+            }
+            m_direct = false;
+            m_alignment = default_alignment;
+            return true;
+        }
+
+        /***
+        * @brief       Writes size bytes from data at m_offset and advances it.
+        */
+        bool transfer_out(const char* data, size_t size)
+        {
+            if(file_detail::pwrite_full(m_fd, data, size, m_offset) != size)
+            {
+                m_error = errno ? errno : EIO;
+                return false;
+            }
+            m_offset += static_cast<int64_t>(size);
+            if(!m_direct)
+            {
+                drop_cache_behind(m_offset, false);
+            }
+            return true;
+        }
+
+        /***
+        * @brief       Fills the staging buffer from m_offset.
+        */
+        bool transfer_in()
+        {
+            // Not pread_full: after a short read at end of file the next offset is unaligned
+            size_t got = 0;
+            while(got < m_buffer.size())
+            {
+                ssize_t ret = ::pread(m_fd, m_buffer.data() + got, m_buffer.size() - got, static_cast<off_t>(m_offset + static_cast<int64_t>(got)));
+                if(ret < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(ret < 0)
+                {
+                    m_error = errno;
+                    return false;
+                }
+                got += static_cast<size_t>(ret);
+                if(ret == 0 || got % m_alignment != 0)
+                {
+                    m_at_end = true;
+                    break;
+                }
+            }
+            m_fill = got;
+            if(!m_direct && got > 0)
+            {
+                posix_fadvise(m_fd, static_cast<off_t>(m_offset), static_cast<off_t>(got), POSIX_FADV_DONTNEED);
+            }
+            return true;
+        }
+
+        /***
+        * @brief       Fallback path: starts writeback of everything up to end and drops
+        *              the chunks before the last one, whose writeback had a whole
+        *              buffer's time to finish. all drops everything, waiting for it.
+        */
+        void drop_cache_behind(int64_t end, bool all)
+        {
+            int64_t limit = all ? end : end - static_cast<int64_t>(m_buffer.size());
+#if defined(__linux__)
+            ::sync_file_range(m_fd, static_cast<off_t>(m_dropped), static_cast<off_t>(end - m_dropped), SYNC_FILE_RANGE_WRITE);
+            if(limit > m_dropped)
+            {
+                ::sync_file_range(m_fd, static_cast<off_t>(m_dropped), static_cast<off_t>(limit - m_dropped),
+                                  SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            }
+#else
+            if(all)
+            {
+                file_detail::sync_descriptor(m_fd, true); // dirty pages can not be dropped
+            }
+#endif
+            if(limit > m_dropped)
+            {
+                posix_fadvise(m_fd, static_cast<off_t>(m_dropped), static_cast<off_t>(limit - m_dropped), POSIX_FADV_DONTNEED);
+                m_dropped = limit;
+            }
+        }
+
+        [[noreturn]] FILE_COLD_NOINLINE void throw_open_error(const std::string& mode, const char* function, int line) const
+        {
+            throw error_opning_file("Error: Failed to open \"" + m_filename + "\" for direct I/O with mode \"" + mode +
+                                    "\" - Reason: " + strerror(errno) + ". Line[" + std::to_string(line) +
+                                    "], Function[" + function + "], File[" + __FILE__ + "]");
+        }
+
+        [[noreturn]] FILE_COLD_NOINLINE void throw_bad_file_discriptor(const char* function, int line) const
+        {
+            throw bad_file_discriptor("Error: \"" + m_filename + "\" is not open for this DirectFile operation. Line[" +
+                                      std::to_string(line) + "], Function[" + function + "], File[" + __FILE__ + "]");
+        }
+};
+
+
+#endif  // _DIRECT_FILE_H
@@ -4,9 +4,51 @@
 // Header inclusion
 #include <cstdio>    // for C style i/o
 #include <cstdarg>   // for printing variadic argument list
+#include <cstring>   // for strerror
+#include <cerrno>    // for errno
 #include <iostream>  // for C++ style i/o
 #include <string>    // for C++ style string
 #include <stdexcept> // for exeption handling
+#include <cstdlib>   // for free/realloc of the line buffer
+#include <cstddef>   // for ptrdiff_t
+#include <iterator>  // for line iterator tags and std::default_sentinel_t
+#include <string_view> // for zero-copy line views
+#include <new>       // for aligned operator new
+#include <mutex>     // for guarding the buffer pool
+#include <map>       // for buffer pool size classes
+#include <vector>    // for buffer pool free lists
+#include <span>      // for typed bulk read/write
+#include <type_traits> // for restricting typed I/O to trivially copyable types
+#include <cstdint>   // for 64-bit file offsets
+#include <source_location> // for recording where a FileError was raised
+#include <system_error>    // for FileError::error_code
+#include <variant>   // for FileResult storage
+#include <optional>  // for FileResult<void> storage
+#include <array>     // for parsed format strings
+#include <charconv>  // for to_chars in print()
+#include <limits>    // for the longest to_chars result of a type
+#include <cmath>     // for std::signbit
+#include <tuple>     // for the fields returned by scan()
+#include <bit>       // for countr_zero/popcount in the byte scanners
+#if defined(__x86_64__) || defined(_M_X64)
+#include <emmintrin.h> // for the SSE2 byte scanners
+#if defined(__GNUC__) || defined(__clang__)
+#include <immintrin.h> // for the AVX2 byte scanners, enabled per function
+#define FILE_HAS_AVX2_DISPATCH 1
+#endif
+#endif
+#if !defined(_WIN32)
+#include <unistd.h>  // for pread, pwrite, ftruncate (POSIX only)
+#include <fcntl.h>   // for fallocate, posix_fallocate, posix_fadvise (POSIX only)
+#include <sys/stat.h> // for the source size in copy_to (POSIX only)
+#endif
+#if defined(__linux__)
+#include <sys/ioctl.h>    // for the FICLONERANGE reflink
+#include <sys/sendfile.h> // for sendfile
+#include <linux/fs.h>     // for FICLONERANGE
+#endif
+#include "file_stats.h"   // for the I/O statistics, empty unless FILE_ENABLE_STATS
+#include "file_trace.h"   // for the I/O trace recorder, empty unless FILE_ENABLE_TRACE
 
 
 
@@ -20,6 +62,37 @@ enum class SeekOrigin
 
 
 
+// Enum class for stream buffering mode
+enum class BufferMode
+{
+    Full = _IOFBF, // Flush when the buffer is full
+    Line = _IOLBF, // Flush on every newline or when the buffer is full
+    None = _IONBF  // No buffering, every call goes straight to the OS
+};
+
+
+
+// Enum class for the expected access pattern, passed to the kernel as a hint
+enum class AccessPattern
+{
+    Normal,     // Default readahead
+    Sequential, // Front to back scan, larger readahead
+    Random,     // Scattered lookups, no readahead
+    UseOnce,    // One pass, the page cache is released on close()
+    WillNeed    // Whole file is read soon, start loading it right away
+};
+
+
+
+// Compiler hints for the error paths
+#if defined(_MSC_VER)
+#define FILE_COLD_NOINLINE __declspec(noinline)
+#else
+#define FILE_COLD_NOINLINE __attribute__((noinline, cold))
+#endif
+
+
+
 // Exception Handling Classes
 // Custom Exception class for file opening error 
 class error_opning_file : public std::runtime_error
@@ -35,565 +108,4364 @@ class bad_file_discriptor : public std::runtime_error
         explicit bad_file_discriptor(const std::string& s) : runtime_error(s) {}
 };
 
+/***
+* @brief       Builds the error message and throws bad_file_discriptor.
+*
+* @details     Kept out of line so the is_open() check in every File member
+*              compiles to a single predictable branch instead of inlined
+*              string building.
+* 
+* @param[in]   function: name of the calling function (__func__).
+* @param[in]   line: line of the failed check (__LINE__).
+*
+* @throws      bad_file_discriptor: Always.
+*/
+[[noreturn]] FILE_COLD_NOINLINE inline void throw_bad_file_discriptor(const char* function, int line)
+{
+    std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(line) +
+    "], Function[" + function + "], File[" + __FILE__ + "]";
+    throw bad_file_discriptor(error_msg);
+}
+
 
 
-//==================== File Class ====================
-class File
+//==================== FileError Class ====================
+// Error of the non-throwing try_* API: the errno value and the place it was
+// raised. Copying one is as cheap as copying two pointers and an int, the
+// text is only built when message() is called.
+class FileError
 {
     private:
-        FILE* m_fp;              // For storing file pointer
-        std::string m_filename;  // for storing file name
-        
-        public:
-        //==================== CONSTRUCTORS ====================
+        int m_code;                      // errno value, EBADF for a closed file
+        std::source_location m_location; // caller of the failed try_* function
+
+    public:
+        /***
+        * @brief       Records code and where it happened.
+        *
+        * @param[in]   code: errno value.
+        * @param[in]   location: defaults to the caller's location.
+        */
+        explicit FileError(int code, std::source_location location = std::source_location::current()) noexcept
+            : m_code(code), m_location(location)
+        {
+        }
+
+        /***
+        * @brief       Records the current errno, EIO if a failing call left it at 0.
+        */
+        static FileError from_errno(std::source_location location = std::source_location::current()) noexcept
+        {
+            return FileError(errno ? errno : EIO, location);
+        }
+
+        /***
+        * @brief   To get the errno value.
+        */
+        int code() const noexcept
+        {
+            return m_code;
+        }
+
+        /***
+        * @brief   To get the code as a std::error_code in the generic category.
+        */
+        std::error_code error_code() const noexcept
+        {
+            return std::error_code(m_code, std::generic_category());
+        }
+
+        /***
+        * @brief   To get where the error was raised.
+        */
+        const std::source_location& location() const noexcept
+        {
+            return m_location;
+        }
+
+        /***
+        * @brief   Formats the error, in the same layout as the exception messages.
+        *
+        * @return  "<strerror>. Line[..], Function[..], File[..]"
+        */
+        FILE_COLD_NOINLINE std::string message() const
+        {
+            return std::string(strerror(m_code)) + ". Line[" + std::to_string(m_location.line()) +
+                   "], Function[" + m_location.function_name() + "], File[" + m_location.file_name() + "]";
+        }
+
+        /***
+        * @brief   Throws the error as std::system_error.
+        */
+        [[noreturn]] FILE_COLD_NOINLINE void throw_error() const
+        {
+            throw std::system_error(error_code(), message());
+        }
+};
+
+
+
+//==================== FileResult Class ====================
+// Value or FileError returned by the try_* API, a C++20 stand-in for
+// std::expected<T, FileError> with the same member names.
+template <typename T>
+class [[nodiscard]] FileResult
+{
+    private:
+        std::variant<T, FileError> m_storage; // index 0 on success, 1 on error
+
+    public:
+        FileResult(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : m_storage(std::in_place_index<0>, std::move(value))
+        {
+        }
+
+        FileResult(FileError error) noexcept : m_storage(std::in_place_index<1>, error)
+        {
+        }
+
+        bool has_value() const noexcept
+        {
+            return m_storage.index() == 0;
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return has_value();
+        }
+
+        /***
+        * @brief   To get the value.
+        *
+        * @throws  std::system_error: If the result holds an error.
+        */
+        T& value() &
+        {
+            if(!has_value())
+            {
+                error().throw_error();
+            }
+            return *std::get_if<0>(&m_storage);
+        }
+
+        const T& value() const&
+        {
+            if(!has_value())
+            {
+                error().throw_error();
+            }
+            return *std::get_if<0>(&m_storage);
+        }
+
+        T&& value() &&
+        {
+            return std::move(value());
+        }
+
+        /***
+        * @brief   To get the value, or fallback on error.
+        */
+        template <typename U>
+        T value_or(U&& fallback) const&
+        {
+            return has_value() ? **this : static_cast<T>(std::forward<U>(fallback));
+        }
+
+        template <typename U>
+        T value_or(U&& fallback) &&
+        {
+            return has_value() ? std::move(**this) : static_cast<T>(std::forward<U>(fallback));
+        }
+
+        // Unchecked access, has_value() must be true
+        T& operator*() & noexcept
+        {
+            return *std::get_if<0>(&m_storage);
+        }
+
+        const T& operator*() const& noexcept
+        {
+            return *std::get_if<0>(&m_storage);
+        }
+
+        T&& operator*() && noexcept
+        {
+            return std::move(*std::get_if<0>(&m_storage));
+        }
+
+        T* operator->() noexcept
+        {
+            return std::get_if<0>(&m_storage);
+        }
+
+        const T* operator->() const noexcept
+        {
+            return std::get_if<0>(&m_storage);
+        }
+
+        // Unchecked access, has_value() must be false
+        const FileError& error() const noexcept
+        {
+            return *std::get_if<1>(&m_storage);
+        }
+};
+
+// Result of the try_* functions that have nothing to return on success.
+template <>
+class [[nodiscard]] FileResult<void>
+{
+    private:
+        std::optional<FileError> m_error; // empty on success
+
+    public:
+        FileResult() noexcept = default;
+
+        FileResult(FileError error) noexcept : m_error(error)
+        {
+        }
+
+        bool has_value() const noexcept
+        {
+            return !m_error.has_value();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return has_value();
+        }
+
+        /***
+        * @brief   Checks for success.
+        *
+        * @throws  std::system_error: If the result holds an error.
+        */
+        void value() const
+        {
+            if(m_error)
+            {
+                m_error->throw_error();
+            }
+        }
+
+        // Unchecked access, has_value() must be false
+        const FileError& error() const noexcept
+        {
+            return *m_error;
+        }
+};
+
+
+
+#if !defined(_WIN32)
+// Helpers shared by File and FileCursor for descriptor level I/O
+namespace file_detail
+{
+    /***
+    * @brief        pread until len bytes, end of file or an error other than EINTR.
+    * 
+    * @return       number of bytes read.
+    */
+    inline size_t pread_full(int fd, void* buffer, size_t len, int64_t offset)
+    {
+        char* bytes = static_cast<char*>(buffer);
+        size_t done = 0;
+        while(done < len)
+        {
+            ssize_t ret = ::pread(fd, bytes + done, len - done, static_cast<off_t>(offset + static_cast<int64_t>(done)));
+            if(ret < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(ret <= 0)
+            {
+                break;
+            }
+            done += static_cast<size_t>(ret);
+        }
+        return done;
+    }
+
+    /***
+    * @brief        fdatasync (data_only) or fsync, retried on EINTR.
+    * 
+    * @return       0 on success otherwise -1 with errno set.
+    */
+    inline int sync_descriptor(int fd, bool data_only)
+    {
+        int ret;
+        do
+        {
+#if defined(__APPLE__)
+            (void)data_only;
+            ret = ::fsync(fd); // no fdatasync on macOS
+#else
+            ret = data_only ? ::fdatasync(fd) : ::fsync(fd);
+#endif
+        }
+        while(ret != 0 && errno == EINTR);
+        return ret;
+    }
+
+    /***
+    * @brief        pwrite until len bytes or an error other than EINTR.
+    * 
+    * @return       number of bytes written.
+    */
+    inline size_t pwrite_full(int fd, const void* buffer, size_t len, int64_t offset)
+    {
+        const char* bytes = static_cast<const char*>(buffer);
+        size_t done = 0;
+        while(done < len)
+        {
+            ssize_t ret = ::pwrite(fd, bytes + done, len - done, static_cast<off_t>(offset + static_cast<int64_t>(done)));
+            if(ret < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(ret <= 0)
+            {
+                break;
+            }
+            done += static_cast<size_t>(ret);
+        }
+        return done;
+    }
+
+    /***
+    * @brief        Directory part of path, "." when it has none.
+    */
+    inline std::string parent_directory(const std::string& path)
+    {
+        size_t slash = path.find_last_of('/');
+        if(slash == std::string::npos)
+        {
+            return ".";
+        }
+        return slash == 0 ? "/" : path.substr(0, slash);
+    }
+
+    /***
+    * @brief        fsyncs the directory holding path, so a name created, renamed
+    *               or removed there survives a crash.
+    *
+    * @return       0 on success otherwise -1 with errno set.
+    */
+    inline int sync_parent_directory(const std::string& path)
+    {
+        int fd = ::open(parent_directory(path).c_str(), O_RDONLY | O_CLOEXEC);
+        if(fd < 0)
+        {
+            return -1;
+        }
+        int ret = sync_descriptor(fd, false);
+        int saved_errno = errno;
+        ::close(fd);
+        errno = saved_errno;
+        return ret;
+    }
+
+    /***
+    * @brief        Passes pattern to the kernel with posix_fadvise over the whole file.
+    *
+    * @details      Hints are ignored where posix_fadvise does not exist (macOS).
+    * 
+    * @return       0 on success otherwise the error number, posix_fadvise does not set errno.
+    */
+    inline int advise_descriptor(int fd, AccessPattern pattern)
+    {
+#if defined(__APPLE__)
+        (void)fd;
+        (void)pattern;
+        return 0;
+#else
+        switch(pattern)
+        {
+            case AccessPattern::Sequential:
+                return posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+            case AccessPattern::Random:
+                return posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+            case AccessPattern::UseOnce:
+            {
+                // NOREUSE keeps the pages off the active list since Linux 6.3, a no-op before
+                int error = posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+                return error ? error : posix_fadvise(fd, 0, 0, POSIX_FADV_NOREUSE);
+            }
+            case AccessPattern::WillNeed:
+                return posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            case AccessPattern::Normal:
+            default:
+                return posix_fadvise(fd, 0, 0, POSIX_FADV_NORMAL);
+        }
+#endif
+    }
+
+    /***
+    * @brief        Writes back and evicts the cached pages of [offset, offset + length).
+    *
+    * @details      POSIX_FADV_DONTNEED skips dirty pages, so on Linux they are written
+    *               back with sync_file_range first. Not a durability barrier.
+    * 
+    * @return       0 on success otherwise the error number.
+    */
+    inline int drop_descriptor_cache(int fd, int64_t offset, int64_t length)
+    {
+#if defined(__APPLE__)
+        (void)fd;
+        (void)offset;
+        (void)length;
+        return EOPNOTSUPP;
+#else
+#if defined(__linux__)
+        int ret;
+        do
+        {
+            ret = sync_file_range(fd, static_cast<off_t>(offset), static_cast<off_t>(length),
+                                  SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+        }
+        while(ret != 0 && errno == EINTR);
+        if(ret != 0)
+        {
+            return errno;
+        }
+#endif
+        return posix_fadvise(fd, static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_DONTNEED);
+#endif
+    }
+}
+#endif
+
+
+namespace file_detail
+{
+    /***
+    * @brief        Checks an fopen style mode: r, w or a followed by flags from "+bxtemc"
+    *               and an optional ",ccs=" suffix.
+    *
+    * @details      freopen closes the stream before it parses the mode, so a bad
+    *               mode has to be caught beforehand.
+    */
+    inline bool is_valid_mode(const std::string& mode)
+    {
+        if(mode.empty() || (mode[0] != 'r' && mode[0] != 'w' && mode[0] != 'a'))
+        {
+            return false;
+        }
+        size_t end = mode.find(',');
+        return mode.find_first_not_of("+bxtemc", 1) >= end;
+    }
+}
+
+
+
+//==================== Threading Policies ====================
+// Locking stdio calls, one File may be shared between threads.
+struct MultiThreaded
+{
+    static constexpr bool shared = true; // statistics use atomic adds
+
+    static int get_char(FILE* fp)
+    {
+        return fgetc(fp);
+    }
+
+    static int put_char(int c, FILE* fp)
+    {
+        return fputc(c, fp);
+    }
+
+    static char* get_string(char* string, int max_char, FILE* fp)
+    {
+        return fgets(string, max_char, fp);
+    }
+
+    static bool put_string(const char* string, FILE* fp)
+    {
+        return fputs(string, fp) != EOF;
+    }
+
+    static bool put_bytes(const char* bytes, size_t length, FILE* fp)
+    {
+        return fwrite(bytes, 1, length, fp) == length;
+    }
+};
+
+// Unlocked stdio calls, no mutex lock/unlock per call. The File must only be
+// used by one thread at a time.
+struct SingleThreaded
+{
+    static constexpr bool shared = false; // statistics use plain adds
+
+#if defined(_WIN32)
+    static int get_char(FILE* fp)
+    {
+        return _fgetc_nolock(fp);
+    }
+
+    static int put_char(int c, FILE* fp)
+    {
+        return _fputc_nolock(c, fp);
+    }
+#else
+    static int get_char(FILE* fp)
+    {
+        return getc_unlocked(fp);
+    }
+
+    static int put_char(int c, FILE* fp)
+    {
+        return putc_unlocked(c, fp);
+    }
+#endif
+
+#if defined(_WIN32)
+    static bool put_bytes(const char* bytes, size_t length, FILE* fp)
+    {
+        return _fwrite_nolock(bytes, 1, length, fp) == length;
+    }
+#elif defined(__GLIBC__)
+    static bool put_bytes(const char* bytes, size_t length, FILE* fp)
+    {
+        return fwrite_unlocked(bytes, 1, length, fp) == length;
+    }
+#else
+    static bool put_bytes(const char* bytes, size_t length, FILE* fp)
+    {
+        for(size_t i = 0; i < length; ++i)
+        {
+            if(putc_unlocked(bytes[i], fp) == EOF)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+#endif
+
+#if defined(__GLIBC__)
+    static char* get_string(char* string, int max_char, FILE* fp)
+    {
+        return fgets_unlocked(string, max_char, fp);
+    }
+
+    static bool put_string(const char* string, FILE* fp)
+    {
+        return fputs_unlocked(string, fp) != EOF;
+    }
+#else
+    // fgets semantics: at most max_char-1 characters, stops after '\n'
+    static char* get_string(char* string, int max_char, FILE* fp)
+    {
+        if(max_char <= 0)
+        {
+            return NULL;
+        }
+
+        int length = 0;
+        while(length < max_char - 1)
+        {
+            int c = get_char(fp);
+            if(c == EOF)
+            {
+                if(length == 0 || ferror(fp))
+                {
+                    return NULL;
+                }
+                break;
+            }
+            string[length++] = static_cast<char>(c);
+            if(c == '\n')
+            {
+                break;
+            }
+        }
+        string[length] = '\0';
+
+        return string;
+    }
+
+    static bool put_string(const char* string, FILE* fp)
+    {
+        size_t length = strlen(string);
+#if defined(_WIN32)
+        return _fwrite_nolock(string, 1, length, fp) == length;
+#else
+        for(size_t i = 0; i < length; ++i)
+        {
+            if(putc_unlocked(string[i], fp) == EOF)
+            {
+                return false;
+            }
+        }
+        return true;
+#endif
+    }
+#endif
+};
+
+
+
+//==================== BufferPool Class ====================
+// Process-wide cache of page aligned stdio buffers. Buffers are bucketed by
+// power-of-two size so opening and closing many buffered files reuses the
+// same memory instead of allocating and freeing a buffer each time.
+class BufferPool
+{
+    public:
+        static constexpr size_t alignment = 4096;          // page aligned buffers
+        static constexpr size_t max_cached_per_size = 64;  // free buffers kept per size class
+
+        /***
+        * @brief   To get the process-wide pool.
+        *
+        * @details The pool is intentionally never destroyed so Files with static
+        *          storage duration can still return their buffers at exit.
+        */
+        static BufferPool& instance()
+        {
+            static BufferPool* pool = new BufferPool();
+            return *pool;
+        }
+
+        /***
+        * @brief       Rounds a requested size up to its size class.
+        *
+        * @return      next power of two, at least alignment.
+        */
+        static size_t round_size(size_t size)
+        {
+            size_t rounded = alignment;
+            while(rounded < size)
+            {
+                rounded *= 2;
+            }
+            return rounded;
+        }
+
+        /***
+        * @brief       Takes a buffer of at least size bytes from the pool.
+        *
+        * @param[in]   size: wanted size, must already be a size class from round_size().
+        *
+        * @return      aligned buffer, freshly allocated if the pool had none cached.
+        *
+        * @throws      std::bad_alloc: If a new buffer can not be allocated.
+        */
+        char* acquire(size_t size)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::vector<char*>& free_list = m_free[size];
+                if(!free_list.empty())
+                {
+                    char* buffer = free_list.back();
+                    free_list.pop_back();
+                    return buffer;
+                }
+            }
+
+            return static_cast<char*>(::operator new(size, std::align_val_t(alignment)));
+        }
+
+        /***
+        * @brief       Returns a buffer obtained from acquire() to the pool.
+        *
+        * @param[in]   buffer: buffer to return, NULL is ignored.
+        * @param[in]   size: size class the buffer was acquired with.
+        */
+        void release(char* buffer, size_t size) noexcept
+        {
+            if(!buffer)
+            {
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                std::vector<char*>& free_list = m_free[size];
+                if(free_list.size() < max_cached_per_size)
+                {
+                    try
+                    {
+                        free_list.push_back(buffer);
+                        return;
+                    }
+                    catch(const std::bad_alloc&)
+                    {
+                        // fall through and free it
+                    }
+                }
+            }
+
+            ::operator delete(buffer, std::align_val_t(alignment));
+        }
+
+        /***
+        * @brief   To get the number of free buffers currently cached.
+        */
+        size_t cached_count()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t count = 0;
+            for(const auto& size_class : m_free)
+            {
+                count += size_class.second.size();
+            }
+            return count;
+        }
+
+    private:
+        BufferPool() = default;
+
+        std::mutex m_mutex;                          // guards m_free
+        std::map<size_t, std::vector<char*>> m_free; // free buffers by size class
+};
+
+
+
+//==================== Compile-time Format Strings ====================
+// Format strings of File::print(). Placeholders are parsed and checked against
+// the argument types while compiling, so at run time only the precomputed
+// literal pieces are copied and the arguments converted with std::to_chars.
+namespace file_detail
+{
+    inline constexpr int max_format_width = 99;     // largest {:N} field width
+    inline constexpr int max_format_precision = 99; // largest {:.N} precision
+
+    // How an argument of print() is formatted
+    enum class FormatKind : unsigned char
+    {
+        Integer,   // to_chars in base 10, 16 or 2
+        Floating,  // to_chars fixed, scientific, general or shortest round trip
+        Character, // the character itself, or its code as an integer
+        Boolean,   // "true" / "false"
+        String     // anything convertible to std::string_view
+    };
+
+    template <typename T>
+    consteval FormatKind format_kind()
+    {
+        using U = std::remove_cvref_t<T>;
+        if constexpr(std::is_same_v<U, bool>)
+        {
+            return FormatKind::Boolean;
+        }
+        else if constexpr(std::is_same_v<U, char>)
+        {
+            return FormatKind::Character;
+        }
+        else if constexpr(std::is_integral_v<U>)
+        {
+            return FormatKind::Integer;
+        }
+        else if constexpr(std::is_floating_point_v<U>)
+        {
+            return FormatKind::Floating;
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const U&, std::string_view>,
+                          "File::print() formats integers, floating point, char, bool and strings only");
+            return FormatKind::String;
+        }
+    }
+
+    // Parsed "{:[0][width][.precision][type]}"
+    struct FormatSpec
+    {
+        char type = 0;              // 0 for the default, else one of d x X b c f e g s
+        bool zero_pad = false;      // pad numbers with '0' after the sign instead of ' '
+        unsigned char width = 0;    // minimum field width
+        signed char precision = -1; // -1 when not given
+    };
+
+    // Literal text between two placeholders
+    struct FormatPiece
+    {
+        unsigned short begin = 0;  // offset in the format string
+        unsigned short length = 0; // length including escape braces
+        bool escaped = false;      // contains "{{" or "}}"
+    };
+
+    // Not constexpr: reaching it while a format string is parsed fails the
+    // build, and the diagnostic shows the message passed in.
+    inline void format_error(const char*)
+    {
+    }
+
+    template <typename... Args>
+    class FormatString
+    {
+        private:
+            static constexpr size_t arg_count = sizeof...(Args);
+
+            const char* m_text;                                // the format string itself
+            std::array<FormatPiece, arg_count + 1> m_pieces;   // literal before each argument and after the last
+            std::array<FormatSpec, arg_count> m_specs;         // spec of each argument
+
+        public:
+            /***
+            * @brief       Parses and checks text while compiling.
+            *
+            * @details     Fails to compile when the placeholder count differs from the
+            *              argument count, a brace is unmatched, or a spec does not fit
+            *              its argument type.
+            */
+            template <typename S>
+                requires std::is_convertible_v<const S&, std::string_view>
+            consteval FormatString(const S& text) : m_text(NULL), m_pieces(), m_specs()
+            {
+                std::string_view view = text;
+                m_text = view.data();
+                parse(view);
+            }
+
+            const char* text() const
+            {
+                return m_text;
+            }
+
+            const FormatPiece& piece(size_t index) const
+            {
+                return m_pieces[index];
+            }
+
+            const FormatSpec& spec(size_t index) const
+            {
+                return m_specs[index];
+            }
+
+        private:
+            consteval void parse(std::string_view text)
+            {
+                constexpr FormatKind kinds[arg_count + 1] = {format_kind<Args>()..., FormatKind::String};
+
+                if(text.size() > 0xFFFF)
+                {
+                    format_error("format string longer than 65535 characters");
+                }
+
+                size_t arg = 0;
+                size_t begin = 0;
+                bool escaped = false;
+                for(size_t pos = 0; pos < text.size(); ++pos)
+                {
+                    char c = text[pos];
+                    if(c != '{' && c != '}')
+                    {
+                        continue;
+                    }
+                    if(pos + 1 < text.size() && text[pos + 1] == c)
+                    {
+                        escaped = true; // "{{" or "}}"
+                        ++pos;
+                        continue;
+                    }
+                    if(c == '}')
+                    {
+                        format_error("unmatched '}' in format string");
+                    }
+                    if(arg == arg_count)
+                    {
+                        format_error("more {} placeholders than arguments");
+                    }
+
+                    m_pieces[arg] = FormatPiece{static_cast<unsigned short>(begin), static_cast<unsigned short>(pos - begin), escaped};
+                    ++pos;
+                    if(pos < text.size() && text[pos] == ':')
+                    {
+                        ++pos;
+                        m_specs[arg] = parse_spec(text, pos, kinds[arg]);
+                    }
+                    if(pos >= text.size() || text[pos] != '}')
+                    {
+                        format_error("expected '}' in format string");
+                    }
+
+                    ++arg;
+                    begin = pos + 1;
+                    escaped = false;
+                }
+
+                if(arg != arg_count)
+                {
+                    format_error("fewer {} placeholders than arguments");
+                }
+                m_pieces[arg_count] = FormatPiece{static_cast<unsigned short>(begin), static_cast<unsigned short>(text.size() - begin), escaped};
+            }
+
+            static consteval FormatSpec parse_spec(std::string_view text, size_t& pos, FormatKind kind)
+            {
+                FormatSpec spec;
+                if(pos < text.size() && text[pos] == '0')
+                {
+                    spec.zero_pad = true;
+                    ++pos;
+                }
+
+                int width = 0;
+                while(pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+                {
+                    width = width * 10 + (text[pos++] - '0');
+                    if(width > max_format_width)
+                    {
+                        format_error("field width above 99");
+                    }
+                }
+                spec.width = static_cast<unsigned char>(width);
+
+                if(pos < text.size() && text[pos] == '.')
+                {
+                    ++pos;
+                    int precision = 0;
+                    size_t digits_begin = pos;
+                    while(pos < text.size() && text[pos] >= '0' && text[pos] <= '9')
+                    {
+                        precision = precision * 10 + (text[pos++] - '0');
+                        if(precision > max_format_precision)
+                        {
+                            format_error("precision above 99");
+                        }
+                    }
+                    if(pos == digits_begin)
+                    {
+                        format_error("missing digits after '.'");
+                    }
+                    spec.precision = static_cast<signed char>(precision);
+                }
+
+                if(pos < text.size() && text[pos] != '}')
+                {
+                    spec.type = text[pos++];
+                }
+
+                bool integer_type = spec.type == 0 || spec.type == 'd' || spec.type == 'x' || spec.type == 'X' || spec.type == 'b';
+                switch(kind)
+                {
+                    case FormatKind::Integer:
+                        if(!integer_type || spec.precision >= 0)
+                        {
+                            format_error("integer argument takes {}, {:d}, {:x}, {:X} or {:b} with an optional width");
+                        }
+                        break;
+                    case FormatKind::Floating:
+                        if(spec.type != 0 && spec.type != 'f' && spec.type != 'e' && spec.type != 'g')
+                        {
+                            format_error("floating point argument takes {}, {:f}, {:e} or {:g}");
+                        }
+                        break;
+                    case FormatKind::Character:
+                        if((spec.type != 'c' && !integer_type) || spec.precision >= 0 || (spec.zero_pad && (spec.type == 0 || spec.type == 'c')))
+                        {
+                            format_error("char argument takes {}, {:c} or an integer type");
+                        }
+                        break;
+                    case FormatKind::Boolean:
+                        if((spec.type != 0 && spec.type != 's') || spec.precision >= 0 || spec.zero_pad)
+                        {
+                            format_error("bool argument takes {} or {:s} with an optional width");
+                        }
+                        break;
+                    case FormatKind::String:
+                        if((spec.type != 0 && spec.type != 's') || spec.zero_pad)
+                        {
+                            format_error("string argument takes {} or {:s} with an optional width and precision");
+                        }
+                        break;
+                }
+
+                return spec;
+            }
+    };
+
+    // Stack buffer print() formats into. It is handed to the stream in one
+    // put_bytes() call per print(), or one per full buffer for long output.
+    template <typename ThreadingPolicy>
+    class FormatSink
+    {
+        public:
+            static constexpr size_t capacity = 512; // fits any formatted number with width and precision <= 99
+
+        private:
+            char m_buffer[capacity]; // pending output
+            size_t m_size;           // bytes used in m_buffer
+            FILE* m_fp;              // stream written to
+            bool m_ok;               // false once a write failed
+            size_t m_written;        // bytes handed to the stream so far
+
+        public:
+            explicit FormatSink(FILE* fp) : m_size(0), m_fp(fp), m_ok(true), m_written(0)
+            {
+            }
+
+            /***
+            * @brief   Makes room for length bytes, length must not exceed capacity.
+            *
+            * @return  where to write them, followed by commit().
+            */
+            char* reserve(size_t length)
+            {
+                if(capacity - m_size < length)
+                {
+                    flush();
+                }
+                return m_buffer + m_size;
+            }
+
+            void commit(size_t length)
+            {
+                m_size += length;
+            }
+
+            void append(const char* data, size_t length)
+            {
+                if(capacity - m_size < length)
+                {
+                    flush();
+                    if(length >= capacity)
+                    {
+                        m_ok = ThreadingPolicy::put_bytes(data, length, m_fp) && m_ok;
+                        m_written += length;
+                        return;
+                    }
+                }
+                memcpy(m_buffer + m_size, data, length);
+                m_size += length;
+            }
+
+            void fill(char c, size_t count)
+            {
+                while(count > 0)
+                {
+                    size_t chunk = count < capacity ? count : capacity;
+                    memset(reserve(chunk), c, chunk);
+                    commit(chunk);
+                    count -= chunk;
+                }
+            }
+
+            /***
+            * @brief   Copies a literal piece of text, turning "{{" and "}}" into single braces.
+            */
+            void append_piece(const char* text, const FormatPiece& piece)
+            {
+                const char* data = text + piece.begin;
+                if(!piece.escaped)
+                {
+                    append(data, piece.length);
+                    return;
+                }
+
+                for(size_t i = 0; i < piece.length; ++i)
+                {
+                    *reserve(1) = data[i];
+                    commit(1);
+                    if(data[i] == '{' || data[i] == '}')
+                    {
+                        ++i; // skip the second brace of the pair
+                    }
+                }
+            }
+
+            /***
+            * @brief   Writes what is left to the stream.
+            *
+            * @return  true if every write succeeded otherwise false.
+            */
+            bool finish()
+            {
+                flush();
+                return m_ok;
+            }
+
+            size_t written() const
+            {
+                return m_written;
+            }
+
+        private:
+            void flush()
+            {
+                if(m_size)
+                {
+                    m_ok = ThreadingPolicy::put_bytes(m_buffer, m_size, m_fp) && m_ok;
+                    m_written += m_size;
+                    m_size = 0;
+                }
+            }
+    };
+
+    /***
+    * @brief       Right-aligns the length characters at out in a field of spec.width.
+    *
+    * @return      length of the padded field.
+    */
+    inline size_t pad_number(char* out, size_t length, const FormatSpec& spec)
+    {
+        if(spec.width <= length)
+        {
+            return length;
+        }
+
+        size_t pad = spec.width - length;
+        size_t sign = (spec.zero_pad && (out[0] == '-' || out[0] == '+')) ? 1 : 0;
+        memmove(out + sign + pad, out + sign, length - sign);
+        memset(out + sign, spec.zero_pad ? '0' : ' ', pad);
+        return spec.width;
+    }
+
+    template <typename ThreadingPolicy, typename T>
+    void format_integer(FormatSink<ThreadingPolicy>& sink, const FormatSpec& spec, T value)
+    {
+        // base 2 needs one character per bit, plus the sign
+        constexpr size_t max_length = std::numeric_limits<T>::digits + 2;
+        size_t room = spec.width > max_length ? spec.width : max_length;
+
+        int base = (spec.type == 'x' || spec.type == 'X') ? 16 : (spec.type == 'b' ? 2 : 10);
+        char* out = sink.reserve(room);
+        std::to_chars_result result = std::to_chars(out, out + room, value, base);
+        size_t length = static_cast<size_t>(result.ptr - out);
+        if(spec.type == 'X')
+        {
+            for(size_t i = 0; i < length; ++i)
+            {
+                if(out[i] >= 'a' && out[i] <= 'f')
+                {
+                    out[i] = static_cast<char>(out[i] - 'a' + 'A');
+                }
+            }
+        }
+        sink.commit(pad_number(out, length, spec));
+    }
+
+    /***
+    * @brief       Fixed notation with precision <= 9 through integer arithmetic.
+    *
+    * @details     value * 10^precision is rounded to an integer. The product carries
+    *              at most half an ulp of error, so the result is only used when the
+    *              fraction is clearly away from the .5 tie; otherwise, and for values
+    *              too large or not finite, it gives up and to_chars does the exact
+    *              conversion. Output is identical to to_chars / printf("%.*f").
+    *
+    * @return      number of characters written to out, 0 if not handled.
+    */
+    inline size_t format_fixed_fast(char* out, double value, int precision)
+    {
+        static constexpr double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+        static constexpr uint64_t powers[] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+        double magnitude = value < 0 ? -value : value;
+        if(precision > 9 || !(magnitude < 1e15 / scales[precision]))
+        {
+            return 0; // NaN and infinity fail the comparison too
+        }
+
+        double scaled = magnitude * scales[precision];
+        double whole = static_cast<double>(static_cast<uint64_t>(scaled));
+        double fraction = scaled - whole;
+        double tolerance = scaled * 0x1p-51;
+        if(fraction > 0.5 - tolerance && fraction < 0.5 + tolerance)
+        {
+            return 0;
+        }
+        uint64_t digits = static_cast<uint64_t>(whole) + (fraction > 0.5 ? 1 : 0);
+
+        char* pos = out;
+        if(std::signbit(value))
+        {
+            *pos++ = '-';
+        }
+        pos = std::to_chars(pos, pos + 24, digits / powers[precision]).ptr;
+        if(precision > 0)
+        {
+            *pos++ = '.';
+            uint64_t decimals = digits % powers[precision];
+            for(int i = precision - 1; i >= 0; --i)
+            {
+                pos[i] = static_cast<char>('0' + decimals % 10);
+                decimals /= 10;
+            }
+            pos += precision;
+        }
+        return static_cast<size_t>(pos - out);
+    }
+
+    template <typename ThreadingPolicy, typename T>
+    void format_floating(FormatSink<ThreadingPolicy>& sink, const FormatSpec& spec, T value)
+    {
+        // Room for the longest result: every integer digit in fixed notation,
+        // otherwise digits, point, sign and a 5 digit exponent. Reserving no more
+        // than needed keeps short lines in a single write.
+        constexpr size_t capacity = FormatSink<ThreadingPolicy>::capacity;
+        int precision = spec.precision < 0 ? 6 : spec.precision;
+        size_t needed = (spec.type == 'f') ? std::numeric_limits<T>::max_exponent10 + precision + 4
+                                           : std::numeric_limits<T>::max_digits10 + precision + 12;
+        needed = needed > spec.width ? needed : spec.width;
+        size_t room = needed < capacity ? needed : capacity;
+
+        char* out = sink.reserve(room);
+        if constexpr(!std::is_same_v<T, long double>)
+        {
+            if(spec.type == 'f')
+            {
+                size_t length = format_fixed_fast(out, value, precision);
+                if(length)
+                {
+                    sink.commit(pad_number(out, length, spec));
+                    return;
+                }
+            }
+        }
+
+        std::to_chars_result result;
+        if(spec.type == 0 && spec.precision < 0)
+        {
+            result = std::to_chars(out, out + room, value); // shortest round trip
+        }
+        else
+        {
+            std::chars_format format = spec.type == 'f' ? std::chars_format::fixed
+                                     : spec.type == 'e' ? std::chars_format::scientific
+                                     : std::chars_format::general;
+            result = std::to_chars(out, out + room, value, format, precision);
+        }
+        if(result.ec != std::errc())
+        {
+            // only long double values above about 1e500 in fixed notation get
+            // here, they are formatted in a buffer sized for their digits
+            std::string wide(needed, '\0');
+            result = std::to_chars(wide.data(), wide.data() + needed, value, std::chars_format::fixed, precision);
+            sink.append(wide.data(), pad_number(wide.data(), static_cast<size_t>(result.ptr - wide.data()), spec));
+            return;
+        }
+        sink.commit(pad_number(out, static_cast<size_t>(result.ptr - out), spec));
+    }
+
+    template <typename ThreadingPolicy>
+    void format_text(FormatSink<ThreadingPolicy>& sink, const FormatSpec& spec, std::string_view text)
+    {
+        if(spec.precision >= 0 && text.size() > static_cast<size_t>(spec.precision))
+        {
+            text = text.substr(0, static_cast<size_t>(spec.precision));
+        }
+        sink.append(text.data(), text.size());
+        if(spec.width > text.size())
+        {
+            sink.fill(' ', spec.width - text.size()); // text is left-aligned
+        }
+    }
+
+    template <typename ThreadingPolicy, typename T>
+    void format_arg(FormatSink<ThreadingPolicy>& sink, const FormatSpec& spec, const T& value)
+    {
+        constexpr FormatKind kind = format_kind<T>();
+        if constexpr(kind == FormatKind::Integer)
+        {
+            format_integer(sink, spec, value);
+        }
+        else if constexpr(kind == FormatKind::Floating)
+        {
+            format_floating(sink, spec, value);
+        }
+        else if constexpr(kind == FormatKind::Character)
+        {
+            if(spec.type == 0 || spec.type == 'c')
+            {
+                format_text(sink, spec, std::string_view(&value, 1));
+            }
+            else
+            {
+                format_integer(sink, spec, static_cast<int>(value));
+            }
+        }
+        else if constexpr(kind == FormatKind::Boolean)
+        {
+            format_text(sink, spec, value ? std::string_view("true") : std::string_view("false"));
+        }
+        else
+        {
+            format_text(sink, spec, std::string_view(value));
+        }
+    }
+}
+
+
+
+//==================== Byte Scanning ====================
+// Kernels counting and finding one byte (or either of two) in a buffer, used
+// for newlines by count_lines() and parallel_lines() and for separators by
+// scan(). x86-64 always has SSE2; AVX2 is used when CPUID reports it. Other
+// targets get a word-at-a-time scalar version. lines() stays on getline,
+// which on glibc scans its read buffer with the same memchr.
+namespace file_detail
+{
+    // Set of kernels chosen once for the running CPU
+    struct ByteScanKernels
+    {
+        size_t (*count)(const char* data, size_t length, char byte);
+        const char* (*find)(const char* data, size_t length, char byte);
+        const char* (*find_either)(const char* data, size_t length, char first, char second);
+        const char* name;
+    };
+
+    // Bytes of word equal to the byte broadcast in pattern, as a 0x80 flag per byte (exact, no carries)
+    inline uint64_t match_bytes(uint64_t word, uint64_t pattern)
+    {
+        const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+        uint64_t x = word ^ pattern;
+        return ~(((x & low7) + low7) | x | low7);
+    }
+
+    inline size_t count_byte_scalar(const char* data, size_t length, char byte)
+    {
+        const uint64_t pattern = 0x0101010101010101ULL * static_cast<unsigned char>(byte);
+        size_t count = 0;
+        size_t i = 0;
+        for(; i + 8 <= length; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            count += static_cast<size_t>(std::popcount(match_bytes(word, pattern)));
+        }
+        for(; i < length; ++i)
+        {
+            count += data[i] == byte;
+        }
+        return count;
+    }
+
+    inline const char* find_byte_scalar(const char* data, size_t length, char byte)
+    {
+        return static_cast<const char*>(memchr(data, byte, length));
+    }
+
+    inline const char* find_either_scalar(const char* data, size_t length, char first, char second)
+    {
+        const uint64_t pattern_1 = 0x0101010101010101ULL * static_cast<unsigned char>(first);
+        const uint64_t pattern_2 = 0x0101010101010101ULL * static_cast<unsigned char>(second);
+        size_t i = 0;
+        for(; i + 8 <= length; i += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data + i, 8);
+            uint64_t hits = match_bytes(word, pattern_1) | match_bytes(word, pattern_2);
+            if(hits)
+            {
+                // first match in memory order, for either byte order of the host
+                for(size_t j = i; j < i + 8; ++j)
+                {
+                    if(data[j] == first || data[j] == second)
+                    {
+                        return data + j;
+                    }
+                }
+            }
+        }
+        for(; i < length; ++i)
+        {
+            if(data[i] == first || data[i] == second)
+            {
+                return data + i;
+            }
+        }
+        return NULL;
+    }
+
+#if defined(__x86_64__) || defined(_M_X64)
+    inline size_t count_byte_sse2(const char* data, size_t length, char byte)
+    {
+        const __m128i pattern = _mm_set1_epi8(byte);
+        const __m128i zero = _mm_setzero_si128();
+        size_t count = 0;
+        size_t i = 0;
+        while(i + 16 <= length)
+        {
+            // Per byte counters, each compare adds 1 (subtracting -1); summed before they can wrap
+            __m128i counters = zero;
+            size_t block_end = (length - i) / 16 > 255 ? i + 255 * 16 : i + (length - i) / 16 * 16;
+            for(; i < block_end; i += 16)
+            {
+                __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                counters = _mm_sub_epi8(counters, _mm_cmpeq_epi8(chunk, pattern));
+            }
+            __m128i sums = _mm_sad_epu8(counters, zero);
+            count += static_cast<size_t>(_mm_cvtsi128_si32(sums)) + static_cast<size_t>(_mm_extract_epi16(sums, 4));
+        }
+        return count + count_byte_scalar(data + i, length - i, byte);
+    }
+
+    inline const char* find_byte_sse2(const char* data, size_t length, char byte)
+    {
+        const __m128i pattern = _mm_set1_epi8(byte);
+        size_t i = 0;
+        for(; i + 16 <= length; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, pattern)));
+            if(mask)
+            {
+                return data + i + std::countr_zero(mask);
+            }
+        }
+        for(; i < length; ++i)
+        {
+            if(data[i] == byte)
+            {
+                return data + i;
+            }
+        }
+        return NULL;
+    }
+
+    inline const char* find_either_sse2(const char* data, size_t length, char first, char second)
+    {
+        const __m128i pattern_1 = _mm_set1_epi8(first);
+        const __m128i pattern_2 = _mm_set1_epi8(second);
+        size_t i = 0;
+        for(; i + 16 <= length; i += 16)
+        {
+            __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, pattern_1), _mm_cmpeq_epi8(chunk, pattern_2));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hits));
+            if(mask)
+            {
+                return data + i + std::countr_zero(mask);
+            }
+        }
+        return find_either_scalar(data + i, length - i, first, second);
+    }
+#endif
+
+#if defined(FILE_HAS_AVX2_DISPATCH)
+    __attribute__((target("avx2"))) inline size_t count_byte_avx2(const char* data, size_t length, char byte)
+    {
+        const __m256i pattern = _mm256_set1_epi8(byte);
+        const __m256i zero = _mm256_setzero_si256();
+        size_t count = 0;
+        size_t i = 0;
+        while(i + 32 <= length)
+        {
+            __m256i counters = zero;
+            size_t block_end = (length - i) / 32 > 255 ? i + 255 * 32 : i + (length - i) / 32 * 32;
+            for(; i < block_end; i += 32)
+            {
+                __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+                counters = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(chunk, pattern));
+            }
+            __m256i sums = _mm256_sad_epu8(counters, zero);
+            count += static_cast<size_t>(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1) +
+                                         _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+        }
+        return count + count_byte_sse2(data + i, length - i, byte);
+    }
+
+    __attribute__((target("avx2"))) inline const char* find_byte_avx2(const char* data, size_t length, char byte)
+    {
+        const __m256i pattern = _mm256_set1_epi8(byte);
+        size_t i = 0;
+        for(; i + 64 <= length; i += 64)
+        {
+            // Two vectors per step, the common case of no match costs one branch
+            __m256i hits_1 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i)), pattern);
+            __m256i hits_2 = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 32)), pattern);
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(hits_1, hits_2)));
+            if(mask)
+            {
+                unsigned first = static_cast<unsigned>(_mm256_movemask_epi8(hits_1));
+                if(first)
+                {
+                    return data + i + std::countr_zero(first);
+                }
+                return data + i + 32 + std::countr_zero(static_cast<unsigned>(_mm256_movemask_epi8(hits_2)));
+            }
+        }
+        return find_byte_sse2(data + i, length - i, byte);
+    }
+
+    __attribute__((target("avx2"))) inline const char* find_either_avx2(const char* data, size_t length, char first, char second)
+    {
+        const __m256i pattern_1 = _mm256_set1_epi8(first);
+        const __m256i pattern_2 = _mm256_set1_epi8(second);
+        size_t i = 0;
+        for(; i + 32 <= length; i += 32)
+        {
+            __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, pattern_1), _mm256_cmpeq_epi8(chunk, pattern_2));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hits));
+            if(mask)
+            {
+                return data + i + std::countr_zero(mask);
+            }
+        }
+        return find_either_sse2(data + i, length - i, first, second);
+    }
+#endif
+
+    // glibc's memchr is already an AVX2/EVEX kernel picked by CPUID, and beats ours on
+    // line-length distances; other C libraries get the SIMD find.
+    inline auto find_byte_native_or(const char* (*simd_find)(const char*, size_t, char))
+    {
+#if defined(__GLIBC__)
+        (void)simd_find;
+        return find_byte_scalar;
+#else
+        return simd_find;
+#endif
+    }
+
+    /***
+    * @brief       Picks the widest kernels the CPU supports, once per process.
+    */
+    inline const ByteScanKernels& byte_scan_kernels()
+    {
+        static const ByteScanKernels kernels = [] {
+#if defined(FILE_HAS_AVX2_DISPATCH)
+            if(__builtin_cpu_supports("avx2"))
+            {
+                return ByteScanKernels{count_byte_avx2, find_byte_native_or(find_byte_avx2), find_either_avx2, "avx2"};
+            }
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+            return ByteScanKernels{count_byte_sse2, find_byte_native_or(find_byte_sse2), find_either_sse2, "sse2"};
+#else
+            return ByteScanKernels{count_byte_scalar, find_byte_scalar, find_either_scalar, "scalar"};
+#endif
+        }();
+        return kernels;
+    }
+
+    /***
+    * @brief       Number of bytes equal to byte in [data, data + length).
+    */
+    inline size_t count_byte(const char* data, size_t length, char byte)
+    {
+        return byte_scan_kernels().count(data, length, byte);
+    }
+
+    /***
+    * @brief       First byte equal to byte in [data, data + length), NULL if none.
+    */
+    inline const char* find_byte(const char* data, size_t length, char byte)
+    {
+        return byte_scan_kernels().find(data, length, byte);
+    }
+
+    /***
+    * @brief       First byte equal to first or second in [data, data + length), NULL if none.
+    */
+    inline const char* find_either(const char* data, size_t length, char first, char second)
+    {
+        return byte_scan_kernels().find_either(data, length, first, second);
+    }
+}
+
+
+
+//==================== Typed Scanning ====================
+// Outcome of File::scan()
+enum class ScanStatus
+{
+    Ok,           // every field parsed
+    EndOfFile,    // no line left to read
+    ReadError,    // the stream reported an error, see errno
+    MissingField, // the line ended before all fields were found
+    InvalidField, // a field is not a valid value of its type
+    OutOfRange    // a numeric field does not fit its type
+};
+
+// Fields parsed by File::scan<Ts...>() from one line.
+template <typename... Ts>
+struct ScanResult
+{
+    std::tuple<Ts...> values{};             // parsed fields, value-initialized from the first failure on
+    size_t matched = 0;                     // number of fields parsed, like the return of sscanf
+    ScanStatus status = ScanStatus::Ok;     // why scanning stopped
+    size_t column = 0;                      // offset in line of the failing field, or of the line end
+    std::string_view line;                  // the line without '\n', valid until the next read
+
+    explicit operator bool() const
+    {
+        return status == ScanStatus::Ok;
+    }
+};
+
+namespace file_detail
+{
+    inline bool is_scan_space(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    // Splits one line into fields and parses them in order. Whitespace as the
+    // separator means runs of blanks separate fields, any other character
+    // separates fields exactly once ("1,,3" has an empty second field) and
+    // blanks around each field are ignored.
+    class LineScanner
+    {
+        private:
+            std::string_view m_line; // line being scanned
+            size_t m_pos;            // start of the next field
+            char m_separator;        // field separator
+            bool m_exhausted;        // no field left after the last separator
+
+        public:
+            ScanStatus status;       // set by the first failing parse()
+            size_t column;           // where that failure is
+            size_t matched;          // fields parsed so far
+
+            LineScanner(std::string_view line, char separator)
+                : m_line(line), m_pos(0), m_separator(separator), m_exhausted(false),
+                  status(ScanStatus::Ok), column(0), matched(0)
+            {
+            }
+
+            /***
+            * @brief        Parses the next field into value.
+            *
+            * @return       true on success, otherwise false with status and column set.
+            */
+            template <typename T>
+            bool parse(T& value)
+            {
+                std::string_view field;
+                if(!next_field(field))
+                {
+                    return fail(ScanStatus::MissingField, m_line.size());
+                }
+                size_t field_column = static_cast<size_t>(field.data() - m_line.data());
+
+                using U = std::remove_cv_t<T>;
+                if constexpr(std::is_same_v<U, std::string_view>)
+                {
+                    value = field;
+                }
+                else if constexpr(std::is_same_v<U, std::string>)
+                {
+                    value.assign(field.data(), field.size());
+                }
+                else if constexpr(std::is_same_v<U, char>)
+                {
+                    if(field.size() != 1)
+                    {
+                        return fail(ScanStatus::InvalidField, field_column);
+                    }
+                    value = field[0];
+                }
+                else
+                {
+                    static_assert(std::is_arithmetic_v<U> && !std::is_same_v<U, bool>,
+                                  "File::scan() parses integers, floating point, char, std::string and std::string_view only");
+
+                    const char* first = field.data();
+                    const char* last = field.data() + field.size();
+                    if(field.size() > 1 && first[0] == '+' && first[1] != '-')
+                    {
+                        ++first; // scanf accepts a leading '+', from_chars does not
+                    }
+                    std::from_chars_result result = std::from_chars(first, last, value);
+                    if(result.ec == std::errc::result_out_of_range)
+                    {
+                        return fail(ScanStatus::OutOfRange, field_column);
+                    }
+                    if(result.ec != std::errc() || result.ptr != last)
+                    {
+                        return fail(ScanStatus::InvalidField, field_column);
+                    }
+                }
+
+                ++matched;
+                return true;
+            }
+
+        private:
+            bool next_field(std::string_view& field)
+            {
+                if(is_scan_space(m_separator))
+                {
+                    while(m_pos < m_line.size() && is_scan_space(m_line[m_pos]))
+                    {
+                        ++m_pos;
+                    }
+                    size_t begin = m_pos;
+                    while(m_pos < m_line.size() && !is_scan_space(m_line[m_pos]))
+                    {
+                        ++m_pos;
+                    }
+                    field = m_line.substr(begin, m_pos - begin);
+                    return !field.empty();
+                }
+
+                if(m_exhausted)
+                {
+                    return false;
+                }
+                const char* found = find_byte(m_line.data() + m_pos, m_line.size() - m_pos, m_separator);
+                size_t end = found ? static_cast<size_t>(found - m_line.data()) : m_line.size();
+                if(!found)
+                {
+                    m_exhausted = true;
+                }
+                size_t begin = m_pos;
+                m_pos = end + 1;
+
+                while(begin < end && is_scan_space(m_line[begin]))
+                {
+                    ++begin;
+                }
+                while(end > begin && is_scan_space(m_line[end - 1]))
+                {
+                    --end;
+                }
+                field = m_line.substr(begin, end - begin);
+                return true;
+            }
+
+            bool fail(ScanStatus failure, size_t failure_column)
+            {
+                status = failure;
+                column = failure_column;
+                return false;
+            }
+    };
+}
+
+
+
+#if !defined(_WIN32)
+//==================== File Copying ====================
+// How File::copy_to() moved the bytes, cheapest first
+enum class CopyMethod
+{
+    None,          // nothing to copy
+    Reflink,       // FICLONERANGE, the files share extents until either is written (Btrfs, XFS)
+    CopyFileRange, // copy_file_range, copied inside the kernel or offloaded to the server (NFS, SMB)
+    Sendfile,      // sendfile, copied inside the kernel through the page cache
+    Buffered       // pread/pwrite loop through a user space buffer
+};
+
+// Outcome of File::copy_to() and copy_file()
+struct CopyResult
+{
+    uint64_t bytes = 0;                   // bytes copied
+    CopyMethod method = CopyMethod::None; // path that copied them
+};
+
+/***
+* @brief       Name of method for logs and benchmarks.
+*/
+inline const char* copy_method_name(CopyMethod method)
+{
+    switch(method)
+    {
+        case CopyMethod::Reflink:       return "reflink";
+        case CopyMethod::CopyFileRange: return "copy_file_range";
+        case CopyMethod::Sendfile:      return "sendfile";
+        case CopyMethod::Buffered:      return "buffered";
+        default:                        return "none";
+    }
+}
+
+namespace file_detail
+{
+    // Errors meaning "this copy path does not apply here", try the next one
+    inline bool copy_unsupported(int error)
+    {
+        return error == EINVAL || error == EXDEV || error == ENOSYS || error == EOPNOTSUPP ||
+               error == ENOTTY || error == EBADF || error == ETXTBSY || error == EPERM;
+    }
+
+    /***
+    * @brief       Copies count bytes from in at in_offset to out at out_offset.
+    *
+    * @details     Tries reflink, copy_file_range and sendfile on Linux, then a
+    *              pread/pwrite loop. A kernel path that fails before copying
+    *              anything hands over to the next; one that fails midway is an error.
+    *              Leaves the file offset of out unspecified.
+    *
+    * @param[out]  result: bytes copied and the path used, also on failure.
+    *
+    * @return      0 on success otherwise -1 with errno set.
+    */
+    inline int copy_descriptor_range(int in, int64_t in_offset, int out, int64_t out_offset, int64_t count, CopyResult& result)
+    {
+        result = CopyResult();
+        if(count <= 0)
+        {
+            return 0;
+        }
+
+#if defined(__linux__)
+#if defined(FICLONERANGE)
+        struct file_clone_range range;
+        range.src_fd = in;
+        range.src_offset = static_cast<uint64_t>(in_offset);
+        range.src_length = static_cast<uint64_t>(count);
+        range.dest_offset = static_cast<uint64_t>(out_offset);
+        if(::ioctl(out, FICLONERANGE, &range) == 0)
+        {
+            result.bytes = static_cast<uint64_t>(count);
+            result.method = CopyMethod::Reflink;
+            return 0;
+        }
+#endif
+
+        result.method = CopyMethod::CopyFileRange;
+        loff_t src = in_offset;
+        loff_t dst = out_offset;
+        while(result.bytes < static_cast<uint64_t>(count))
+        {
+            ssize_t ret = ::copy_file_range(in, &src, out, &dst, static_cast<size_t>(count) - result.bytes, 0);
+            if(ret < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if(ret < 0 && result.bytes == 0 && copy_unsupported(errno))
+            {
+                break;
+            }
+            if(ret < 0)
+            {
+                return -1;
+            }
+            if(ret == 0)
+            {
+                return 0; // end of the source file
+            }
+            result.bytes += static_cast<uint64_t>(ret);
+        }
+        if(result.bytes != 0)
+        {
+            return 0;
+        }
+
+        result.method = CopyMethod::Sendfile;
+        off_t src_offset = static_cast<off_t>(in_offset);
+        if(::lseek(out, static_cast<off_t>(out_offset), SEEK_SET) >= 0)
+        {
+            while(result.bytes < static_cast<uint64_t>(count))
+            {
+                ssize_t ret = ::sendfile(out, in, &src_offset, static_cast<size_t>(count) - result.bytes);
+                if(ret < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if(ret < 0 && result.bytes == 0 && copy_unsupported(errno))
+                {
+                    break;
+                }
+                if(ret < 0)
+                {
+                    return -1;
+                }
+                if(ret == 0)
+                {
+                    return 0;
+                }
+                result.bytes += static_cast<uint64_t>(ret);
+            }
+            if(result.bytes != 0)
+            {
+                return 0;
+            }
+        }
+#endif
+
+        result.method = CopyMethod::Buffered;
+        const size_t chunk = 1 << 20;
+        char* buffer = BufferPool::instance().acquire(chunk);
+        int ret = 0;
+        while(result.bytes < static_cast<uint64_t>(count))
+        {
+            uint64_t remaining = static_cast<uint64_t>(count) - result.bytes;
+            size_t want = remaining < chunk ? static_cast<size_t>(remaining) : chunk;
+            errno = 0;
+            size_t got = pread_full(in, buffer, want, in_offset + static_cast<int64_t>(result.bytes));
+            int read_errno = errno;
+
+            size_t put = pwrite_full(out, buffer, got, out_offset + static_cast<int64_t>(result.bytes));
+            result.bytes += put;
+            if(put != got)
+            {
+                ret = -1;
+                break;
+            }
+            if(got < want)
+            {
+                ret = read_errno != 0 ? -1 : 0; // short read: error, or end of the source file
+                errno = read_errno;
+                break;
+            }
+        }
+        int saved_errno = errno;
+        BufferPool::instance().release(buffer, chunk);
+        errno = saved_errno;
+        return ret;
+    }
+}
+#endif
+
+
+
+//==================== Operation Hooks ====================
+namespace file_detail
+{
+    // Statistics and trace hooks of one File call, both empty unless enabled
+    template <bool Shared>
+    class OpScope
+    {
+        private:
+            FileStatsScope<Shared> m_stats;
+            FileTraceScope m_trace;
+
+        public:
+            OpScope(const FileStatsHandle& stats, FileOp op, const char* name, FILE* const& fp, int64_t offset = -1) noexcept
+                : m_stats(stats, op), m_trace(op, name, fp, offset)
+            {
+            }
+
+            void add_bytes(uint64_t bytes) noexcept
+            {
+                m_stats.add_bytes(bytes);
+                m_trace.add_bytes(bytes);
+            }
+    };
+}
+
+
+
+//==================== File Class ====================
+// ThreadingPolicy selects locking (MultiThreaded) or unlocked (SingleThreaded)
+// stdio for the character and string operations. Use the File and
+// UnlockedFile aliases below.
+template <typename ThreadingPolicy>
+class BasicFile
+{
+    private:
+        FILE* m_fp;              // For storing file pointer
+        std::string m_filename;  // for storing file name
+        char* m_line_buf;        // reusable buffer behind lines(), grown on demand
+        size_t m_line_cap;       // capacity of m_line_buf in bytes
+        char* m_buffer;          // stdio buffer taken from BufferPool, NULL for libc's own
+        size_t m_buffer_capacity;// size class m_buffer was taken with
+        size_t m_buffer_size;    // buffer size set by set_buffer(), 0 for the libc default
+        BufferMode m_buffer_mode;// buffering mode set by set_buffer()
+        AccessPattern m_access_pattern; // kernel hint set by set_access_pattern()
+        [[no_unique_address]] FileStatsHandle m_stats; // I/O statistics, empty unless FILE_ENABLE_STATS
+        
+        public:
+        static constexpr size_t default_buffer_size = 64 * 1024; // buffer size used by set_buffer() by default
+
+        
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Open/Create file with provided filename and mode.
+        *
+        * @details     Open/Create file with provided filename and mode and 
+        *              stores file pointer in class's private variable member m_fp.
+        * 
+        * @param[in]   filename: name of the file to open/create.
+        * @param[in]   mode: mode in which file should open/create.
+        *
+        * @throws      error_opning_file: If Unable to Create/Open file.
+        */ 
+        BasicFile(const std::string& filename, const std::string& mode) : m_fp(NULL), m_filename(filename), m_line_buf(NULL), m_line_cap(0),
+                                                                   m_buffer(NULL), m_buffer_capacity(0), m_buffer_size(0), m_buffer_mode(BufferMode::Full),
+                                                                   m_access_pattern(AccessPattern::Normal)
+        {
+            if(!open(m_filename, mode))
+            {
+                throw_open_error("open", mode, errno, __func__, __LINE__);
+            }   
+        }
+
+        /***
+        * @brief       Open/Create file with provided filename, mode and buffering.
+        *
+        * @details     Same as BasicFile(filename, mode) followed by set_buffer(buffer_mode, buffer_size),
+        *              so the buffer is in place before the first I/O.
+        * 
+        * @param[in]   filename: name of the file to open/create.
+        * @param[in]   mode: mode in which file should open/create.
+        * @param[in]   buffer_mode: Full, Line or None buffering.
+        * @param[in]   buffer_size: size of the pooled buffer, ignored for BufferMode::None.
+        *
+        * @throws      error_opning_file: If Unable to Create/Open file or set its buffer.
+        */ 
+        BasicFile(const std::string& filename, const std::string& mode, BufferMode buffer_mode,
+                  size_t buffer_size = default_buffer_size) : BasicFile(filename, mode)
+        {
+            if(!set_buffer(buffer_mode, buffer_size))
+            {
+                throw error_opning_file("Error: Failed to set buffer of \"" + m_filename + "\" - Reason: " + strerror(errno) +
+                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]");
+            }
+        }
+
+        /***
+        * @brief       Open/Create file with provided filename, mode and access pattern.
+        *
+        * @details     The pattern is passed to the kernel right after opening, see
+        *              set_access_pattern(). A hint the kernel rejects does not fail the open.
+        * 
+        * @param[in]   filename: name of the file to open/create.
+        * @param[in]   mode: mode in which file should open/create.
+        * @param[in]   pattern: how the file is going to be read.
+        *
+        * @throws      error_opning_file: If Unable to Create/Open file.
+        */ 
+        BasicFile(const std::string& filename, const std::string& mode, AccessPattern pattern) : BasicFile(closed_tag())
+        {
+            if(!open(filename, mode, pattern))
+            {
+                throw_open_error("open", mode, errno, __func__, __LINE__);
+            }
+        }
+
+        /***
+        * @brief   Create temporary file.
+        *
+        * @details If user have not provided filename then this default construtor 
+        *          creates temporary file with mode "wb+". Removes when closed or 
+        *          programe gets terminated sucessfully.
+        *
+        * @throws  error_opning_file: If Unable to create temporary file.
+        */ 
+        BasicFile() : m_fp(NULL), m_line_buf(NULL), m_line_cap(0), m_buffer(NULL), m_buffer_capacity(0), m_buffer_size(0), m_buffer_mode(BufferMode::Full),
+                      m_access_pattern(AccessPattern::Normal)
+        {
+            m_fp = tmpfile();
+            if(!m_fp)
+            {
+                throw error_opning_file("Error: Unable to create temporary file - Reason: " + std::string(strerror(errno)) +
+                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]");
+            }
+            m_stats.attach("(tmpfile)");
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of BasicFile(filename, mode).
+        *
+        * @details     Meant for probing files that may legitimately be missing,
+        *              where an exception per miss would be the expensive path.
+        * 
+        * @param[in]   filename: name of the file to open/create.
+        * @param[in]   mode: mode in which file should open/create.
+        * @param[in]   location: recorded in the FileError, defaults to the caller.
+        *
+        * @return      the open File, or the errno of fopen.
+        */
+        static FileResult<BasicFile> try_open(const std::string& filename, const std::string& mode,
+                                              std::source_location location = std::source_location::current()) noexcept
+        {
+            BasicFile file{closed_tag()};
+            if(!file.open(filename, mode))
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<BasicFile>(std::move(file));
+        }
+
+#if !defined(_WIN32)
+        /***
+        * @brief       Wraps an open descriptor in a File with fdopen.
+        *
+        * @details     For descriptors that fopen can not produce, such as O_TMPFILE
+        *              files or ones from mkstemp. The File owns fd from this call on:
+        *              it is closed with the File, or right away on failure.
+        *
+        * @param[in]   fd: open descriptor, its access must allow mode.
+        * @param[in]   mode: fopen style mode, "w" does not truncate here.
+        * @param[in]   filename: name reported by get_filename() and in errors.
+        * @param[in]   location: recorded in the FileError, defaults to the caller.
+        *
+        * @return      the open File, or the errno of fdopen.
+        */
+        static FileResult<BasicFile> try_from_descriptor(int fd, const std::string& mode, const std::string& filename,
+                                                         std::source_location location = std::source_location::current()) noexcept
+        {
+            BasicFile file{closed_tag()};
+            file.m_filename = filename;
+            file.m_fp = fdopen(fd, mode.c_str());
+            if(file.m_fp == NULL)
+            {
+                FileError error = FileError::from_errno(location);
+                ::close(fd);
+                return error;
+            }
+            if(!file.apply_buffer())
+            {
+                FileError error = FileError::from_errno(location);
+                file.close();
+                return error;
+            }
+            file.m_stats.attach(filename);
+            return FileResult<BasicFile>(std::move(file));
+        }
+#endif
+
+        // Copying would duplicate m_fp and fclose it twice
+        BasicFile(const BasicFile&) = delete;
+        BasicFile& operator=(const BasicFile&) = delete;
+
+        /***
+        * @brief       Takes over the open file of other.
+        *
+        * @details     The stream, its pooled buffer and the line buffer change owner
+        *              without any allocation; other is left closed and may be
+        *              reopened with open().
+        * 
+        * @param[in]   other: File to move from.
+        */
+        BasicFile(BasicFile&& other) noexcept
+            : m_fp(other.m_fp), m_filename(std::move(other.m_filename)),
+              m_line_buf(other.m_line_buf), m_line_cap(other.m_line_cap),
+              m_buffer(other.m_buffer), m_buffer_capacity(other.m_buffer_capacity),
+              m_buffer_size(other.m_buffer_size), m_buffer_mode(other.m_buffer_mode),
+              m_access_pattern(other.m_access_pattern), m_stats(std::move(other.m_stats))
+        {
+            other.m_fp = NULL;
+            other.m_line_buf = NULL;
+            other.m_line_cap = 0;
+            other.m_buffer = NULL;
+            other.m_buffer_capacity = 0;
+        }
+
+        /***
+        * @brief       Closes the current file and takes over the open file of other.
+        * 
+        * @param[in]   other: File to move from, left closed.
+        */
+        BasicFile& operator=(BasicFile&& other) noexcept
+        {
+            if(this != &other)
+            {
+                close();
+                free(m_line_buf);
+
+                m_fp = other.m_fp;
+                m_filename = std::move(other.m_filename);
+                m_line_buf = other.m_line_buf;
+                m_line_cap = other.m_line_cap;
+                m_buffer = other.m_buffer;
+                m_buffer_capacity = other.m_buffer_capacity;
+                m_buffer_size = other.m_buffer_size;
+                m_buffer_mode = other.m_buffer_mode;
+                m_access_pattern = other.m_access_pattern;
+                m_stats = std::move(other.m_stats);
+
+                other.m_fp = NULL;
+                other.m_line_buf = NULL;
+                other.m_line_cap = 0;
+                other.m_buffer = NULL;
+                other.m_buffer_capacity = 0;
+            }
+            return *this;
+        }
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Closes opened/created file.
+        *
+        * @details Closes the opened/created file and clear the filename also.
+        */ 
+        ~BasicFile() noexcept
+        {
+            close();
+            m_filename.clear();
+            free(m_line_buf);
+        }
+
+
+
+        //==================== FILE STATUS/ERROR DETECTION ====================
+        /***
+        * @brief   Checks file open status.
+        *
+        * @details Uses m_fp variable member of class to check file opening status.
+        *          
+        * @return  true if m_fp is not NULL otherwise false.
+        */
+        bool is_open() const
+        {
+            return m_fp != NULL;
+        }
+
+        /***
+        * @brief   Checks any error indicator is active in file.
+        *          
+        * @return  true if any error indicator is active otherwise false
+        */
+        bool is_error() const
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+                
+            return ferror(m_fp) != 0;
+        }
+
+        /***
+        * @brief   Checks for end of file.
+        *          
+        * @return  true if end of file occured otherwise false.
+        */
+        bool is_eof() const
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return feof(m_fp) != 0;
+        }
+
+        /***
+        * @brief   Clears active error flags to perform further operations.
+        */
+        void clear_errors() 
+        {
+            if(is_open())
+            {
+                clearerr(m_fp);
+            }
+        }
+
+
+
+        //==================== HELPER FUNCTIONS ====================
+        /***
+        * @brief       Helper function to open file
+        *
+        * @details     First checks file is opened if yes then closes previously opened file
+        *              and opens/create new file with given mode and stores the file pointer
+        *              in private variable member m_fp.
+        * 
+        * @param[in]   filename:name of the file to open/create 
+        * @param[in]   mode:mode in which file is opened/created. 
+        * 
+        * @return      if file opened successfully then return true otherwise false. 
+        */
+        bool open(const std::string& filename, const std::string& mode) 
+        {
+            if(is_open())
+            {
+                close();
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Open, __func__, m_fp);
+            m_filename = filename; // assign input filename to class variable member m_filename
+            m_fp = fopen(m_filename.c_str(), mode.c_str()); // perform fopen operation
+            if(m_fp)
+            {
+                m_stats.attach(m_filename);
+            }
+
+            if(m_fp && !apply_buffer())
+            {
+                close();
+            }
+            if(m_fp)
+            {
+                apply_access_pattern();
+            }
+
+            return m_fp != NULL;
+        }
+
+        /***
+        * @brief       Helper function to open file with an access pattern.
+        *
+        * @details     Same as open(filename, mode) with set_access_pattern(pattern) applied
+        *              right after opening. The pattern sticks to the object.
+        * 
+        * @param[in]   filename:name of the file to open/create 
+        * @param[in]   mode:mode in which file is opened/created. 
+        * @param[in]   pattern: how the file is going to be read.
+        * 
+        * @return      if file opened successfully then return true otherwise false. 
+        */
+        bool open(const std::string& filename, const std::string& mode, AccessPattern pattern)
+        {
+            m_access_pattern = pattern;
+            return open(filename, mode);
+        }
+
+        /***
+        * @brief   Helper function to close file
+        *
+        * @details Checks if file is opened, if true then closes file and assign
+        *          NULL to file pointer variable. A pooled buffer goes back to
+        *          BufferPool once the stream no longer uses it. With AccessPattern::UseOnce
+        *          the file's pages are written back and dropped from the page cache first.
+        */
+        void close() 
+        {
+            if(m_fp)
+            {
+                file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Close, __func__, m_fp);
+#if !defined(_WIN32)
+                if(m_access_pattern == AccessPattern::UseOnce && fflush(m_fp) == 0)
+                {
+                    file_detail::drop_descriptor_cache(fileno(m_fp), 0, 0);
+                }
+#endif
+                fclose(m_fp);
+                m_fp = NULL;
+            }
+            release_buffer();
+        }
+
+        /***
+        * @brief       Sets the buffering policy of the stream.
+        *
+        * @details     Must be called before the first I/O on the file. Full and Line
+        *              buffers are taken from BufferPool, rounded up to a page aligned
+        *              power of two, and returned to it on close(). The policy sticks
+        *              to the object and is applied again by open() and reopen().
+        * 
+        * @param[in]   mode: Full, Line or None buffering.
+        * @param[in]   size: buffer size in bytes, 0 means default_buffer_size, ignored for None.
+        * 
+        * @return      true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        bool set_buffer(BufferMode mode, size_t size = default_buffer_size)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            m_buffer_mode = mode;
+            m_buffer_size = (mode == BufferMode::None) ? 0 : BufferPool::round_size(size ? size : default_buffer_size);
+
+            return apply_buffer();
+        }
+
+        /***
+        * @brief       Tells the kernel how the file is going to be read.
+        *
+        * @details     Applied with posix_fadvise over the whole file. Random turns readahead
+        *              off for scattered lookups, Sequential enlarges it, WillNeed starts
+        *              reading the whole file in the background and UseOnce also drops the
+        *              file's pages from the page cache on close(), so a one-pass scan does
+        *              not evict other data. Like the buffer, the pattern sticks to the object
+        *              and is applied again by open() and reopen(). Ignored where the
+        *              platform has no such hints.
+        * 
+        * @param[in]   pattern: Normal, Sequential, Random, UseOnce or WillNeed.
+        * 
+        * @return      true on success otherwise false, e.g. on a pipe.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        bool set_access_pattern(AccessPattern pattern)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_set_access_pattern(pattern).has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of set_access_pattern().
+        * 
+        * @return      nothing on success, EBADF if file is not open or the error of posix_fadvise.
+        *              The pattern is kept either way.
+        */
+        FileResult<void> try_set_access_pattern(AccessPattern pattern, std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+
+            m_access_pattern = pattern;
+#if !defined(_WIN32)
+            // posix_fadvise returns the error instead of setting errno
+            int error = file_detail::advise_descriptor(fileno(m_fp), pattern);
+            if(error != 0)
+            {
+                return FileError(error, location);
+            }
+#endif
+            return FileResult<void>();
+        }
+
+
+
+        //==================== FILE OPERATIONS ====================
+        /***
+        * @brief        Reads number of items(element_count) in file to buffer.
+        *
+        * @details      First check file is opened or not if opened then performs 
+        *               read operation otherwise throws exception.
+        * 
+        * @param[out]   ptr: buffer to store read items
+        * @param[in]    element_size: size of each element in bytes.
+        * @param[in]    element_count: number of element to read.
+        * 
+        * @return       number of items read.
+        */
+        size_t read(void* ptr, size_t element_size, size_t element_count) 
+        {
+            if(!is_open())
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_read(ptr, element_size, element_count).value_or(0); 
+        }
+
+        /***
+        * @brief       Writes number of items(element_count) in file from buffer.
+        *
+        * @details     First check file is opened or not if opened then performs 
+        *              write operation otherwise throws exception.
+        * 
+        * @param[in]   ptr: buffer to read data.
+        * @param[in]   element_size: size of each element in bytes.
+        * @param[in]   element_count: number of element to write from buffer.
+        * 
+        * @return      number of items written.
+        */
+        size_t write(const void* ptr, size_t element_size, size_t element_count) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_write(ptr, element_size, element_count).value_or(0);
+        }
+
+        /***
+        * @brief        Non-throwing counterpart of read(void*, size_t, size_t).
+        *
+        * @details      Like read(2), a short count is a success (end of file or an
+        *               error after some items); an error is only returned when
+        *               nothing could be read. The stream's error flag stays set
+        *               either way.
+        * 
+        * @param[out]   ptr: buffer to store read items
+        * @param[in]    element_size: size of each element in bytes.
+        * @param[in]    element_count: number of element to read.
+        * @param[in]    location: recorded in the FileError, defaults to the caller.
+        * 
+        * @return       number of items read, EBADF if file is not open or the errno of fread.
+        */
+        FileResult<size_t> try_read(void* ptr, size_t element_size, size_t element_count,
+                                    std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(element_size == 0 || element_count == 0)
+            {
+                return 0; // ptr may be NULL, which fread must not see
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp);
+            size_t items_readed = fread(ptr, element_size, element_count, m_fp);
+            scope.add_bytes(items_readed * element_size);
+            if(items_readed == 0 && ferror(m_fp))
+            {
+                return FileError::from_errno(location);
+            }
+
+            return items_readed;
+        }
+
+        /***
+        * @brief        Non-throwing counterpart of write(const void*, size_t, size_t).
+        *
+        * @details      Like write(2), a short count is a success; an error is only
+        *               returned when nothing could be written. The stream's error
+        *               flag stays set either way.
+        * 
+        * @param[in]    ptr: buffer to read data.
+        * @param[in]    element_size: size of each element in bytes.
+        * @param[in]    element_count: number of element to write from buffer.
+        * @param[in]    location: recorded in the FileError, defaults to the caller.
+        * 
+        * @return       number of items written, EBADF if file is not open or the errno of fwrite.
+        */
+        FileResult<size_t> try_write(const void* ptr, size_t element_size, size_t element_count,
+                                     std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(element_size == 0 || element_count == 0)
+            {
+                return 0; // ptr may be NULL, which fwrite must not see
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp);
+            size_t items_written = fwrite(ptr, element_size, element_count, m_fp);
+            scope.add_bytes(items_written * element_size);
+            if(items_written == 0 && ferror(m_fp))
+            {
+                return FileError::from_errno(location);
+            }
+
+            return items_written;
+        }
+
+        /***
+        * @brief        Reads elements into a span of trivially copyable objects.
+        *
+        * @details      Typed form of read(void*, size_t, size_t), the element size
+        *               and count come from the span.
+        * 
+        * @param[out]   items: elements to fill.
+        * 
+        * @return       number of elements read.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        size_t read(std::span<T, Extent> items)
+        {
+            return read(items.data(), sizeof(T), items.size());
+        }
+
+        /***
+        * @brief        Writes a span of trivially copyable objects.
+        *
+        * @details      Typed form of write(const void*, size_t, size_t), the element
+        *               size and count come from the span.
+        * 
+        * @param[in]    items: elements to write.
+        * 
+        * @return       number of elements written.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        size_t write(std::span<T, Extent> items)
+        {
+            return write(items.data(), sizeof(T), items.size());
+        }
+
+        /***
+        * @brief        Reads until the span is full, end of file or a real error.
+        *
+        * @details      Short transfers caused by interrupted system calls are
+        *               retried, and the loop runs over bytes so an element split
+        *               across two transfers is still completed. Bytes of a trailing
+        *               partial element at end of file are consumed but not counted.
+        * 
+        * @param[out]   items: elements to fill.
+        * 
+        * @return       number of complete elements read, items.size() on success.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        size_t read_exact(std::span<T, Extent> items)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp);
+            char* bytes = reinterpret_cast<char*>(items.data());
+            size_t total = items.size_bytes();
+            size_t done = 0;
+            while(done < total)
+            {
+                size_t transferred = fread(bytes + done, 1, total - done, m_fp);
+                scope.add_bytes(transferred);
+                done += transferred;
+                if(done < total)
+                {
+                    if(!ferror(m_fp) || errno != EINTR)
+                    {
+                        break; // end of file or a real error
+                    }
+                    clearerr(m_fp);
+                }
+            }
+
+            return done / sizeof(T);
+        }
+
+        /***
+        * @brief        Writes the whole span, retrying short transfers.
+        *
+        * @details      Short transfers caused by interrupted system calls are
+        *               retried, and the loop runs over bytes so an element split
+        *               across two transfers is still completed.
+        * 
+        * @param[in]    items: elements to write.
+        * 
+        * @return       number of complete elements written, items.size() on success.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        size_t write_all(std::span<T, Extent> items)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp);
+            const char* bytes = reinterpret_cast<const char*>(items.data());
+            size_t total = items.size_bytes();
+            size_t done = 0;
+            while(done < total)
+            {
+                size_t transferred = fwrite(bytes + done, 1, total - done, m_fp);
+                scope.add_bytes(transferred);
+                done += transferred;
+                if(done < total)
+                {
+                    if(!ferror(m_fp) || errno != EINTR)
+                    {
+                        break; // a real error, e.g. disk full
+                    }
+                    clearerr(m_fp);
+                }
+            }
+
+            return done / sizeof(T);
+        }
+
+        /***
+        * @brief        Creates temporary filename.
+        * 
+        * @param[out]   s: if provided then generated file name will stored is s.
+        * 
+        * @return       pointer to the internal static array.
+        * 
+        * @deprecated   this function is unsafe and deprecated so commenting out to prevent any harm..
+        */
+        // char* get_temp_name(char s[] = NULL)
+        // {
+        //     return tmpnam(s);
+        // }
+
+        /***
+        * @brief   Read next character from file.
+        * 
+        * @return  return read character or EOF for end of file or any error.
+        */
+        int getchar() 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            int c = ThreadingPolicy::get_char(m_fp);
+            m_stats.count<ThreadingPolicy::shared>(FileOp::Read, c != EOF ? 1 : 0);
+            return c;
+        }
+
+        /***
+        * @brief       Writes character.
+        * 
+        * @param[in]   c: Writes character c in file.
+        * 
+        * @return      return character written or EOF for end of file or any error.
+        */
+        int putchar(char c) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            int ret = ThreadingPolicy::put_char(c, m_fp);
+            m_stats.count<ThreadingPolicy::shared>(FileOp::Write, ret != EOF ? 1 : 0);
+            return ret;
+        }
+
+        /***
+        * @brief        Reads next input line from file.
+        * 
+        * @param[out]   string: read string will stored in string param.
+        * @param[in]    max_char: if given then atmost max_char-1 will be read otherwise 63 characters will be read
+        * 
+        * @return       returns read line or EOF for end of file or any error.
+        */
+        char* getstring(char* string, int max_char = 64) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp);
+            char* line = ThreadingPolicy::get_string(string, max_char, m_fp);
+            if(line)
+            {
+                scope.add_bytes(strlen(line));
+            }
+            return line;
+        }
+
+        /***
+        * @brief       Writes string in file.
+        * 
+        * @param[in]   string: write give 'string' in file.
+        * 
+        * @return      returns true on success or false on end of file or any error.
+        */
+        bool putstring(const char* string) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp);
+            bool ok = ThreadingPolicy::put_string(string, m_fp);
+            if(ok)
+            {
+                scope.add_bytes(strlen(string));
+            }
+            return ok;
+        }
+
+        /***
+        * @brief       Prints formatted input in the file.
+        * 
+        * @param[in]   format: format of the input string.
+        * @param[in]   ...: Variadic argument list.
+        * 
+        * @return      returns true if number of charactors written in file is positive otherwise false.
+        */
+        bool printInFile(const char* format, ...) const
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            } 
+
+            // create variadic argument list
+            va_list ap;
+            va_start(ap, format); // initialise it with first unknown argument
+        
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp);
+            int ret_val = vfprintf(m_fp, format, ap); // perform print in file operation
+            scope.add_bytes(ret_val > 0 ? static_cast<uint64_t>(ret_val) : 0);
+        
+            // close the variadic argument list
+            va_end(ap);
+
+            if(ret_val < 0)
+            {
+                return false;
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        /***
+        * @brief       Prints std::format-style formatted output in the file.
+        *
+        * @details     format is parsed while compiling, and a placeholder count or
+        *              spec that does not match args fails the build. Placeholders are
+        *              {} or {:[0][width][.precision][type]}: d x X b for integers,
+        *              f e g for floating point, c for char and s for strings and bool.
+        *              "{{" and "}}" print single braces. Numbers are converted with
+        *              std::to_chars into a stack buffer that goes to the stream in one
+        *              write, so no std::string is created. Output longer than
+        *              file_detail::FormatSink::capacity is written in several pieces.
+        * 
+        * @param[in]   format: format string literal.
+        * @param[in]   args: integers, floating point, char, bool or strings.
+        * 
+        * @return      true if all output was written otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename... Args>
+        bool print(file_detail::FormatString<std::type_identity_t<Args>...> format, const Args&... args)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp);
+            file_detail::FormatSink<ThreadingPolicy> sink(m_fp);
+            size_t index = 0;
+            ((sink.append_piece(format.text(), format.piece(index)),
+              file_detail::format_arg(sink, format.spec(index), args),
+              ++index), ...);
+            sink.append_piece(format.text(), format.piece(index));
+
+            bool ok = sink.finish();
+            scope.add_bytes(sink.written());
+            return ok;
+        }
+
+        /***
+        * @brief       Scans file
+        * 
+        * @param[in]   format: format of the arguments.
+        * @param[in]   ...: Variadic argument list which stores scanned items.
+        * 
+        * @return      returns false if EOF occured otherwise true.
+        */
+        bool scanInFile(const char* format, ...) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            // create variadic argument list
+            va_list ap;
+            va_start(ap, format); // initialise it with first unknown argument
+        
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp); // bytes are not known to vfscanf
+            int ret_val = vfscanf(m_fp, format, ap); // perform scan in file operation
+        
+            // close the variadic argument list
+            va_end(ap);
+
+            // check for error or end of file
+            if(ret_val != EOF)
+            {
+                return true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        /***
+        * @brief       Reads the next line and parses it into typed fields.
+        *
+        * @details     Typed replacement for scanInFile(). The line is read through the
+        *              same reusable buffer as lines(), so there is no per-line allocation,
+        *              and numbers are parsed with std::from_chars. Each field must be a
+        *              complete value: "12abc" is an InvalidField for int rather than 12.
+        *              Fields after the last requested one are ignored, like sscanf.
+        *              std::string_view fields point into the line buffer and are only
+        *              valid until the next read; use std::string to keep them.
+        * 
+        * @param[in]   separator: ' ' splits on runs of blanks, any other character splits
+        *              on every occurrence with blanks around fields trimmed.
+        * 
+        * @return      parsed fields, how many matched, and on failure the status and the
+        *              column of the offending field within result.line.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename... Ts>
+        ScanResult<Ts...> scan(char separator = ' ')
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            ScanResult<Ts...> result;
+            if(!read_line(result.line))
+            {
+                result.status = ferror(m_fp) ? ScanStatus::ReadError : ScanStatus::EndOfFile;
+                return result;
+            }
+
+            file_detail::LineScanner scanner(result.line, separator);
+            std::apply([&scanner](Ts&... fields) { (scanner.parse(fields) && ...); }, result.values);
+            result.matched = scanner.matched;
+            result.status = scanner.status;
+            result.column = scanner.status == ScanStatus::Ok ? result.line.size() : scanner.column;
+            return result;
+        }
+
+        /***
+        * @brief       reopens file with given mode.
+        * 
+        * @param[in]   mode: mode to change while reopening file.
+        * 
+        * @return      returns true on successfull reopening of the file otherwise throws exception.
+        */
+        bool reopen(const std::string& mode) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+            
+            FileResult<void> result = try_reopen(mode);
+            if(!result)
+            {
+                throw_open_error("reopen", mode, result.error().code(), __func__, __LINE__);
+            }
+
+            return true;
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of reopen().
+        * 
+        * @param[in]   mode: mode to change while reopening file.
+        * @param[in]   location: recorded in the FileError, defaults to the caller.
+        * 
+        * @return      nothing on success, EBADF if file is not open, EINVAL for an
+        *              invalid mode (the file stays open as it was) or the errno of
+        *              freopen, in which case the file is closed.
+        */
+        FileResult<void> try_reopen(const std::string& mode, std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(!file_detail::is_valid_mode(mode))
+            {
+                return FileError(EINVAL, location);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Open, __func__, m_fp);
+            m_fp = freopen(m_filename.c_str(), mode.c_str(), m_fp);
+            if(m_fp == NULL || !apply_buffer())
+            {
+                FileError error = FileError::from_errno(location);
+                close();
+                return error;
+            }
+            apply_access_pattern();
+
+            return FileResult<void>();
+        }
+
+        /***
+        * @brief   Flushes any buffered output before next statement.
+        * 
+        * @details Ensures that the data is read or written completely.
+        * 
+        * @return  true on success otherwise false.
+        */
+        bool flush() 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_flush().has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of flush().
+        * 
+        * @param[in]   location: recorded in the FileError, defaults to the caller.
+        * 
+        * @return      nothing on success, EBADF if file is not open or the errno of fflush.
+        */
+        FileResult<void> try_flush(std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Flush, __func__, m_fp);
+            if(fflush(m_fp) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+        }
+
+
+
+        //==================== LINE ITERATION ====================
+        // Input iterator over the lines of a File. Each dereference yields a view
+        // into the File's internal line buffer, valid until the next increment.
+        class LineIterator
+        {
+            private:
+                BasicFile* m_file;       // NULL once the end has been reached
+                std::string_view m_line; // current line without its '\n'
+
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type        = std::string_view;
+                using difference_type   = std::ptrdiff_t;
+                using pointer           = const std::string_view*;
+                using reference         = const std::string_view&;
+
+                LineIterator() : m_file(NULL) {}
+
+                explicit LineIterator(BasicFile* file) : m_file(file)
+                {
+                    ++(*this);
+                }
+
+                reference operator*() const
+                {
+                    return m_line;
+                }
+
+                pointer operator->() const
+                {
+                    return &m_line;
+                }
+
+                LineIterator& operator++()
+                {
+                    if(m_file && !m_file->read_line(m_line))
+                    {
+                        m_file = NULL;
+                    }
+                    return *this;
+                }
+
+                void operator++(int)
+                {
+                    ++(*this);
+                }
+
+                bool operator==(std::default_sentinel_t) const
+                {
+                    return m_file == NULL;
+                }
+        };
+
+        // Range returned by lines(), usable in range-for.
+        class LineRange
+        {
+            private:
+                BasicFile* m_file;
+
+            public:
+                explicit LineRange(BasicFile* file) : m_file(file) {}
+
+                LineIterator begin() const
+                {
+                    return LineIterator(m_file);
+                }
+
+                std::default_sentinel_t end() const
+                {
+                    return std::default_sentinel;
+                }
+        };
+
+        /***
+        * @brief   Iterates the remaining lines of the file without copying them out.
+        *
+        * @details Lines are read into one internal buffer that grows to the longest
+        *          line seen and is reused afterwards, so there is no per-line
+        *          allocation and no length limit. The yielded std::string_view does
+        *          not include the trailing '\n' and is only valid until the next
+        *          line is read. The stream position always sits right after the
+        *          last yielded line, so leaving the loop early is safe.
+        *
+        * @return  range of std::string_view, one per line.
+        *
+        * @throws  bad_file_discriptor: If file is not open.
+        */
+        LineRange lines()
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return LineRange(this);
+        }
+
+        /***
+        * @brief       Counts the lines from the current position to end of file.
+        *
+        * @details     Reads in 1 MiB blocks straight into a pooled buffer and counts
+        *              with the SSE2/AVX2 byte kernels instead of splitting lines. A
+        *              last line without a delimiter counts too, like lines() yields it.
+        *              The stream position is restored afterwards.
+        *
+        * @param[in]   delimiter: byte ending a line or record.
+        *
+        * @return      number of lines, 0 on a read error.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        uint64_t count_lines(char delimiter = '\n')
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_count_lines(delimiter).value_or(0);
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of count_lines().
+        *
+        * @return      number of lines, EBADF if file is not open, or the errno of the
+        *              failed read or position restore.
+        */
+        FileResult<uint64_t> try_count_lines(char delimiter = '\n',
+                                             std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            fpos_t start;
+            if(fgetpos(m_fp, &start) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+
+            const size_t block = 1 << 20;
+            char* buffer = BufferPool::instance().acquire(block);
+            uint64_t count = 0;
+            char last = delimiter;
+            size_t got;
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp);
+            while((got = fread(buffer, 1, block, m_fp)) > 0)
+            {
+                scope.add_bytes(got);
+                count += file_detail::count_byte(buffer, got, delimiter);
+                last = buffer[got - 1];
+            }
+            int read_errno = ferror(m_fp) ? (errno ? errno : EIO) : 0;
+            BufferPool::instance().release(buffer, block);
+
+            if(fsetpos(m_fp, &start) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            if(read_errno != 0)
+            {
+                return FileError(read_errno, location);
+            }
+            return count + (last != delimiter ? 1 : 0);
+        }
+
+
+
+        //==================== GETTER FUNCTIONS ====================
+#if !defined(_WIN32)
+        /***
+        * @brief   To get the OS file descriptor.
+        * 
+        * @details Used by the positional and descriptor level APIs. Bypasses the
+        *          stdio buffer, so flush() pending writes before using it.
+        * 
+        * @return  returns fileno of the stream.
+        *
+        * @throws  bad_file_discriptor: If file is not open.
+        */
+        int get_descriptor() const
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return fileno(m_fp);
+        }
+#endif
+
+        /***
+        * @brief   To get file handle.
+        * 
+        * @details Used to get file handle of type FILE*.
+        * 
+        * @return  returns file handle.
+        */
+        FILE* get_handle() const
+        {
+            return m_fp;
+        }
+
+        /***
+        * @brief   To get file name.
+        * 
+        * @details Used to get filename associated with the class object.
+        * 
+        * @return  returns file name
+        */
+        const std::string& get_filename() const 
+        {
+            return m_filename;
+        }
+
+        /***
+        * @brief   To get the access pattern set by set_access_pattern() or open().
+        */
+        AccessPattern access_pattern() const
+        {
+            return m_access_pattern;
+        }
+
+#if defined(FILE_ENABLE_STATS)
+        /***
+        * @brief   To get the I/O counters of this File since it was first opened.
+        *
+        * @details Only with FILE_ENABLE_STATS. Process totals, including closed
+        *          files, come from FileStatsRegistry::instance().totals().
+        */
+        FileStatsSnapshot stats() const
+        {
+            return m_stats.snapshot();
+        }
+#endif
+
+        
+
+        //==================== FILE POSITIONING ====================
+        /***
+        * @brief       Used to set file pointer.
+        * 
+        * @param[in]   offset: number of bytes to shift file pointer.
+        * @param[in]   origin: from where shifting of file pointer will be done.
+        *                  allowable mode: Set(from origin), Current(from current position of file pointer) 
+        *                  or End(from end of the file).
+        * 
+        * @return      returns true on success otherwise false.
+        */
+        bool seek(long offset, SeekOrigin origin) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_seek(offset, origin).has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of seek().
+        * 
+        * @return      nothing on success, EBADF if file is not open or the errno of fseek.
+        */
+        FileResult<void> try_seek(long offset, SeekOrigin origin, std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Seek, __func__, m_fp, offset);
+            if(fseek(m_fp, offset, static_cast<int>(origin)) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+        }
+    
+        /***
+        * @brief   To get current position of file pointer.
+        * 
+        * @return  return byte offset from file's base address to current position of file pointer.
+        */
+        long tell() const
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_tell().value_or(-1L);
+        }
+
+        /***
+        * @brief   Non-throwing counterpart of tell().
+        * 
+        * @return  byte offset of the file pointer, EBADF if file is not open or the errno of ftell.
+        */
+        FileResult<long> try_tell(std::source_location location = std::source_location::current()) const noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+
+            long offset = ftell(m_fp);
+            if(offset < 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return offset;
+        }
+    
         /***
-        * @brief       Open/Create file with provided filename and mode.
-        *
-        * @details     Open/Create file with provided filename and mode and 
-        *              stores file pointer in class's private variable member m_fp.
+        * @brief       64-bit form of seek(), for files past 2 GiB where long is 32 bits.
         * 
-        * @param[in]   filename: name of the file to open/create.
-        * @param[in]   mode: mode in which file should open/create.
-        *
-        * @throws      error_opning_file: If Unable to Create/Open file.
-        */ 
-        File(const std::string& filename, const std::string& mode) : m_fp(NULL), m_filename(filename)
+        * @param[in]   offset: number of bytes to shift file pointer.
+        * @param[in]   origin: Set, Current or End.
+        * 
+        * @return      returns true on success otherwise false.
+        */
+        bool seek64(int64_t offset, SeekOrigin origin) 
         {
-            if(!open(m_filename, mode))
+            if (!is_open()) 
             {
-                
-                std::string error_msg = "Error: Failed to open \"" + m_filename + "\" with mode \"" + mode +
-                                        "\" - Reason: " + strerror(errno) + 
-                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw error_opning_file(error_msg);
-                
-            }   
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_seek64(offset, origin).has_value();
         }
 
         /***
-        * @brief   Create temporary file.
-        *
-        * @details If user have not provided filename then this default construtor 
-        *          creates temporary file with mode "wb+". Removes when closed or 
-        *          programe gets terminated sucessfully.
-        *
-        * @throws  error_opning_file: If Unable to create temporary file.
-        */ 
-        File()
+        * @brief       Non-throwing counterpart of seek64().
+        * 
+        * @return      nothing on success, EBADF if file is not open or the errno of fseeko.
+        */
+        FileResult<void> try_seek64(int64_t offset, SeekOrigin origin, std::source_location location = std::source_location::current()) noexcept
         {
-            m_fp = tmpfile();
-            if(!m_fp)
+            if(!is_open())
             {
-                std::string error_msg = "Error: Unable to create temporary file. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw error_opning_file(error_msg);
+                return FileError(EBADF, location);
             }
-        }
-
 
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Seek, __func__, m_fp, offset);
+#if defined(_WIN32)
+            int ret = _fseeki64(m_fp, offset, static_cast<int>(origin));
+#else
+            int ret = fseeko(m_fp, static_cast<off_t>(offset), static_cast<int>(origin));
+#endif
+            if(ret != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+        }
 
-        //==================== DESTRUCTOR ====================
         /***
-        * @brief   Closes opened/created file.
-        *
-        * @details Closes the opened/created file and clear the filename also.
-        */ 
-        ~File() noexcept
+        * @brief   64-bit form of tell().
+        * 
+        * @return  byte offset of the file pointer, -1 on error.
+        */
+        int64_t tell64() const
         {
-            close();
-            m_filename.clear();
-        }
-
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
 
+            return try_tell64().value_or(-1);
+        }
 
-        //==================== FILE STATUS/ERROR DETECTION ====================
         /***
-        * @brief   Checks file open status.
-        *
-        * @details Uses m_fp variable member of class to check file opening status.
-        *          
-        * @return  true if m_fp is not NULL otherwise false.
+        * @brief   Non-throwing counterpart of tell64().
+        * 
+        * @return  byte offset of the file pointer, EBADF if file is not open or the errno of ftello.
         */
-        bool is_open() const
+        FileResult<int64_t> try_tell64(std::source_location location = std::source_location::current()) const noexcept
         {
-            return m_fp != NULL;
-        }
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
 
+#if defined(_WIN32)
+            int64_t offset = _ftelli64(m_fp);
+#else
+            int64_t offset = static_cast<int64_t>(ftello(m_fp));
+#endif
+            if(offset < 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return offset;
+        }
+    
         /***
-        * @brief   Checks any error indicator is active in file.
-        *          
-        * @return  true if any error indicator is active otherwise false
+        * @brief   Sets file pointer to begining.
         */
-        bool is_error() const
+        void rewind() 
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
-                
-            return ferror(m_fp) != 0;
+
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Seek, __func__, m_fp);
+            ::rewind(m_fp); 
         }
 
         /***
-        * @brief   Checks for end of file.
-        *          
-        * @return  true if end of file occured otherwise false.
+        * @brief        Records current file position.
+        * 
+        * @param[out]   pos: stores current file position in fpos_t data types variable.
+        * 
+        * @return       return true on success otherwise false.
         */
-        bool is_eof() const
+        bool get_pos(fpos_t* pos) 
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            return feof(m_fp) != 0;
+            FileResult<fpos_t> result = try_get_pos();
+            if(result)
+            {
+                *pos = *result;
+            }
+            return result.has_value();
         }
 
         /***
-        * @brief   Clears active error flags to perform further operations.
+        * @brief   Non-throwing counterpart of get_pos().
+        * 
+        * @return  current file position, EBADF if file is not open or the errno of fgetpos.
         */
-        void clear_errors() 
+        FileResult<fpos_t> try_get_pos(std::source_location location = std::source_location::current()) noexcept
         {
-            if(is_open())
+            if(!is_open())
             {
-                clearerr(m_fp);
+                return FileError(EBADF, location);
+            }
+
+            fpos_t pos;
+            if(fgetpos(m_fp, &pos) != 0)
+            {
+                return FileError::from_errno(location);
             }
+            return pos;
         }
 
+        /***
+        * @brief       Sets previously Recorded file position.
+        * 
+        * @param[in]   pos: Priviously recorded file position
+        * 
+        * @return      return true on success otherwise false.
+        */
+        bool set_pos(const fpos_t* pos) 
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
 
+            return try_set_pos(*pos).has_value();
+        }    
 
-        //==================== HELPER FUNCTIONS ====================
         /***
-        * @brief       Helper function to open file
-        *
-        * @details     First checks file is opened if yes then closes previously opened file
-        *              and opens/create new file with given mode and stores the file pointer
-        *              in private variable member m_fp.
+        * @brief       Non-throwing counterpart of set_pos().
         * 
-        * @param[in]   filename:name of the file to open/create 
-        * @param[in]   mode:mode in which file is opened/created. 
+        * @param[in]   pos: Priviously recorded file position
         * 
-        * @return      if file opened successfully then return true otherwise false. 
+        * @return      nothing on success, EBADF if file is not open or the errno of fsetpos.
         */
-        bool open(const std::string& filename, const std::string& mode) 
+        FileResult<void> try_set_pos(const fpos_t& pos, std::source_location location = std::source_location::current()) noexcept
         {
-            if(is_open())
+            if(!is_open())
             {
-                close();
+                return FileError(EBADF, location);
             }
 
-            m_filename = filename; // assign input filename to class variable member m_filename
-            m_fp = fopen(m_filename.c_str(), mode.c_str()); // perform fopen operation
-
-            return m_fp != NULL;
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Seek, __func__, m_fp);
+            if(fsetpos(m_fp, &pos) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
         }
 
+#if !defined(_WIN32)
+        //==================== POSITIONAL I/O ====================
         /***
-        * @brief   Helper function to close file
+        * @brief        Reads elements at an absolute offset without moving the stream position.
         *
-        * @details Checks if file is opened, if true then closes file and assign
-        *          NULL to file pointer variable.
+        * @details      Uses pread on the descriptor, so any number of threads may call
+        *               it on one File at once. The stdio buffer is bypassed: flush()
+        *               buffered writes first if the region was just written through
+        *               write() or putstring().
+        * 
+        * @param[in]    offset: byte offset in the file, 64 bit on every platform.
+        * @param[out]   items: elements to fill.
+        * 
+        * @return       number of complete elements read.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
         */
-        void close() 
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        size_t read_at(int64_t offset, std::span<T, Extent> items) const
         {
-            if(m_fp)
-            {
-                fclose(m_fp);
-                m_fp = NULL;
-            }
+            int fd = get_descriptor();
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp, offset);
+            size_t done = file_detail::pread_full(fd, items.data(), items.size_bytes(), offset);
+            scope.add_bytes(done);
+            return done / sizeof(T);
         }
 
+        /***
+        * @brief        Writes elements at an absolute offset without moving the stream position.
+        *
+        * @details      Uses pwrite on the descriptor, so any number of threads may call
+        *               it on one File at once. The stdio buffer is bypassed, and files
+        *               opened in append mode ignore offset on Linux.
+        * 
+        * @param[in]    offset: byte offset in the file, 64 bit on every platform.
+        * @param[in]    items: elements to write.
+        * 
+        * @return       number of complete elements written.
+        *
+        * @throws       bad_file_discriptor: If file is not open.
+        */
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        size_t write_at(int64_t offset, std::span<T, Extent> items)
+        {
+            int fd = get_descriptor();
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Write, __func__, m_fp, offset);
+            size_t done = file_detail::pwrite_full(fd, items.data(), items.size_bytes(), offset);
+            scope.add_bytes(done);
+            return done / sizeof(T);
+        }
 
 
-        //==================== FILE OPERATIONS ====================
+        //==================== FILE SPACE ====================
         /***
-        * @brief        Reads number of items(element_count) in file to buffer.
+        * @brief       Reserves disk blocks for [offset, offset + length) ahead of writing.
         *
-        * @details      First check file is opened or not if opened then performs 
-        *               read operation otherwise throws exception.
+        * @details     One large allocation gives sequential writers contiguous extents
+        *              and spares them a block allocation and metadata update per write.
+        *              Pending buffered output is flushed first. Uses fallocate on Linux,
+        *              falling back to posix_fallocate where the file system lacks it, and
+        *              posix_fallocate elsewhere.
         * 
-        * @param[out]   ptr: buffer to store read items
-        * @param[in]    element_size: size of each element in bytes.
-        * @param[in]    element_count: number of element to read.
+        * @param[in]   offset: first byte to reserve.
+        * @param[in]   length: number of bytes to reserve.
+        * @param[in]   keep_size: reserve blocks past the end of file without changing
+        *              the file size (FALLOC_FL_KEEP_SIZE, Linux only).
         * 
-        * @return       number of items read.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
         */
-        size_t read(void* ptr, size_t element_size, size_t element_count) 
+        bool preallocate(int64_t offset, int64_t length, bool keep_size = false)
         {
-            if(!is_open())
+            if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            // perform read operation
-            size_t items_readed = fread(ptr, element_size, element_count, m_fp);
+            return try_preallocate(offset, length, keep_size).has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of preallocate().
+        * 
+        * @return      nothing on success, EBADF if file is not open, EOPNOTSUPP if the
+        *              platform or file system can not preallocate, or the errno of fallocate.
+        */
+        FileResult<void> try_preallocate(int64_t offset, int64_t length, bool keep_size = false,
+                                         std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(fflush(m_fp) != 0)
+            {
+                return FileError::from_errno(location);
+            }
 
-            return items_readed; 
+            int fd = fileno(m_fp);
+#if defined(__linux__)
+            int ret;
+            do
+            {
+                ret = fallocate(fd, keep_size ? FALLOC_FL_KEEP_SIZE : 0, static_cast<off_t>(offset), static_cast<off_t>(length));
+            }
+            while(ret != 0 && errno == EINTR);
+            if(ret == 0)
+            {
+                return FileResult<void>();
+            }
+            if(errno != EOPNOTSUPP || keep_size)
+            {
+                return FileError::from_errno(location);
+            }
+#elif defined(__APPLE__)
+            (void)fd;
+            (void)offset;
+            (void)length;
+            (void)keep_size;
+            return FileError(EOPNOTSUPP, location);
+#else
+            if(keep_size)
+            {
+                return FileError(EOPNOTSUPP, location);
+            }
+#endif
+#if !defined(__APPLE__)
+            // posix_fallocate returns the error instead of setting errno
+            int error = posix_fallocate(fd, static_cast<off_t>(offset), static_cast<off_t>(length));
+            if(error != 0)
+            {
+                return FileError(error, location);
+            }
+            return FileResult<void>();
+#endif
         }
 
         /***
-        * @brief       Writes number of items(element_count) in file from buffer.
+        * @brief       Sets the file size to length, dropping or zero-extending the tail.
         *
-        * @details     First check file is opened or not if opened then performs 
-        *              write operation otherwise throws exception.
+        * @details     Pending buffered output is flushed first. The stream position is
+        *              left alone, so seek before writing again if it is now past the end.
         * 
-        * @param[in]   ptr: buffer to read data.
-        * @param[in]   element_size: size of each element in bytes.
-        * @param[in]   element_count: number of element to write from buffer.
+        * @param[in]   length: new size in bytes.
         * 
-        * @return      number of items written.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
         */
-        size_t write(const void* ptr, size_t element_size, size_t element_count) 
+        bool truncate(int64_t length)
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            size_t items_written = fwrite(ptr, element_size, element_count, m_fp);
+            return try_truncate(length).has_value();
+        }
 
-            return items_written;
+        /***
+        * @brief       Non-throwing counterpart of truncate().
+        * 
+        * @return      nothing on success, EBADF if file is not open or the errno of ftruncate.
+        */
+        FileResult<void> try_truncate(int64_t length, std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(fflush(m_fp) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+
+            int ret;
+            do
+            {
+                ret = ftruncate(fileno(m_fp), static_cast<off_t>(length));
+            }
+            while(ret != 0 && errno == EINTR);
+            if(ret != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
         }
 
         /***
-        * @brief        Creates temporary filename.
+        * @brief       Frees the disk blocks of [offset, offset + length), which then read as zeros.
+        *
+        * @details     The file size does not change. Pending buffered output is
+        *              flushed first. Linux only (FALLOC_FL_PUNCH_HOLE), and the file
+        *              system must support it (ext4, xfs, btrfs, tmpfs).
         * 
-        * @param[out]   s: if provided then generated file name will stored is s.
+        * @param[in]   offset: first byte to free.
+        * @param[in]   length: number of bytes to free.
         * 
-        * @return       pointer to the internal static array.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        bool punch_hole(int64_t offset, int64_t length)
+        {
+            if (!is_open()) 
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_punch_hole(offset, length).has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of punch_hole().
         * 
-        * @deprecated   this function is unsafe and deprecated so commenting out to prevent any harm..
+        * @return      nothing on success, EBADF if file is not open, EOPNOTSUPP if the
+        *              platform or file system can not punch holes, or the errno of fallocate.
         */
-        // char* get_temp_name(char s[] = NULL)
-        // {
-        //     return tmpnam(s);
-        // }
+        FileResult<void> try_punch_hole(int64_t offset, int64_t length, std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(fflush(m_fp) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+
+#if defined(__linux__)
+            int ret;
+            do
+            {
+                ret = fallocate(fileno(m_fp), FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset), static_cast<off_t>(length));
+            }
+            while(ret != 0 && errno == EINTR);
+            if(ret != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+#else
+            (void)offset;
+            (void)length;
+            return FileError(EOPNOTSUPP, location);
+#endif
+        }
+
 
+        //==================== DURABILITY ====================
         /***
-        * @brief   Read next character from file.
+        * @brief   Makes the written data durable, like fdatasync.
+        *
+        * @details flush() only hands buffered output to the kernel. This flushes and
+        *          then waits until the data, and the metadata needed to read it back
+        *          such as the file size, is on stable storage. Timestamps may lag.
         * 
-        * @return  return read character or EOF for end of file or any error.
+        * @return  returns true on success otherwise false.
+        *
+        * @throws  bad_file_discriptor: If file is not open.
         */
-        int getchar() 
+        bool sync_data()
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            return fgetc(m_fp);
+            return try_sync_data().has_value();
         }
 
         /***
-        * @brief       Writes character.
+        * @brief   Non-throwing counterpart of sync_data().
         * 
-        * @param[in]   c: Writes character c in file.
+        * @return  nothing on success, EBADF if file is not open or the errno of fflush/fdatasync.
+        */
+        FileResult<void> try_sync_data(std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Flush, __func__, m_fp);
+            if(fflush(m_fp) != 0 || file_detail::sync_descriptor(fileno(m_fp), true) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
+        }
+
+        /***
+        * @brief   Makes the written data and all metadata durable, like fsync.
         * 
-        * @return      return character written or EOF for end of file or any error.
+        * @return  returns true on success otherwise false.
+        *
+        * @throws  bad_file_discriptor: If file is not open.
         */
-        int putchar(char c) 
+        bool sync_all()
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            return fputc(c, m_fp);
+            return try_sync_all().has_value();
         }
 
         /***
-        * @brief        Reads next input line from file.
-        * 
-        * @param[out]   string: read string will stored in string param.
-        * @param[in]    max_char: if given then atmost max_char-1 will be read otherwise 63 characters will be read
+        * @brief   Non-throwing counterpart of sync_all().
         * 
-        * @return       returns read line or EOF for end of file or any error.
+        * @return  nothing on success, EBADF if file is not open or the errno of fflush/fsync.
         */
-        char* getstring(char* string, int max_char = 64) 
+        FileResult<void> try_sync_all(std::source_location location = std::source_location::current()) noexcept
         {
-            if (!is_open()) 
+            if(!is_open())
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                return FileError(EBADF, location);
             }
-
-            return fgets(string, max_char, m_fp);
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Flush, __func__, m_fp);
+            if(fflush(m_fp) != 0 || file_detail::sync_descriptor(fileno(m_fp), false) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+            return FileResult<void>();
         }
 
         /***
-        * @brief       Writes string in file.
+        * @brief       Writes back the dirty pages of [offset, offset + length).
+        *
+        * @details     Uses sync_file_range on Linux, which neither flushes the disk
+        *              cache nor the metadata, so it is not durable on its own for newly
+        *              allocated blocks (preallocate() first, or finish with sync_data()).
+        *              With wait = false it only starts writeback, so a streaming writer
+        *              can keep the dirty page backlog small without blocking. Other
+        *              platforms fall back to fdatasync, or do nothing when wait is false.
         * 
-        * @param[in]   string: write give 'string' in file.
+        * @param[in]   offset: first byte of the range.
+        * @param[in]   length: number of bytes, 0 means up to the end of file.
+        * @param[in]   wait: block until writeback of the range has completed.
         * 
-        * @return      returns true on success or false on end of file or any error.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
         */
-        bool putstring(const char* string) 
+        bool sync_range(int64_t offset, int64_t length, bool wait = true)
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            return fputs(string, m_fp) != EOF;
+            return try_sync_range(offset, length, wait).has_value();
         }
 
         /***
-        * @brief       Prints formatted input in the file.
-        * 
-        * @param[in]   format: format of the input string.
-        * @param[in]   ...: Variadic argument list.
+        * @brief   Non-throwing counterpart of sync_range().
         * 
-        * @return      returns true if number of charactors written in file is positive otherwise false.
+        * @return  nothing on success, EBADF if file is not open or the errno of sync_file_range.
         */
-        bool printInFile(const char* format, ...) const
+        FileResult<void> try_sync_range(int64_t offset, int64_t length, bool wait = true,
+                                        std::source_location location = std::source_location::current()) noexcept
         {
-            if (!is_open()) 
+            if(!is_open())
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
-            } 
-
-            // create variadic argument list
-            va_list ap;
-            va_start(ap, format); // initialise it with first unknown argument
-        
-            int ret_val = vfprintf(m_fp, format, ap); // perform print in file operation
-        
-            // close the variadic argument list
-            va_end(ap);
+                return FileError(EBADF, location);
+            }
+            if(fflush(m_fp) != 0)
+            {
+                return FileError::from_errno(location);
+            }
 
-            if(ret_val < 0)
+#if defined(__linux__)
+            unsigned flags = wait ? (SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER)
+                                  : SYNC_FILE_RANGE_WRITE;
+            int ret;
+            do
             {
-                return false;
+                ret = sync_file_range(fileno(m_fp), static_cast<off_t>(offset), static_cast<off_t>(length), flags);
             }
-            else
+            while(ret != 0 && errno == EINTR);
+#else
+            (void)offset;
+            (void)length;
+            int ret = wait ? file_detail::sync_descriptor(fileno(m_fp), true) : 0;
+#endif
+            if(ret != 0)
             {
-                return true;
+                return FileError::from_errno(location);
             }
+            return FileResult<void>();
         }
 
+
+        //==================== PAGE CACHE ====================
         /***
-        * @brief       Scans file
+        * @brief       Starts loading [offset, offset + length) into the page cache.
+        *
+        * @details     Returns without waiting for the reads (POSIX_FADV_WILLNEED), so the
+        *              data is ready by the time a later read or pread gets there. Use it
+        *              ahead of known lookups on a file opened with AccessPattern::Random.
         * 
-        * @param[in]   format: format of the arguments.
-        * @param[in]   ...: Variadic argument list which stores scanned items.
+        * @param[in]   offset: first byte of the range.
+        * @param[in]   length: number of bytes, 0 means up to the end of file.
         * 
-        * @return      returns false if EOF occured otherwise true.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
         */
-        bool scanInFile(const char* format, ...) 
+        bool prefetch(int64_t offset, int64_t length)
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            // create variadic argument list
-            va_list ap;
-            va_start(ap, format); // initialise it with first unknown argument
-        
-            int ret_val = vfscanf(m_fp, format, ap); // perform scan in file operation
-        
-            // close the variadic argument list
-            va_end(ap);
+            return try_prefetch(offset, length).has_value();
+        }
 
-            // check for error or end of file
-            if(ret_val != EOF)
+        /***
+        * @brief   Non-throwing counterpart of prefetch().
+        * 
+        * @return  nothing on success, EBADF if file is not open, EOPNOTSUPP on macOS or
+        *          the error of posix_fadvise.
+        */
+        FileResult<void> try_prefetch(int64_t offset, int64_t length,
+                                      std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open())
             {
-                return true;
+                return FileError(EBADF, location);
             }
-            else
+
+#if defined(__APPLE__)
+            (void)offset;
+            (void)length;
+            return FileError(EOPNOTSUPP, location);
+#else
+            int error = posix_fadvise(fileno(m_fp), static_cast<off_t>(offset), static_cast<off_t>(length), POSIX_FADV_WILLNEED);
+            if(error != 0)
             {
-                return false;
+                return FileError(error, location);
             }
+            return FileResult<void>();
+#endif
         }
 
         /***
-        * @brief       reopens file with given mode.
+        * @brief       Releases the page cache behind [offset, offset + length).
+        *
+        * @details     Lets batch jobs stream through large files without pushing everything
+        *              else out of memory: call it on the part already processed. Pending
+        *              buffered output is flushed and, on Linux, dirty pages are written back
+        *              first since the kernel only drops clean ones. This is not a durability
+        *              barrier, use sync_data() for that.
         * 
-        * @param[in]   mode: mode to change while reopening file.
+        * @param[in]   offset: first byte of the range.
+        * @param[in]   length: number of bytes, 0 means up to the end of file.
         * 
-        * @return      returns true on successfull reopening of the file otherwise throws exception.
+        * @return      returns true on success otherwise false.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
         */
-        bool reopen(const std::string& mode) 
+        bool drop_cache(int64_t offset = 0, int64_t length = 0)
         {
             if (!is_open()) 
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
-            }
-            
-            m_fp = freopen(m_filename.c_str(), mode.c_str(), m_fp);
-            if(m_fp == NULL)
-            {
-                std::string error_msg = "Error: Failed to reopen \"" + m_filename + "\" with mode \"" + mode +
-                                        "\" - Reason: " + strerror(errno) + 
-                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                    throw error_opning_file(error_msg);
+                throw_bad_file_discriptor(__func__, __LINE__);
             }
 
-            return true;
+            return try_drop_cache(offset, length).has_value();
         }
 
         /***
-        * @brief   Flushes any buffered output before next statement.
-        * 
-        * @details Ensures that the data is read or written completely.
+        * @brief   Non-throwing counterpart of drop_cache().
         * 
-        * @return  true on success otherwise false.
+        * @return  nothing on success, EBADF if file is not open, EOPNOTSUPP on macOS or
+        *          the error of fflush/sync_file_range/posix_fadvise.
         */
-        bool flush() 
+        FileResult<void> try_drop_cache(int64_t offset = 0, int64_t length = 0,
+                                        std::source_location location = std::source_location::current()) noexcept
         {
-            if (!is_open()) 
+            if(!is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(fflush(m_fp) != 0)
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                return FileError::from_errno(location);
             }
 
-            return fflush(m_fp) == 0;
+            int error = file_detail::drop_descriptor_cache(fileno(m_fp), offset, length);
+            if(error != 0)
+            {
+                return FileError(error, location);
+            }
+            return FileResult<void>();
         }
 
 
+        //==================== COPYING ====================
+        /***
+        * @brief       Copies bytes of this file to dst at its current position, inside
+        *              the kernel where possible.
+        *
+        * @details     Tries in order: a FICLONERANGE reflink, which only shares extents
+        *              and needs block aligned offsets on Btrfs or XFS; copy_file_range;
+        *              sendfile; and finally a pread/pwrite loop through a pooled
+        *              buffer. Pending output of both files is flushed first. The
+        *              position of dst moves past the copied bytes, the position of
+        *              this file does not change.
+        *
+        * @param[in]   dst: open, writable File receiving the bytes.
+        * @param[in]   offset: first byte of this file to copy.
+        * @param[in]   length: number of bytes to copy, -1 for everything up to end of file.
+        *
+        * @return      bytes copied, fewer than length at end of file, and the path used.
+        *
+        * @throws      bad_file_discriptor: If this file or dst is not open.
+        * @throws      std::system_error: If copying fails.
+        */
+        template <typename OtherPolicy>
+        CopyResult copy_to(BasicFile<OtherPolicy>& dst, int64_t offset = 0, int64_t length = -1)
+        {
+            if (!is_open() || !dst.is_open())
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return try_copy_to(dst, offset, length).value();
+        }
 
-        //==================== GETTER FUNCTIONS ====================
         /***
-        * @brief   To get file handle.
-        * 
-        * @details Used to get file handle of type FILE*.
-        * 
-        * @return  returns file handle.
+        * @brief       Non-throwing counterpart of copy_to().
+        *
+        * @return      the copy, EBADF if either file is not open, EINVAL for a negative
+        *              offset, or the errno of the failed step.
         */
-        FILE* get_handle() const
+        template <typename OtherPolicy>
+        FileResult<CopyResult> try_copy_to(BasicFile<OtherPolicy>& dst, int64_t offset = 0, int64_t length = -1,
+                                           std::source_location location = std::source_location::current()) noexcept
+        {
+            if(!is_open() || !dst.is_open())
+            {
+                return FileError(EBADF, location);
+            }
+            if(offset < 0)
+            {
+                return FileError(EINVAL, location);
+            }
+            FILE* out = dst.get_handle();
+            if(fflush(m_fp) != 0 || fflush(out) != 0)
+            {
+                return FileError::from_errno(location);
+            }
+
+            struct stat info;
+            off_t out_offset = ftello(out);
+            if(fstat(fileno(m_fp), &info) != 0 || out_offset < 0)
+            {
+                return FileError::from_errno(location);
+            }
+            int64_t available = offset < info.st_size ? static_cast<int64_t>(info.st_size) - offset : 0;
+            int64_t count = (length < 0 || length > available) ? available : length;
+
+            CopyResult result;
+            int ret = file_detail::copy_descriptor_range(fileno(m_fp), offset, fileno(out), static_cast<int64_t>(out_offset), count, result);
+            int saved_errno = errno;
+
+            // Realign the stream of dst with the bytes written behind its back
+            if(fseeko(out, out_offset + static_cast<off_t>(result.bytes), SEEK_SET) != 0 && ret == 0)
+            {
+                return FileError::from_errno(location);
+            }
+            if(ret != 0)
+            {
+                errno = saved_errno;
+                return FileError::from_errno(location);
+            }
+            return result;
+        }
+#endif
+
+    private:
+        // Selects the constructor that leaves the object closed, used by try_open()
+        struct closed_tag {};
+
+        explicit BasicFile(closed_tag) noexcept : m_fp(NULL), m_line_buf(NULL), m_line_cap(0), m_buffer(NULL),
+                                                  m_buffer_capacity(0), m_buffer_size(0), m_buffer_mode(BufferMode::Full),
+                                                  m_access_pattern(AccessPattern::Normal)
         {
-            return m_fp;
         }
 
         /***
-        * @brief   To get file name.
+        * @brief       Builds the message of a failed open or reopen and throws error_opning_file.
         * 
-        * @details Used to get filename associated with the class object.
-        * 
-        * @return  returns file name
+        * @param[in]   action: "open" or "reopen".
+        * @param[in]   mode: mode the file was opened with.
+        * @param[in]   error: errno of the failure.
+        * @param[in]   function: name of the calling function (__func__).
+        * @param[in]   line: line of the failed call (__LINE__).
+        *
+        * @throws      error_opning_file: Always.
         */
-        const std::string& get_filename() const 
+        [[noreturn]] FILE_COLD_NOINLINE void throw_open_error(const char* action, const std::string& mode, int error,
+                                                              const char* function, int line) const
         {
-            return m_filename;
+            throw error_opning_file("Error: Failed to " + std::string(action) + " \"" + m_filename + "\" with mode \"" + mode +
+                                    "\" - Reason: " + strerror(error) + ". Line[" + std::to_string(line) +
+                                    "], Function[" + function + "], File[" + __FILE__ + "]");
         }
 
-        
-
-        //==================== FILE POSITIONING ====================
         /***
-        * @brief       Used to set file pointer.
+        * @brief   Installs the buffering policy on a freshly opened stream.
         * 
-        * @param[in]   offset: number of bytes to shift file pointer.
-        * @param[in]   origin: from where shifting of file pointer will be done.
-        *                  allowable mode: Set(from origin), Current(from current position of file pointer) 
-        *                  or End(from end of the file).
+        * @details The previous pooled buffer, if any, is released once the
+        *          stream has switched to the new one.
         * 
-        * @return      returns true on success otherwise false.
+        * @return  true on success otherwise false.
         */
-        bool seek(long offset, SeekOrigin origin) 
+        bool apply_buffer()
         {
-            if (!is_open()) 
+            if(m_buffer_mode == BufferMode::Full && m_buffer_size == 0)
+            {
+                return true; // set_buffer() never called, keep the libc default
+            }
+
+            char* buffer = m_buffer_size ? BufferPool::instance().acquire(m_buffer_size) : NULL;
+            if(setvbuf(m_fp, buffer, static_cast<int>(m_buffer_mode), m_buffer_size) != 0)
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                BufferPool::instance().release(buffer, m_buffer_size);
+                return false;
             }
 
-            return fseek(m_fp, offset, static_cast<int>(origin)) == 0;
+            release_buffer();
+            m_buffer = buffer;
+            m_buffer_capacity = m_buffer_size;
+            return true;
         }
-    
+
         /***
-        * @brief   To get current position of file pointer.
-        * 
-        * @return  return byte offset from file's base address to current position of file pointer.
+        * @brief   Returns the pooled buffer, the stream must not use it anymore.
         */
-        long tell() const
+        void release_buffer()
         {
-            if (!is_open()) 
+            if(m_buffer)
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                BufferPool::instance().release(m_buffer, m_buffer_capacity);
+                m_buffer = NULL;
+                m_buffer_capacity = 0;
             }
-
-            return ftell(m_fp);
         }
-    
+
         /***
-        * @brief   Sets file pointer to begining.
+        * @brief   Passes the access pattern to the kernel on a freshly opened stream.
+        * 
+        * @details Best effort, a rejected hint such as one on a pipe is ignored.
         */
-        void rewind() 
+        void apply_access_pattern() noexcept
         {
-            if (!is_open()) 
+#if !defined(_WIN32)
+            if(m_access_pattern != AccessPattern::Normal)
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg); 
+                file_detail::advise_descriptor(fileno(m_fp), m_access_pattern);
             }
-
-            ::rewind(m_fp); 
+#endif
         }
 
         /***
-        * @brief        Records current file position.
+        * @brief        Reads the next line into m_line_buf.
         * 
-        * @param[out]   pos: stores current file position in fpos_t data types variable.
+        * @param[out]   line: view of the line read, without the trailing '\n'.
         * 
-        * @return       return true on success otherwise false.
+        * @return       false on end of file, error or a closed file otherwise true.
         */
-        bool get_pos(fpos_t* pos) 
+        bool read_line(std::string_view& line)
         {
-            if (!is_open()) 
+            if(!is_open())
+            {
+                return false;
+            }
+            file_detail::OpScope<ThreadingPolicy::shared> scope(m_stats, FileOp::Read, __func__, m_fp);
+
+#if defined(_WIN32)
+            // no getline on the Microsoft CRT, grow the buffer around fgets
+            size_t length = 0;
+            for(;;)
+            {
+                if(m_line_cap - length < 2)
+                {
+                    size_t new_cap = m_line_cap ? m_line_cap * 2 : 256;
+                    char* new_buf = static_cast<char*>(realloc(m_line_buf, new_cap));
+                    if(!new_buf)
+                    {
+                        return false;
+                    }
+                    m_line_buf = new_buf;
+                    m_line_cap = new_cap;
+                }
+                if(!fgets(m_line_buf + length, static_cast<int>(m_line_cap - length), m_fp))
+                {
+                    break;
+                }
+                length += strlen(m_line_buf + length);
+                if(m_line_buf[length - 1] == '\n')
+                {
+                    break;
+                }
+            }
+            if(length == 0)
+            {
+                return false;
+            }
+#else
+            // getline reuses and grows m_line_buf and reports the length directly.
+            // glibc's getline already memchr's its read buffer, the kernel find_byte
+            // picks there, so a find_byte loop over the buffer gains nothing.
+            ssize_t read_len = getline(&m_line_buf, &m_line_cap, m_fp);
+            if(read_len <= 0)
             {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
+                return false;
             }
+            size_t length = static_cast<size_t>(read_len);
+#endif
+            scope.add_bytes(length);
 
-            return fgetpos(m_fp, pos) == 0;
+            if(m_line_buf[length - 1] == '\n')
+            {
+                --length;
+            }
+            line = std::string_view(m_line_buf, length);
+            return true;
         }
+};
+
+using File = BasicFile<MultiThreaded>;          // locking stdio, shareable between threads
+using UnlockedFile = BasicFile<SingleThreaded>; // unlocked stdio, one thread at a time
+
+
+
+#if !defined(_WIN32)
+//==================== FileCursor Class ====================
+// Independent read/write position on the descriptor of an open File. Cursors
+// are cheap to copy and never touch the File's stream position, so N threads
+// can each hold a cursor and do random I/O on one file at once. A cursor is
+// used by one thread at a time and must not outlive its File.
+class FileCursor
+{
+    private:
+        int m_fd;         // descriptor shared with the File
+        int64_t m_offset; // position of this cursor
 
+    public:
         /***
-        * @brief       Sets previously Recorded file position.
+        * @brief       Creates a cursor on file at offset.
+        *
+        * @param[in]   file: open File to share the descriptor of.
+        * @param[in]   offset: starting byte offset.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename ThreadingPolicy>
+        explicit FileCursor(const BasicFile<ThreadingPolicy>& file, int64_t offset = 0)
+            : m_fd(file.get_descriptor()), m_offset(offset)
+        {
+        }
+
+        /***
+        * @brief        Reads elements at the cursor and advances it by the bytes read.
         * 
-        * @param[in]   pos: Priviously recorded file position
+        * @return       number of complete elements read.
+        */
+        template <typename T, size_t Extent>
+            requires (std::is_trivially_copyable_v<T> && !std::is_const_v<T>)
+        size_t read(std::span<T, Extent> items)
+        {
+            size_t done = file_detail::pread_full(m_fd, items.data(), items.size_bytes(), m_offset);
+            m_offset += static_cast<int64_t>(done);
+            return done / sizeof(T);
+        }
+
+        /***
+        * @brief        Writes elements at the cursor and advances it by the bytes written.
         * 
-        * @return      return true on success otherwise false.
+        * @return       number of complete elements written.
         */
-        bool set_pos(const fpos_t* pos) 
+        template <typename T, size_t Extent>
+            requires std::is_trivially_copyable_v<T>
+        size_t write(std::span<T, Extent> items)
         {
-            if (!is_open()) 
-            {
-                std::string error_msg = "Error: Bad file discriptor. Line[" + std::to_string(__LINE__) +
-                "], Function[" + __func__ + "], File[" + __FILE__ + "]";
-                throw bad_file_discriptor(error_msg);
-            }
+            size_t done = file_detail::pwrite_full(m_fd, items.data(), items.size_bytes(), m_offset);
+            m_offset += static_cast<int64_t>(done);
+            return done / sizeof(T);
+        }
 
-            return fsetpos(m_fp, pos) == 0;
-        }    
+        /***
+        * @brief       Moves the cursor to an absolute byte offset.
+        */
+        void seek(int64_t offset)
+        {
+            m_offset = offset;
+        }
+
+        /***
+        * @brief   To get the cursor's byte offset.
+        */
+        int64_t tell() const
+        {
+            return m_offset;
+        }
 };
 
 
+
+//==================== copy_file ====================
+/***
+* @brief       Copies the file from to a new or truncated file to, with the
+*              permission bits of from.
+*
+* @details     Uses File::copy_to(), so on Btrfs or XFS the copy is a reflink that
+*              costs a metadata update whatever the size.
+*
+* @param[in]   from: file to copy.
+* @param[in]   to: file to create or overwrite.
+* @param[in]   location: recorded in the FileError, defaults to the caller.
+*
+* @return      bytes copied and the path used, EINVAL if to is from itself (the
+*              same name, a hard link or any other alias), or the errno of the
+*              failed step.
+*/
+inline FileResult<CopyResult> try_copy_file(const std::string& from, const std::string& to,
+                                            std::source_location location = std::source_location::current()) noexcept
+{
+    FileResult<File> src = File::try_open(from, "rb", location);
+    if(!src)
+    {
+        return src.error();
+    }
+
+    // the destination is truncated only once it is known not to be the source
+    int fd = ::open(to.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0666);
+    if(fd < 0)
+    {
+        return FileError::from_errno(location);
+    }
+    FileResult<File> dst = File::try_from_descriptor(fd, "wb", to, location);
+    if(!dst)
+    {
+        return dst.error();
+    }
+
+    struct stat info;
+    struct stat dst_info;
+    if(fstat(src->get_descriptor(), &info) != 0 || fstat(dst->get_descriptor(), &dst_info) != 0)
+    {
+        return FileError::from_errno(location);
+    }
+    if(info.st_dev == dst_info.st_dev && info.st_ino == dst_info.st_ino)
+    {
+        return FileError(EINVAL, location);
+    }
+    if(ftruncate(dst->get_descriptor(), 0) != 0 || fchmod(dst->get_descriptor(), info.st_mode & 07777) != 0)
+    {
+        return FileError::from_errno(location);
+    }
+    return src->try_copy_to(*dst, 0, -1, location);
+}
+
+/***
+* @brief       Throwing form of try_copy_file().
+*
+* @throws      std::system_error: If either file can not be opened or copying fails.
+*/
+inline CopyResult copy_file(const std::string& from, const std::string& to)
+{
+    return try_copy_file(from, to).value();
+}
+#endif
+
+
 #endif  // _FILE_H
@@ -0,0 +1,72 @@
+#ifndef _FILE_CLOCK_H
+#define _FILE_CLOCK_H
+
+// Header inclusion
+#include <cstdint>   // for tick counts
+#include <chrono>    // for converting ticks to nanoseconds
+#include <thread>    // for sleeping while calibrating the tick rate
+#if defined(_MSC_VER)
+#include <intrin.h>  // for __rdtsc
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // for __rdtsc
+#endif
+
+
+
+//==================== Tick Clock ====================
+// Timestamps of the I/O statistics and the trace recorder. Reading the TSC
+// is several times cheaper than steady_clock, the tick rate is measured
+// against steady_clock only when the results are read.
+namespace file_clock
+{
+    /***
+    * @brief       Cheap monotonic timestamp: the TSC on x86, steady_clock nanoseconds elsewhere.
+    */
+    inline uint64_t ticks() noexcept
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Pair of readings taken on first use, the tick rate is measured against it
+    struct Origin
+    {
+        uint64_t ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    inline const Origin& origin()
+    {
+        static const Origin origin{ticks(), std::chrono::steady_clock::now()};
+        return origin;
+    }
+
+    /***
+    * @brief       Nanoseconds per tick, 1 where ticks already are nanoseconds.
+    *
+    * @details     Sleeps until 10 ms have passed since origin() if called earlier.
+    */
+    inline double ns_per_tick()
+    {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+        const Origin& start = origin();
+        auto elapsed = std::chrono::steady_clock::now() - start.time;
+        if(elapsed < std::chrono::milliseconds(10))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10) - elapsed); // too short to measure the rate
+        }
+        uint64_t now_ticks = ticks();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start.time).count();
+        return now_ticks > start.ticks ? ns / static_cast<double>(now_ticks - start.ticks) : 1.0;
+#else
+        return 1.0;
+#endif
+    }
+}
+
+
+#endif  // _FILE_CLOCK_H
@@ -0,0 +1,741 @@
+#ifndef _FILE_STATS_H
+#define _FILE_STATS_H
+
+// Header inclusion
+#include <cstdint>   // for the counters
+#include <cstddef>   // for size_t
+#include <string>    // for file names and dumps
+#if defined(FILE_ENABLE_STATS)
+#include <atomic>    // for counters read while they are updated
+#include <bit>       // for bit_width, the histogram bucket
+#include <cstdio>    // for dump() and number formatting
+#include <mutex>     // for the registry
+#include <new>       // for nothrow allocation of per-file counters
+#include <utility>   // for std::pair
+#include <vector>    // for the registered blocks
+#include "file_clock.h" // for the timestamps
+#endif
+
+
+
+// Enum class for the operation classes counted by the I/O statistics
+enum class FileOp
+{
+    Read,  // read, getchar, getstring, scanInFile, lines, read_at
+    Write, // write, putchar, putstring, printInFile, print, write_at
+    Seek,  // seek, set_pos, rewind
+    Flush, // flush, sync_data, sync_all
+    Open,  // open, reopen
+    Close  // close
+};
+
+inline constexpr size_t file_op_count = 6;
+
+/***
+* @brief       Lower case name of op, as used in the dumps.
+*/
+inline const char* file_op_name(FileOp op)
+{
+    static const char* const names[file_op_count] = {"read", "write", "seek", "flush", "open", "close"};
+    return names[static_cast<size_t>(op)];
+}
+
+
+
+#if defined(FILE_ENABLE_STATS)
+//==================== I/O Statistics ====================
+// Compiled in with -DFILE_ENABLE_STATS. Every File counts calls, bytes and
+// time per FileOp, and keeps a log2 histogram of the latencies, in its own
+// block and in a block owned by the calling thread. The thread blocks have
+// a single writer, so they are updated with plain loads and stores and
+// FileStatsRegistry sums them for the process totals, including files that
+// are closed already. A File's block is written the same way by the thread
+// that opened it; only other threads sharing a File use atomic adds.
+//
+// Reading the clock costs more than a buffered read or write, so each
+// thread times only every FILE_STATS_SAMPLE_PERIOD-th of those calls, and
+// total times are the sampled mean times the number of calls. Seeks,
+// flushes, opens and closes are always timed. Character calls (getchar,
+// putchar) are counted but never timed.
+
+#if !defined(FILE_STATS_SAMPLE_PERIOD)
+#define FILE_STATS_SAMPLE_PERIOD 16
+#endif
+
+inline constexpr size_t file_stats_buckets = 40; // bucket b holds latencies below 2^b ticks
+inline constexpr uint32_t file_stats_sample_period = FILE_STATS_SAMPLE_PERIOD; // 1 times every call
+
+namespace file_stats_detail
+{
+    /***
+    * @brief       Adds value to counter, with an atomic add only when several threads may write it.
+    */
+    inline void add(std::atomic<uint64_t>& counter, uint64_t value, bool shared) noexcept
+    {
+        if(shared)
+        {
+            counter.fetch_add(value, std::memory_order_relaxed);
+        }
+        else
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Counters of one operation class
+struct FileOpCounters
+{
+    std::atomic<uint64_t> calls{0};                      // all calls
+    std::atomic<uint64_t> bytes{0};                      // bytes transferred
+    std::atomic<uint64_t> timeable{0};                   // calls eligible for timing, i.e. not getchar/putchar
+    std::atomic<uint64_t> ticks{0};                      // time spent in the sampled calls
+    std::atomic<uint64_t> histogram[file_stats_buckets] = {}; // sampled calls by log2 of their ticks
+};
+
+// Counters of a File or of a thread, one FileOpCounters per FileOp
+struct FileStats
+{
+    FileOpCounters ops[file_op_count];
+
+    /***
+    * @brief       Counts one call.
+    *
+    * @param[in]   timeable: false for character calls, which are never timed.
+    * @param[in]   elapsed: ticks of a sampled call, 0 if it was not sampled.
+    * @param[in]   shared: whether other threads may update this block at the same time.
+    */
+    void record(FileOp op, uint64_t bytes, bool timeable, uint64_t elapsed, bool shared) noexcept
+    {
+        FileOpCounters& counters = ops[static_cast<size_t>(op)];
+        file_stats_detail::add(counters.calls, 1, shared);
+        if(bytes)
+        {
+            file_stats_detail::add(counters.bytes, bytes, shared);
+        }
+        if(timeable)
+        {
+            file_stats_detail::add(counters.timeable, 1, shared);
+        }
+        if(elapsed)
+        {
+            file_stats_detail::add(counters.ticks, elapsed, shared);
+            size_t bucket = static_cast<size_t>(std::bit_width(elapsed));
+            file_stats_detail::add(counters.histogram[bucket < file_stats_buckets ? bucket : file_stats_buckets - 1], 1, shared);
+        }
+    }
+};
+
+// Counters of one File: the owner block is written only by the thread that
+// opened it, the other block by every other thread, with atomic adds.
+struct FileCounters
+{
+    FileStats owned;        // calls from the owner thread
+    FileStats foreign;      // calls from other threads
+    const FileStats* owner; // block of the owner thread
+    std::string name;       // file name, guarded by the registry mutex
+};
+
+// Plain copy of the counters of one operation class
+struct FileOpSnapshot
+{
+    uint64_t calls = 0;
+    uint64_t bytes = 0;
+    uint64_t timeable = 0;
+    uint64_t ticks = 0;
+    uint64_t histogram[file_stats_buckets] = {};
+
+    /***
+    * @brief       Number of sampled calls, i.e. entries in the histogram.
+    */
+    uint64_t timed() const
+    {
+        uint64_t count = 0;
+        for(uint64_t bucket : histogram)
+        {
+            count += bucket;
+        }
+        return count;
+    }
+
+    /***
+    * @brief       Upper bound in ticks of the latency below which fraction of the timed calls fall.
+    *
+    * @param[in]   fraction: e.g. 0.5 for the median, 0.99 for p99.
+    */
+    uint64_t percentile_ticks(double fraction) const
+    {
+        uint64_t total = timed();
+        uint64_t seen = 0;
+        for(size_t b = 0; b < file_stats_buckets; ++b)
+        {
+            seen += histogram[b];
+            if(total && static_cast<double>(seen) >= fraction * static_cast<double>(total))
+            {
+                return uint64_t(1) << b;
+            }
+        }
+        return 0;
+    }
+};
+
+// Plain copy of a FileStats block, or the sum of several
+struct FileStatsSnapshot
+{
+    FileOpSnapshot ops[file_op_count];
+    double ns_per_tick = 1.0; // converts ticks and histogram bounds to nanoseconds
+
+    const FileOpSnapshot& operator[](FileOp op) const
+    {
+        return ops[static_cast<size_t>(op)];
+    }
+
+    /***
+    * @brief       Mean latency of op in nanoseconds, over the sampled calls.
+    */
+    double mean_ns(FileOp op) const
+    {
+        const FileOpSnapshot& counters = (*this)[op];
+        uint64_t timed = counters.timed();
+        return timed ? static_cast<double>(counters.ticks) * ns_per_tick / static_cast<double>(timed) : 0.0;
+    }
+
+    /***
+    * @brief       Estimated time spent in op in nanoseconds, the mean times every timeable call.
+    */
+    double total_ns(FileOp op) const
+    {
+        return mean_ns(op) * static_cast<double>((*this)[op].timeable);
+    }
+
+    /***
+    * @brief       Latency in nanoseconds below which fraction of the sampled calls of op
+    *              fall, rounded up to a power of two ticks.
+    */
+    double percentile_ns(FileOp op, double fraction) const
+    {
+        return static_cast<double>((*this)[op].percentile_ticks(fraction)) * ns_per_tick;
+    }
+
+    FileStatsSnapshot& operator+=(const FileStatsSnapshot& other)
+    {
+        for(size_t i = 0; i < file_op_count; ++i)
+        {
+            ops[i].calls += other.ops[i].calls;
+            ops[i].bytes += other.ops[i].bytes;
+            ops[i].timeable += other.ops[i].timeable;
+            ops[i].ticks += other.ops[i].ticks;
+            for(size_t b = 0; b < file_stats_buckets; ++b)
+            {
+                ops[i].histogram[b] += other.ops[i].histogram[b];
+            }
+        }
+        return *this;
+    }
+
+    /***
+    * @brief       Adds the current values of block, read with relaxed loads.
+    */
+    void add(const FileStats& block)
+    {
+        for(size_t i = 0; i < file_op_count; ++i)
+        {
+            const FileOpCounters& counters = block.ops[i];
+            ops[i].calls += counters.calls.load(std::memory_order_relaxed);
+            ops[i].bytes += counters.bytes.load(std::memory_order_relaxed);
+            ops[i].timeable += counters.timeable.load(std::memory_order_relaxed);
+            ops[i].ticks += counters.ticks.load(std::memory_order_relaxed);
+            for(size_t b = 0; b < file_stats_buckets; ++b)
+            {
+                ops[i].histogram[b] += counters.histogram[b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /***
+    * @brief       One table row per operation class that was called.
+    *
+    * @details     Latency percentiles are the upper bounds of their log2 buckets.
+    */
+    std::string to_text() const
+    {
+        std::string text;
+        char row[192];
+        snprintf(row, sizeof(row), "%-6s %12s %14s %12s %10s %10s %10s\n", "op", "calls", "bytes", "total ms", "mean ns", "p50 ns", "p99 ns");
+        text += row;
+        for(size_t i = 0; i < file_op_count; ++i)
+        {
+            FileOp op = static_cast<FileOp>(i);
+            if(ops[i].calls == 0)
+            {
+                continue;
+            }
+            snprintf(row, sizeof(row), "%-6s %12llu %14llu %12.3f %10.0f %10.0f %10.0f\n", file_op_name(op),
+                     static_cast<unsigned long long>(ops[i].calls), static_cast<unsigned long long>(ops[i].bytes),
+                     total_ns(op) / 1e6, mean_ns(op), percentile_ns(op, 0.5), percentile_ns(op, 0.99));
+            text += row;
+        }
+        return text;
+    }
+
+    /***
+    * @brief       JSON object keyed by operation name; histograms list the non-empty
+    *              buckets as {"le_ns": upper bound, "count": calls}.
+    */
+    std::string to_json() const
+    {
+        std::string json = "{";
+        char number[160];
+        bool first_op = true;
+        for(size_t i = 0; i < file_op_count; ++i)
+        {
+            const FileOpSnapshot& op = ops[i];
+            if(op.calls == 0)
+            {
+                continue;
+            }
+            snprintf(number, sizeof(number), "\"calls\": %llu, \"bytes\": %llu, \"total_ns\": %.0f, \"mean_ns\": %.1f, \"histogram\": [",
+                     static_cast<unsigned long long>(op.calls), static_cast<unsigned long long>(op.bytes),
+                     total_ns(static_cast<FileOp>(i)), mean_ns(static_cast<FileOp>(i)));
+            json += std::string(first_op ? "" : ", ") + "\"" + file_op_name(static_cast<FileOp>(i)) + "\": {" + number;
+            first_op = false;
+            bool first_bucket = true;
+            for(size_t b = 0; b < file_stats_buckets; ++b)
+            {
+                if(op.histogram[b] == 0)
+                {
+                    continue;
+                }
+                snprintf(number, sizeof(number), "%s{\"le_ns\": %.0f, \"count\": %llu}", first_bucket ? "" : ", ",
+                         static_cast<double>(uint64_t(1) << b) * ns_per_tick, static_cast<unsigned long long>(op.histogram[b]));
+                json += number;
+                first_bucket = false;
+            }
+            json += "]}";
+        }
+        return json + "}";
+    }
+};
+
+
+
+//==================== FileStatsRegistry Class ====================
+// Process-wide list of the per-thread and per-file blocks. Locked only when
+// a thread or File registers or leaves and when the statistics are read,
+// never on the I/O path.
+class FileStatsRegistry
+{
+    private:
+        std::mutex m_mutex;                // guards the members below
+        std::vector<FileStats*> m_threads; // blocks of running threads
+        std::vector<FileCounters*> m_files; // counters of live Files
+        FileStatsSnapshot m_retired;       // sum of the blocks of exited threads
+
+        FileStatsRegistry()
+        {
+            file_clock::origin();
+        }
+
+    public:
+        /***
+        * @brief   To get the process-wide registry.
+        *
+        * @details Never destroyed, so threads and Files with static storage
+        *          duration can still leave it at exit.
+        */
+        static FileStatsRegistry& instance()
+        {
+            static FileStatsRegistry* registry = new FileStatsRegistry();
+            return *registry;
+        }
+
+        FileStatsRegistry(const FileStatsRegistry&) = delete;
+        FileStatsRegistry& operator=(const FileStatsRegistry&) = delete;
+
+        /***
+        * @brief   Counters of every File of the process since start, including closed ones.
+        */
+        FileStatsSnapshot totals()
+        {
+            FileStatsSnapshot snapshot;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                snapshot = m_retired;
+                for(const FileStats* block : m_threads)
+                {
+                    snapshot.add(*block);
+                }
+            }
+            snapshot.ns_per_tick = file_clock::ns_per_tick();
+            return snapshot;
+        }
+
+        /***
+        * @brief   Name and counters of every live File.
+        */
+        std::vector<std::pair<std::string, FileStatsSnapshot>> files()
+        {
+            std::vector<std::pair<std::string, FileStatsSnapshot>> result;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                result.reserve(m_files.size());
+                for(const FileCounters* counters : m_files)
+                {
+                    result.emplace_back(counters->name, FileStatsSnapshot());
+                    result.back().second.add(counters->owned);
+                    result.back().second.add(counters->foreign);
+                }
+            }
+            double ns_per_tick = file_clock::ns_per_tick();
+            for(auto& entry : result)
+            {
+                entry.second.ns_per_tick = ns_per_tick;
+            }
+            return result;
+        }
+
+        /***
+        * @brief   Process totals followed by one table per live File that did any I/O.
+        */
+        std::string to_text()
+        {
+            std::string text = "==================== I/O statistics: all files ====================\n" + totals().to_text();
+            for(const auto& [name, snapshot] : files())
+            {
+                if(snapshot[FileOp::Open].calls + snapshot[FileOp::Read].calls + snapshot[FileOp::Write].calls == 0)
+                {
+                    continue;
+                }
+                text += "==================== " + name + " ====================\n" + snapshot.to_text();
+            }
+            return text;
+        }
+
+        /***
+        * @brief   {"totals": {...}, "files": [{"name": ..., "ops": {...}}, ...]}, see
+        *          FileStatsSnapshot::to_json().
+        */
+        std::string to_json()
+        {
+            std::string json = "{\"totals\": " + totals().to_json() + ", \"files\": [";
+            bool first = true;
+            for(const auto& [name, snapshot] : files())
+            {
+                std::string escaped;
+                for(char c : name)
+                {
+                    if(c == '"' || c == '\\')
+                    {
+                        escaped += '\\';
+                    }
+                    escaped += c;
+                }
+                json += std::string(first ? "" : ", ") + "{\"name\": \"" + escaped + "\", \"ops\": " + snapshot.to_json() + "}";
+                first = false;
+            }
+            return json + "]}";
+        }
+
+        /***
+        * @brief   Writes to_text() to out, e.g. from a signal-free shutdown path.
+        */
+        void dump(FILE* out = stderr)
+        {
+            std::string text = to_text();
+            fwrite(text.data(), 1, text.size(), out);
+        }
+
+        //==================== REGISTRATION ====================
+        void add_thread(FileStats* block)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_threads.push_back(block);
+        }
+
+        // Folds the block of an exiting thread into the retired totals
+        void remove_thread(FileStats* block)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_retired.add(*block);
+            std::erase(m_threads, block);
+        }
+
+        void add_file(FileCounters* counters, const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            counters->name = name;
+            m_files.push_back(counters);
+        }
+
+        void rename_file(FileCounters* counters, const std::string& name)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            counters->name = name;
+        }
+
+        void remove_file(FileCounters* counters)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            std::erase(m_files, counters);
+        }
+};
+
+namespace file_stats_detail
+{
+    // Set once the calling thread's block is gone. Trivially destructible, so
+    // it can still be read while the thread's other thread_locals and, for the
+    // main thread, the static objects are destroyed.
+    inline thread_local bool thread_exited = false;
+
+    struct exited_tag
+    {
+    };
+
+    // Block of the calling thread, registered on its first I/O
+    struct ThreadStats
+    {
+        FileStats stats;
+        uint32_t countdown = file_stats_sample_period; // reads and writes until the next sampled one
+        const bool shared = false;                     // block of exited threads, every call atomic and timed
+
+        ThreadStats()
+        {
+            FileStatsRegistry::instance().add_thread(&stats);
+        }
+
+        explicit ThreadStats(exited_tag) : shared(true)
+        {
+            FileStatsRegistry::instance().add_thread(&stats); // never removed
+        }
+
+        ~ThreadStats()
+        {
+            if(!shared)
+            {
+                FileStatsRegistry::instance().remove_thread(&stats);
+                thread_exited = true;
+            }
+        }
+    };
+
+    /***
+    * @brief   Block of the calling thread.
+    *
+    * @details Once the thread's own block was destroyed, e.g. when a File with
+    *          static storage duration is closed at exit, the calls go to one
+    *          process-wide block that is never destroyed instead.
+    */
+    inline ThreadStats& thread_stats()
+    {
+        if(thread_exited)
+        {
+            static ThreadStats* exited = new ThreadStats(exited_tag());
+            return *exited;
+        }
+        thread_local ThreadStats block;
+        return block;
+    }
+}
+
+// Per-file counters owned by a File, allocated and registered on the first
+// open. Moves with the File, so the registry entry stays valid.
+class FileStatsHandle
+{
+    private:
+        FileCounters* m_stats; // NULL until attached, or if allocation failed
+
+    public:
+        FileStatsHandle() noexcept : m_stats(NULL)
+        {
+        }
+
+        FileStatsHandle(FileStatsHandle&& other) noexcept : m_stats(other.m_stats)
+        {
+            other.m_stats = NULL;
+        }
+
+        FileStatsHandle& operator=(FileStatsHandle&& other) noexcept
+        {
+            if(this != &other)
+            {
+                release();
+                m_stats = other.m_stats;
+                other.m_stats = NULL;
+            }
+            return *this;
+        }
+
+        ~FileStatsHandle() noexcept
+        {
+            release();
+        }
+
+        /***
+        * @brief   Names the counters after a (re)open, registering them the first time
+        *          with the calling thread as owner.
+        *
+        * @details Statistics are silently skipped for this File if the counters
+        *          can not be allocated.
+        */
+        void attach(const std::string& name) noexcept
+        {
+            try
+            {
+                if(m_stats)
+                {
+                    FileStatsRegistry::instance().rename_file(m_stats, name);
+                    return;
+                }
+                m_stats = new(std::nothrow) FileCounters();
+                if(m_stats)
+                {
+                    m_stats->owner = &file_stats_detail::thread_stats().stats;
+                    FileStatsRegistry::instance().add_file(m_stats, name);
+                }
+            }
+            catch(...)
+            {
+                delete m_stats; // copying the name failed
+                m_stats = NULL;
+            }
+        }
+
+        /***
+        * @brief   Counts a character call, never timed.
+        */
+        template <bool Shared>
+        void count(FileOp op, uint64_t bytes) const noexcept
+        {
+            record<Shared>(file_stats_detail::thread_stats(), op, bytes, false, 0);
+        }
+
+        /***
+        * @brief   Counts one call in the block of thread and in the File's counters.
+        *
+        * @param[in]   elapsed: ticks of a sampled call, 0 if it was not sampled.
+        * @param[in]   Shared: whether threads other than the owner may use the File
+        *              at the same time; an UnlockedFile is never shared that way.
+        */
+        template <bool Shared>
+        void record(file_stats_detail::ThreadStats& thread, FileOp op, uint64_t bytes, bool timeable, uint64_t elapsed) const noexcept
+        {
+            thread.stats.record(op, bytes, timeable, elapsed, thread.shared);
+            if(m_stats)
+            {
+                if((!Shared || m_stats->owner == &thread.stats) && !thread.shared)
+                {
+                    m_stats->owned.record(op, bytes, timeable, elapsed, false);
+                }
+                else
+                {
+                    m_stats->foreign.record(op, bytes, timeable, elapsed, true);
+                }
+            }
+        }
+
+        /***
+        * @brief   Current counters, all zero before the first open.
+        */
+        FileStatsSnapshot snapshot() const
+        {
+            FileStatsSnapshot snapshot;
+            if(m_stats)
+            {
+                snapshot.add(m_stats->owned);
+                snapshot.add(m_stats->foreign);
+                snapshot.ns_per_tick = file_clock::ns_per_tick();
+            }
+            return snapshot;
+        }
+
+    private:
+        void release() noexcept
+        {
+            if(m_stats)
+            {
+                FileStatsRegistry::instance().remove_file(m_stats);
+                delete m_stats;
+                m_stats = NULL;
+            }
+        }
+};
+
+// Counts one call from construction to destruction, timing it when it is
+// sampled: every call of the rare operations, every
+// file_stats_sample_period-th read or write of the thread.
+template <bool Shared>
+class FileStatsScope
+{
+    private:
+        const FileStatsHandle& m_handle;
+        file_stats_detail::ThreadStats& m_thread;
+        FileOp m_op;
+        uint64_t m_start; // ticks at construction, 0 if not sampled
+        uint64_t m_bytes; // bytes transferred so far
+
+    public:
+        FileStatsScope(const FileStatsHandle& handle, FileOp op) noexcept
+            : m_handle(handle), m_thread(file_stats_detail::thread_stats()), m_op(op), m_start(0), m_bytes(0)
+        {
+            if((op != FileOp::Read && op != FileOp::Write) || m_thread.shared)
+            {
+                m_start = file_clock::ticks();
+            }
+            else if(--m_thread.countdown == 0)
+            {
+                m_thread.countdown = file_stats_sample_period;
+                m_start = file_clock::ticks();
+            }
+        }
+
+        FileStatsScope(const FileStatsScope&) = delete;
+        FileStatsScope& operator=(const FileStatsScope&) = delete;
+
+        ~FileStatsScope() noexcept
+        {
+            uint64_t elapsed = 0;
+            if(m_start)
+            {
+                elapsed = file_clock::ticks() - m_start;
+                elapsed = elapsed ? elapsed : 1; // 0 marks a call that was not sampled
+            }
+            m_handle.template record<Shared>(m_thread, m_op, m_bytes, true, elapsed);
+        }
+
+        void add_bytes(uint64_t bytes) noexcept
+        {
+            m_bytes += bytes;
+        }
+};
+
+#else
+// Statistics compiled out: empty types the optimizer removes completely.
+class FileStatsHandle
+{
+    public:
+        void attach(const std::string&) noexcept
+        {
+        }
+
+        template <bool Shared>
+        void count(FileOp, uint64_t) const noexcept
+        {
+        }
+};
+
+template <bool Shared>
+class FileStatsScope
+{
+    public:
+        FileStatsScope(const FileStatsHandle&, FileOp) noexcept
+        {
+        }
+
+        void add_bytes(uint64_t) noexcept
+        {
+        }
+};
+#endif
+
+
+#endif  // _FILE_STATS_H
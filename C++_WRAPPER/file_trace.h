@@ -0,0 +1,464 @@
+#ifndef _FILE_TRACE_H
+#define _FILE_TRACE_H
+
+// Header inclusion
+#include <cstdint>   // for offsets and byte counts
+#include <cstdio>    // for FILE and fileno
+#include "file_stats.h" // for FileOp and file_op_name
+#if defined(FILE_ENABLE_TRACE)
+#include <atomic>    // for the ring positions and slots
+#include <memory>    // for the ring storage
+#include <mutex>     // for the registry
+#include <new>       // for nothrow ring allocation
+#include <string>    // for thread names and the JSON dump
+#include <vector>    // for the registered rings
+#include "file_clock.h" // for the timestamps
+#if defined(_WIN32)
+#include <process.h> // for _getpid
+#else
+#include <unistd.h>  // for getpid
+#endif
+#if defined(__linux__)
+#include <sys/syscall.h> // for SYS_gettid
+#endif
+#endif
+
+
+
+#if defined(FILE_ENABLE_TRACE)
+//==================== I/O Trace Recorder ====================
+// Compiled in with -DFILE_ENABLE_TRACE. Every File call is logged as one
+// event (start, duration, operation, fd, offset, bytes) into a ring buffer
+// of the calling thread, and FileTraceRegistry dumps the rings as Chrome
+// trace JSON for chrome://tracing or ui.perfetto.dev. Each ring has a
+// single writer and is read without stopping it: the writer announces the
+// slot it is about to overwrite, the reader drops whatever was overwritten
+// while it copied. When a ring is full the oldest events are overwritten.
+// Character calls (getchar, putchar) are not traced.
+
+#if !defined(FILE_TRACE_CAPACITY)
+#define FILE_TRACE_CAPACITY 8192
+#endif
+
+inline constexpr size_t file_trace_capacity = FILE_TRACE_CAPACITY; // events kept per thread
+inline constexpr size_t file_trace_retired_threads = 16;           // exited threads whose events are kept
+
+static_assert((file_trace_capacity & (file_trace_capacity - 1)) == 0 && file_trace_capacity > 0,
+              "FILE_TRACE_CAPACITY must be a power of two");
+
+// One traced call, as read back from a ring
+struct FileTraceEvent
+{
+    uint64_t start;    // ticks at entry
+    uint64_t duration; // ticks spent in the call
+    int64_t offset;    // file offset for positioned calls and seeks, -1 otherwise
+    uint64_t bytes;    // bytes transferred
+    const char* name;  // function name, a string literal
+    int fd;            // descriptor, -1 if the File had none
+    FileOp op;
+};
+
+// Events of one thread, as returned by FileTraceRegistry::threads()
+struct FileTraceThread
+{
+    uint64_t tid;                       // kernel thread id where available
+    std::string name;                   // set_thread_name(), or "thread <tid>"
+    std::vector<FileTraceEvent> events; // oldest first
+    uint64_t dropped;                   // events overwritten before they were read
+};
+
+// Ring buffer of the events of one thread
+class FileTraceRing
+{
+    private:
+        struct Slot
+        {
+            std::atomic<uint64_t> start{0};
+            std::atomic<uint64_t> duration{0};
+            std::atomic<int64_t> offset{0};
+            std::atomic<uint64_t> bytes{0};
+            std::atomic<const char*> name{NULL};
+            std::atomic<int> fd{0};
+            std::atomic<FileOp> op{FileOp::Read};
+        };
+
+        std::unique_ptr<Slot[]> m_slots;  // file_trace_capacity slots
+        std::atomic<uint64_t> m_claimed;  // events started, the slot of the next one may be in use
+        std::atomic<uint64_t> m_head;     // events completely written
+        uint64_t m_cleared;               // events before this were cleared, guarded by the registry mutex
+
+    public:
+        uint64_t tid;     // guarded by the registry mutex, as are the two below
+        std::string name;
+        bool exited;
+
+        FileTraceRing(uint64_t thread_id)
+            : m_slots(new Slot[file_trace_capacity]), m_claimed(0), m_head(0), m_cleared(0),
+              tid(thread_id), name("thread " + std::to_string(thread_id)), exited(false)
+        {
+        }
+
+        /***
+        * @brief       Appends one event, called only by the owning thread.
+        */
+        void push(const FileTraceEvent& event) noexcept
+        {
+            uint64_t head = m_head.load(std::memory_order_relaxed);
+            m_claimed.store(head + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release); // announce the claim before overwriting the slot
+            Slot& slot = m_slots[head & (file_trace_capacity - 1)];
+            slot.start.store(event.start, std::memory_order_relaxed);
+            slot.duration.store(event.duration, std::memory_order_relaxed);
+            slot.offset.store(event.offset, std::memory_order_relaxed);
+            slot.bytes.store(event.bytes, std::memory_order_relaxed);
+            slot.name.store(event.name, std::memory_order_relaxed);
+            slot.fd.store(event.fd, std::memory_order_relaxed);
+            slot.op.store(event.op, std::memory_order_relaxed);
+            m_head.store(head + 1, std::memory_order_release);
+        }
+
+        /***
+        * @brief       Copies the events still in the ring, oldest first, while the owner may keep writing.
+        *
+        * @param[out]  dropped: events written since the last clear() that are no longer in the ring.
+        */
+        std::vector<FileTraceEvent> read(uint64_t& dropped) const
+        {
+            uint64_t head = m_head.load(std::memory_order_acquire);
+            uint64_t begin = head > file_trace_capacity ? head - file_trace_capacity : 0;
+            begin = begin > m_cleared ? begin : m_cleared;
+            std::vector<FileTraceEvent> events;
+            events.reserve(head - begin);
+            for(uint64_t i = begin; i < head; ++i)
+            {
+                const Slot& slot = m_slots[i & (file_trace_capacity - 1)];
+                events.push_back({slot.start.load(std::memory_order_relaxed), slot.duration.load(std::memory_order_relaxed),
+                                  slot.offset.load(std::memory_order_relaxed), slot.bytes.load(std::memory_order_relaxed),
+                                  slot.name.load(std::memory_order_relaxed), slot.fd.load(std::memory_order_relaxed),
+                                  slot.op.load(std::memory_order_relaxed)});
+            }
+            std::atomic_thread_fence(std::memory_order_acquire); // pairs with the fence in push()
+            uint64_t claimed = m_claimed.load(std::memory_order_relaxed);
+            uint64_t valid = claimed > file_trace_capacity ? claimed - file_trace_capacity : 0;
+            if(valid > begin)
+            {
+                size_t overwritten = static_cast<size_t>(valid > head ? head - begin : valid - begin);
+                events.erase(events.begin(), events.begin() + static_cast<ptrdiff_t>(overwritten));
+                begin += overwritten;
+            }
+            dropped = begin - m_cleared;
+            return events;
+        }
+
+        /***
+        * @brief       Forgets the events written so far.
+        */
+        void clear() noexcept
+        {
+            m_cleared = m_head.load(std::memory_order_acquire);
+        }
+};
+
+
+
+//==================== FileTraceRegistry Class ====================
+// Process-wide list of the per-thread rings. Locked only when a thread
+// starts or stops tracing and when the rings are read, never on the I/O path.
+class FileTraceRegistry
+{
+    private:
+        std::mutex m_mutex;                                // guards the members below and the ring names
+        std::vector<std::unique_ptr<FileTraceRing>> m_rings; // rings of running and recently exited threads
+        std::atomic<bool> m_enabled;                       // whether File calls are recorded
+
+        FileTraceRegistry() : m_enabled(true)
+        {
+            file_clock::origin();
+        }
+
+        static uint64_t current_tid()
+        {
+#if defined(__linux__)
+            return static_cast<uint64_t>(::syscall(SYS_gettid));
+#else
+            static std::atomic<uint64_t> next{1};
+            return next.fetch_add(1, std::memory_order_relaxed);
+#endif
+        }
+
+    public:
+        /***
+        * @brief   To get the process-wide registry.
+        *
+        * @details Never destroyed, so threads with static storage duration
+        *          can still leave it at exit.
+        */
+        static FileTraceRegistry& instance()
+        {
+            static FileTraceRegistry* registry = new FileTraceRegistry();
+            return *registry;
+        }
+
+        FileTraceRegistry(const FileTraceRegistry&) = delete;
+        FileTraceRegistry& operator=(const FileTraceRegistry&) = delete;
+
+        /***
+        * @brief   Starts or stops recording; recording is on from the start.
+        *
+        * @details While stopped, a File call only checks this flag.
+        */
+        void set_enabled(bool enabled) noexcept
+        {
+            m_enabled.store(enabled, std::memory_order_relaxed);
+        }
+
+        bool enabled() const noexcept
+        {
+            return m_enabled.load(std::memory_order_relaxed);
+        }
+
+        /***
+        * @brief   Names the calling thread in the trace, e.g. "flusher".
+        */
+        void set_thread_name(const std::string& name);
+
+        /***
+        * @brief   Forgets every recorded event, e.g. before the section to trace.
+        */
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for(auto& ring : m_rings)
+            {
+                ring->clear();
+            }
+        }
+
+        /***
+        * @brief   Events of every running and recently exited thread.
+        */
+        std::vector<FileTraceThread> threads()
+        {
+            std::vector<FileTraceThread> result;
+            std::lock_guard<std::mutex> lock(m_mutex);
+            result.reserve(m_rings.size());
+            for(const auto& ring : m_rings)
+            {
+                FileTraceThread thread{ring->tid, ring->name, {}, 0};
+                thread.events = ring->read(thread.dropped);
+                result.push_back(std::move(thread));
+            }
+            return result;
+        }
+
+        /***
+        * @brief   Chrome trace event JSON: one complete ("X") event per call with
+        *          fd, offset and bytes as args, and a thread_name event per thread.
+        *
+        * @details Timestamps are microseconds since the registry was created.
+        */
+        std::string to_json()
+        {
+            std::vector<FileTraceThread> all = threads();
+            const uint64_t origin = file_clock::origin().ticks;
+            const double ns_per_tick = file_clock::ns_per_tick();
+#if defined(_WIN32)
+            const long long pid = _getpid();
+#else
+            const long long pid = ::getpid();
+#endif
+            std::string json = "{\"traceEvents\": [";
+            char event[384];
+            uint64_t dropped = 0;
+            bool first = true;
+            for(const FileTraceThread& thread : all)
+            {
+                std::string name;
+                for(char c : thread.name)
+                {
+                    if(c == '"' || c == '\\')
+                    {
+                        name += '\\';
+                    }
+                    name += c;
+                }
+                json += std::string(first ? "" : ",") + "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " + std::to_string(pid) +
+                        ", \"tid\": " + std::to_string(thread.tid) + ", \"args\": {\"name\": \"" + name + "\"}}";
+                first = false;
+                for(const FileTraceEvent& e : thread.events)
+                {
+                    double ts = static_cast<double>(e.start > origin ? e.start - origin : 0) * ns_per_tick / 1000.0;
+                    double dur = static_cast<double>(e.duration) * ns_per_tick / 1000.0;
+                    snprintf(event, sizeof(event),
+                             ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %lld, \"tid\": %llu, "
+                             "\"args\": {\"fd\": %d, \"offset\": %lld, \"bytes\": %llu}}",
+                             e.name, file_op_name(e.op), ts, dur, pid, static_cast<unsigned long long>(thread.tid), e.fd,
+                             static_cast<long long>(e.offset), static_cast<unsigned long long>(e.bytes));
+                    json += event;
+                }
+                dropped += thread.dropped;
+            }
+            return json + "\n], \"displayTimeUnit\": \"ns\", \"otherData\": {\"dropped_events\": " + std::to_string(dropped) + "}}\n";
+        }
+
+        /***
+        * @brief   Writes to_json() to out.
+        */
+        void dump(FILE* out)
+        {
+            std::string json = to_json();
+            fwrite(json.data(), 1, json.size(), out);
+        }
+
+        /***
+        * @brief   Writes to_json() to the file at path, e.g. "io_trace.json".
+        *
+        * @return  false if the file can not be written.
+        */
+        bool save(const std::string& path)
+        {
+            std::string json = to_json();
+            FILE* out = fopen(path.c_str(), "w");
+            if(out == NULL)
+            {
+                return false;
+            }
+            bool written = fwrite(json.data(), 1, json.size(), out) == json.size();
+            return fclose(out) == 0 && written;
+        }
+
+        //==================== REGISTRATION ====================
+        // Ring of a thread on its first traced call, NULL if it can not be allocated
+        FileTraceRing* add_thread() noexcept
+        {
+            try
+            {
+                std::unique_ptr<FileTraceRing> ring(new(std::nothrow) FileTraceRing(current_tid()));
+                if(!ring)
+                {
+                    return NULL;
+                }
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_rings.push_back(std::move(ring));
+                return m_rings.back().get();
+            }
+            catch(...)
+            {
+                return NULL;
+            }
+        }
+
+        // Keeps the ring of an exiting thread, dropping the oldest exited rings
+        // beyond file_trace_retired_threads
+        void remove_thread(FileTraceRing* ring) noexcept
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ring->exited = true;
+            size_t exited = 0;
+            for(size_t i = m_rings.size(); i-- > 0; )
+            {
+                if(m_rings[i]->exited && ++exited > file_trace_retired_threads)
+                {
+                    m_rings.erase(m_rings.begin() + static_cast<ptrdiff_t>(i));
+                }
+            }
+        }
+};
+
+namespace file_trace_detail
+{
+    // Ring of the calling thread, registered on its first traced call
+    struct ThreadRing
+    {
+        FileTraceRing* ring;
+
+        ThreadRing() : ring(FileTraceRegistry::instance().add_thread())
+        {
+        }
+
+        ~ThreadRing()
+        {
+            if(ring)
+            {
+                FileTraceRegistry::instance().remove_thread(ring);
+            }
+        }
+    };
+
+    inline FileTraceRing* thread_ring() noexcept
+    {
+        thread_local ThreadRing holder;
+        return holder.ring;
+    }
+}
+
+inline void FileTraceRegistry::set_thread_name(const std::string& name)
+{
+    FileTraceRing* ring = file_trace_detail::thread_ring();
+    if(ring)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ring->name = name;
+    }
+}
+
+// Records one File call from construction to destruction into the ring of
+// the calling thread.
+class FileTraceScope
+{
+    private:
+        FileTraceRing* m_ring;   // NULL while recording is off
+        FILE* const& m_fp;       // stream of the File, read again at the end for open
+        FileTraceEvent m_event;
+
+    public:
+        FileTraceScope(FileOp op, const char* name, FILE* const& fp, int64_t offset = -1) noexcept
+            : m_ring(FileTraceRegistry::instance().enabled() ? file_trace_detail::thread_ring() : NULL), m_fp(fp),
+              m_event{0, 0, offset, 0, name, -1, op}
+        {
+            if(m_ring)
+            {
+                m_event.fd = fp ? fileno(fp) : -1;
+                m_event.start = file_clock::ticks();
+            }
+        }
+
+        FileTraceScope(const FileTraceScope&) = delete;
+        FileTraceScope& operator=(const FileTraceScope&) = delete;
+
+        ~FileTraceScope() noexcept
+        {
+            if(m_ring)
+            {
+                m_event.duration = file_clock::ticks() - m_event.start;
+                if(m_event.fd < 0 && m_fp)
+                {
+                    m_event.fd = fileno(m_fp); // opened by this call
+                }
+                m_ring->push(m_event);
+            }
+        }
+
+        void add_bytes(uint64_t bytes) noexcept
+        {
+            m_event.bytes += bytes;
+        }
+};
+
+#else
+// Trace compiled out: an empty type the optimizer removes completely.
+class FileTraceScope
+{
+    public:
+        FileTraceScope(FileOp, const char*, FILE* const&, int64_t = -1) noexcept
+        {
+        }
+
+        void add_bytes(uint64_t) noexcept
+        {
+        }
+};
+#endif
+
+
+#endif  // _FILE_TRACE_H
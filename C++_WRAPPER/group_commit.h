@@ -0,0 +1,134 @@
+#ifndef _GROUP_COMMIT_H
+#define _GROUP_COMMIT_H
+
+// Header inclusion
+#include "file.h"               // for File, FileResult and the descriptor helpers
+#include <condition_variable>   // for parking followers during a sync
+#include <cstdint>              // for commit tickets
+#include <mutex>                // for guarding the commit state
+
+
+
+//==================== GroupCommit Class ====================
+// Batches the durability requests of concurrent writers into one fdatasync.
+// Every commit() takes a ticket. The first caller to find no sync running
+// becomes the leader: it flushes the File and runs one fdatasync covering
+// every ticket issued so far, while later callers wait for it, and whoever
+// is still uncovered afterwards leads the next round. N threads committing
+// at once cost one or two syncs instead of N. POSIX only. Must not outlive
+// its File.
+class GroupCommit
+{
+    private:
+        FILE* m_fp;                   // stream flushed before each sync
+        int m_fd;                     // descriptor synced
+        std::mutex m_mutex;           // guards everything below
+        std::condition_variable m_cv; // signals the end of a sync
+        uint64_t m_issued;            // last ticket handed out
+        uint64_t m_durable;           // every ticket up to this one is durable
+        int m_error;                  // errno of the first failed sync, 0 while none failed
+        bool m_syncing;               // a leader is inside fdatasync
+        uint64_t m_sync_count;        // number of fdatasync calls issued
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Prepares group commits on file.
+        *
+        * @param[in]   file: open File the writers share.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        */
+        template <typename ThreadingPolicy>
+        explicit GroupCommit(BasicFile<ThreadingPolicy>& file)
+            : m_fp(file.get_handle()), m_fd(file.get_descriptor()), m_issued(0), m_durable(0),
+              m_error(0), m_syncing(false), m_sync_count(0)
+        {
+        }
+
+        GroupCommit(const GroupCommit&) = delete;
+        GroupCommit& operator=(const GroupCommit&) = delete;
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Waits until everything this thread wrote before the call is durable.
+        *
+        * @details     Data written through the File, buffered or not, and through
+        *              write_at() or a FileCursor is covered. A failed sync is sticky:
+        *              the kernel may already have dropped the dirty pages, so a later
+        *              sync succeeding would prove nothing. Every commit not yet durable
+        *              then fails with the same errno.
+        *
+        * @return      returns true on success otherwise false.
+        */
+        bool commit()
+        {
+            return try_commit().has_value();
+        }
+
+        /***
+        * @brief       Non-throwing counterpart of commit() that keeps the errno.
+        *
+        * @return      nothing on success otherwise the errno of fflush/fdatasync.
+        */
+        FileResult<void> try_commit(std::source_location location = std::source_location::current())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            uint64_t ticket = ++m_issued;
+
+            for(;;)
+            {
+                if(m_durable >= ticket)
+                {
+                    return FileResult<void>();
+                }
+                if(m_error != 0)
+                {
+                    return FileError(m_error, location);
+                }
+                if(m_syncing)
+                {
+                    m_cv.wait(lock);
+                    continue;
+                }
+
+                // Leader: cover every ticket issued so far, including ours
+                m_syncing = true;
+                uint64_t target = m_issued;
+                ++m_sync_count;
+                lock.unlock();
+
+                int error = 0;
+                if(fflush(m_fp) != 0 || file_detail::sync_descriptor(m_fd, true) != 0)
+                {
+                    error = errno ? errno : EIO;
+                }
+
+                lock.lock();
+                m_syncing = false;
+                if(error == 0)
+                {
+                    m_durable = target;
+                }
+                else
+                {
+                    m_error = error;
+                }
+                m_cv.notify_all();
+            }
+        }
+
+        /***
+        * @brief   To get the number of fdatasync calls issued so far.
+        */
+        uint64_t sync_count()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_sync_count;
+        }
+};
+
+
+#endif  // _GROUP_COMMIT_H
@@ -0,0 +1,661 @@
+#ifndef _LOG_FILE_H
+#define _LOG_FILE_H
+
+// Header inclusion
+#include "file.h"              // for File, FileResult and the descriptor helpers
+#include "mapped_file.h"       // for zero-copy recovery scans
+#include <chrono>              // for the group-commit interval
+#include <condition_variable>  // for waiters and the flusher thread
+#include <cstddef>             // for std::byte
+#include <cstdint>             // for record framing and sequence numbers
+#include <cstring>             // for memcpy
+#include <mutex>               // for guarding the log state
+#include <optional>            // for the segment, opened after recovery
+#include <span>                // for record payloads
+#include <string>              // for segment names
+#include <string_view>         // for text records
+#include <thread>              // for the flusher thread
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>         // for the SSE4.2 crc32 instruction
+#define LOG_FILE_HAS_SSE42_CRC 1
+#endif
+
+
+
+// Helpers for LogFile framing
+namespace file_detail
+{
+    // CRC-32C (Castagnoli) lookup tables for slicing-by-8, built at compile time
+    struct Crc32cTables
+    {
+        uint32_t table[8][256];
+
+        constexpr Crc32cTables() : table()
+        {
+            for(uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for(int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0x82F63B78u : crc >> 1;
+                }
+                table[0][i] = crc;
+            }
+            for(uint32_t i = 0; i < 256; ++i)
+            {
+                for(int slice = 1; slice < 8; ++slice)
+                {
+                    table[slice][i] = (table[slice - 1][i] >> 8) ^ table[0][table[slice - 1][i] & 0xFF];
+                }
+            }
+        }
+    };
+
+    inline constexpr Crc32cTables crc32c_tables;
+
+    /***
+    * @brief       Portable CRC-32C, eight bytes per step.
+    */
+    inline uint32_t crc32c_software(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        const auto& t = crc32c_tables.table;
+        crc = ~crc;
+        while(length >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            word ^= crc; // little endian: the low four bytes take the running crc
+            crc = t[7][word & 0xFF] ^ t[6][(word >> 8) & 0xFF] ^ t[5][(word >> 16) & 0xFF] ^ t[4][(word >> 24) & 0xFF] ^
+                  t[3][(word >> 32) & 0xFF] ^ t[2][(word >> 40) & 0xFF] ^ t[1][(word >> 48) & 0xFF] ^ t[0][word >> 56];
+            data += 8;
+            length -= 8;
+        }
+        while(length--)
+        {
+            crc = (crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF];
+        }
+        return ~crc;
+    }
+
+#if defined(LOG_FILE_HAS_SSE42_CRC)
+    /***
+    * @brief       CRC-32C with the SSE4.2 crc32 instruction.
+    */
+    __attribute__((target("sse4.2"))) inline uint32_t crc32c_sse42(uint32_t crc, const unsigned char* data, size_t length)
+    {
+        uint64_t crc64 = ~crc;
+        while(length >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, 8);
+            crc64 = _mm_crc32_u64(crc64, word);
+            data += 8;
+            length -= 8;
+        }
+        uint32_t crc32 = static_cast<uint32_t>(crc64);
+        while(length--)
+        {
+            crc32 = _mm_crc32_u8(crc32, *data++);
+        }
+        return ~crc32;
+    }
+#endif
+
+    /***
+    * @brief       CRC-32C of data, continuing from crc (0 to start).
+    *
+    * @details     Uses the crc32 instruction when the CPU has SSE4.2, checked once.
+    */
+    inline uint32_t crc32c(uint32_t crc, const void* data, size_t length)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+#if defined(LOG_FILE_HAS_SSE42_CRC)
+        static const bool has_sse42 = __builtin_cpu_supports("sse4.2");
+        if(has_sse42)
+        {
+            return crc32c_sse42(crc, bytes, length);
+        }
+#endif
+        return crc32c_software(crc, bytes, length);
+    }
+}
+
+
+
+// Settings of a LogFile
+struct LogOptions
+{
+    uint64_t segment_size = 64ULL << 20;   // bytes preallocated per segment file
+    std::chrono::microseconds commit_interval = std::chrono::microseconds(1000); // how often the flusher thread syncs, 0 for no flusher
+    size_t buffer_size = 1 << 20;          // stdio buffer batching appends into large writes
+};
+
+// What LogFile::replay() found
+struct LogRecovery
+{
+    uint64_t records = 0;       // valid records replayed
+    uint64_t last_sequence = 0; // sequence number of the last valid record, 0 if none
+    uint64_t segments = 0;      // segment files holding valid records
+    bool torn = false;          // stopped at a damaged record rather than the clean end
+    uint64_t torn_segment = 0;  // index of the segment the damaged record is in
+    uint64_t torn_offset = 0;   // its byte offset in that segment
+};
+
+
+
+//==================== LogFile Class ====================
+// Append-only write-ahead log on top of File. Records are framed as
+// [u32 length][u32 masked crc32c of length and payload][payload] in native
+// byte order and numbered from 1. They go to segment files path.000001,
+// path.000002, ... each preallocated to segment_size and starting with a
+// 16 byte header, so a crash leaves zeros, not garbage, after the last
+// write. Appends are buffered and made durable in batches: a flusher
+// thread runs one fdatasync every commit_interval, and wait_durable()
+// callers share it. POSIX only.
+class LogFile
+{
+    public:
+        static constexpr uint32_t segment_magic = 0x474F4C57; // "WLOG"
+        static constexpr uint32_t segment_version = 1;
+        static constexpr uint64_t header_size = 16;          // magic, version, first sequence
+        static constexpr uint64_t record_overhead = 8;       // length and crc
+
+    private:
+        std::string m_path;            // segment files are m_path + ".NNNNNN"
+        LogOptions m_options;          // settings given at open
+        std::optional<File> m_segment; // segment being appended to
+        uint64_t m_segment_index;      // index of m_segment
+        uint64_t m_offset;             // write offset in m_segment
+        uint64_t m_last_sequence;      // sequence of the last appended record
+        uint64_t m_durable_sequence;   // every record up to this one is durable
+        uint64_t m_sync_count;         // fdatasync calls issued
+        int m_error;                   // errno of the first failed write or sync, sticky
+        bool m_syncing;                // a thread is inside fdatasync without the lock
+        bool m_stop;                   // tells the flusher to exit
+        std::mutex m_mutex;            // guards everything above
+        std::condition_variable m_cv;         // signals the end of a sync
+        std::condition_variable m_flusher_cv; // wakes the flusher early on shutdown
+        std::thread m_flusher;                // runs sync every commit_interval
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Opens the log at path, recovering it if it exists.
+        *
+        * @details     Existing segments are scanned like replay(). Everything after
+        *              the last valid record is cleared, since later sectors may have
+        *              reached the disk before a torn one, and segments after a torn
+        *              record are removed. Appending continues after the last valid
+        *              record, which is made durable first.
+        *
+        * @param[in]   path: path prefix of the segment files.
+        * @param[in]   options: segment size, commit interval and buffer size.
+        *
+        * @throws      error_opning_file: If a segment can not be created or opened.
+        * @throws      std::system_error: If recovery can not write to a segment.
+        */
+        explicit LogFile(const std::string& path, LogOptions options = LogOptions())
+            : m_path(path), m_options(options), m_segment_index(0), m_offset(0), m_last_sequence(0),
+              m_durable_sequence(0), m_sync_count(0), m_error(0), m_syncing(false), m_stop(false)
+        {
+            LogRecovery recovery;
+            uint64_t end_offset = scan(m_path, recovery, [](uint64_t, std::span<const std::byte>) {});
+
+            if(recovery.segments == 0)
+            {
+                remove_segments_from(1);
+                create_segment(1, 1);
+            }
+            else
+            {
+                remove_segments_from(recovery.segments + 1);
+                m_segment_index = recovery.segments;
+                m_segment.emplace(segment_name(m_path, m_segment_index), "r+b", BufferMode::Full, m_options.buffer_size);
+                m_segment->try_truncate(static_cast<int64_t>(end_offset)).value();
+                (void)m_segment->try_preallocate(0, static_cast<int64_t>(m_options.segment_size)); // best effort, see create_segment()
+                m_segment->try_sync_data().value();
+                m_segment->seek64(static_cast<int64_t>(end_offset), SeekOrigin::Set);
+                m_offset = end_offset;
+            }
+            m_last_sequence = recovery.last_sequence;
+            m_durable_sequence = recovery.last_sequence;
+
+            if(m_options.commit_interval.count() > 0)
+            {
+                m_flusher = std::thread([this] { run_flusher(); });
+            }
+        }
+
+        LogFile(const LogFile&) = delete;
+        LogFile& operator=(const LogFile&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Stops the flusher and makes every appended record durable.
+        */
+        ~LogFile() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_flusher_cv.notify_all();
+            if(m_flusher.joinable())
+            {
+                m_flusher.join();
+            }
+            (void)try_sync();
+        }
+
+
+
+        //==================== APPENDING ====================
+        /***
+        * @brief       Appends one record, buffered.
+        *
+        * @details     Thread-safe. The record is not durable before wait_durable()
+        *              or sync() returns for its sequence number, or the flusher has
+        *              synced it. Rolls over to a new segment when the current one is
+        *              full.
+        *
+        * @param[in]   payload: record bytes, up to segment_size - 24.
+        *
+        * @return      sequence number of the record, EFBIG if it can not fit in a segment,
+        *              or the errno of the first failed write or sync of this log.
+        */
+        FileResult<uint64_t> try_append(std::span<const std::byte> payload,
+                                        std::source_location location = std::source_location::current())
+        {
+            if(payload.size() > m_options.segment_size - header_size - record_overhead || payload.size() > UINT32_MAX)
+            {
+                return FileError(EFBIG, location);
+            }
+
+            uint32_t length = static_cast<uint32_t>(payload.size());
+            unsigned char header[record_overhead];
+            memcpy(header, &length, sizeof(length));
+            uint32_t crc = mask_crc(file_detail::crc32c(file_detail::crc32c(0, header, sizeof(length)), payload.data(), payload.size()));
+            memcpy(header + sizeof(length), &crc, sizeof(crc));
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(m_error == 0 && m_offset + record_overhead + length > m_options.segment_size)
+            {
+                if(m_syncing)
+                {
+                    m_cv.wait(lock); // the syncing thread uses the descriptor of this segment
+                    continue;
+                }
+                roll();
+            }
+            if(m_error != 0)
+            {
+                return FileError(m_error, location);
+            }
+
+            if(m_segment->write(header, 1, sizeof(header)) != sizeof(header) ||
+               (length != 0 && m_segment->write(payload.data(), 1, payload.size()) != payload.size()))
+            {
+                m_error = errno ? errno : EIO;
+                return FileError(m_error, location);
+            }
+            m_offset += record_overhead + length;
+            return ++m_last_sequence;
+        }
+
+        /***
+        * @brief       Throwing form of try_append().
+        *
+        * @throws      std::system_error: If the record can not be appended.
+        */
+        uint64_t append(std::span<const std::byte> payload)
+        {
+            return try_append(payload).value();
+        }
+
+        uint64_t append(std::string_view text)
+        {
+            return append(std::as_bytes(std::span<const char>(text.data(), text.size())));
+        }
+
+
+
+        //==================== DURABILITY ====================
+        /***
+        * @brief       Waits until every record up to sequence is durable.
+        *
+        * @details     With a commit interval the flusher thread's next sync covers
+        *              all waiters at once. Without one the first waiter syncs for
+        *              everyone waiting, like GroupCommit.
+        *
+        * @return      nothing on success otherwise the errno of the failed sync.
+        */
+        FileResult<void> try_wait_durable(uint64_t sequence, std::source_location location = std::source_location::current())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return wait_locked(lock, sequence, m_options.commit_interval.count() == 0, location);
+        }
+
+        bool wait_durable(uint64_t sequence)
+        {
+            return try_wait_durable(sequence).has_value();
+        }
+
+        /***
+        * @brief       Makes every record appended so far durable now, without waiting
+        *              for the commit interval.
+        */
+        FileResult<void> try_sync(std::source_location location = std::source_location::current())
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return wait_locked(lock, m_last_sequence, true, location);
+        }
+
+        bool sync()
+        {
+            return try_sync().has_value();
+        }
+
+
+
+        //==================== GETTER FUNCTIONS ====================
+        /***
+        * @brief   To get the sequence number of the last appended record, 0 if none.
+        */
+        uint64_t last_sequence()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_last_sequence;
+        }
+
+        /***
+        * @brief   To get the sequence number up to which records are durable.
+        */
+        uint64_t durable_sequence()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_durable_sequence;
+        }
+
+        /***
+        * @brief   To get the number of fdatasync calls issued for appends.
+        */
+        uint64_t sync_count()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_sync_count;
+        }
+
+        /***
+        * @brief   To get the index of the segment being appended to.
+        */
+        uint64_t segment_index()
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_segment_index;
+        }
+
+
+
+        //==================== RECOVERY ====================
+        /***
+        * @brief       Calls fn(sequence, payload) for every valid record of the log at path.
+        *
+        * @details     Each segment is memory-mapped and checked record by record.
+        *              The scan ends at the zeros after the last record, or at the
+        *              first torn record: a bad length, a bad checksum or a segment
+        *              header out of sequence. Nothing is modified.
+        *
+        * @param[in]   path: path prefix of the segment files.
+        * @param[in]   fn: callable taking (uint64_t, std::span<const std::byte>), the
+        *              span is only valid during the call.
+        *
+        * @return      counts and where a torn record was found.
+        */
+        template <typename Fn>
+        static LogRecovery replay(const std::string& path, Fn&& fn)
+        {
+            LogRecovery recovery;
+            scan(path, recovery, fn);
+            return recovery;
+        }
+
+        /***
+        * @brief       Name of segment index of the log at path.
+        */
+        static std::string segment_name(const std::string& path, uint64_t index)
+        {
+            char suffix[32];
+            snprintf(suffix, sizeof(suffix), ".%06llu", static_cast<unsigned long long>(index));
+            return path + suffix;
+        }
+
+    private:
+        // Rotated crc plus a constant, so a log stored inside another log does not verify by accident
+        static uint32_t mask_crc(uint32_t crc)
+        {
+            return ((crc >> 15) | (crc << 17)) + 0xA282EAD8u;
+        }
+
+        /***
+        * @brief       Scans the segments of path in order.
+        *
+        * @return      end offset of the valid records in the last valid segment.
+        */
+        template <typename Fn>
+        static uint64_t scan(const std::string& path, LogRecovery& recovery, Fn&& fn)
+        {
+            uint64_t end_offset = 0;
+            for(uint64_t index = 1; ; ++index)
+            {
+                FileResult<File> probe = File::try_open(segment_name(path, index), "rb");
+                if(!probe)
+                {
+                    break;
+                }
+                MappedFile map(*probe, MapOptions::Sequential);
+                std::span<const std::byte> bytes = map.bytes();
+
+                uint32_t magic = 0;
+                uint32_t version = 0;
+                uint64_t first_sequence = 0;
+                if(bytes.size() >= header_size)
+                {
+                    memcpy(&magic, bytes.data(), 4);
+                    memcpy(&version, bytes.data() + 4, 4);
+                    memcpy(&first_sequence, bytes.data() + 8, 8);
+                }
+                if(magic != segment_magic || version != segment_version || first_sequence != recovery.last_sequence + 1)
+                {
+                    // a header never made it to disk: the roll to this segment was torn
+                    recovery.torn = true;
+                    recovery.torn_segment = index;
+                    recovery.torn_offset = 0;
+                    break;
+                }
+
+                recovery.segments = index;
+                uint64_t offset = header_size;
+                for(;;)
+                {
+                    if(bytes.size() - offset < record_overhead)
+                    {
+                        break; // clean end, the segment is full
+                    }
+                    uint32_t length;
+                    uint32_t stored_crc;
+                    memcpy(&length, bytes.data() + offset, 4);
+                    memcpy(&stored_crc, bytes.data() + offset + 4, 4);
+                    if(length == 0 && stored_crc == 0)
+                    {
+                        break; // clean end, preallocated zeros
+                    }
+
+                    const std::byte* payload = bytes.data() + offset + record_overhead;
+                    if(length > bytes.size() - offset - record_overhead ||
+                       mask_crc(file_detail::crc32c(file_detail::crc32c(0, &length, sizeof(length)), payload, length)) != stored_crc)
+                    {
+                        recovery.torn = true;
+                        recovery.torn_segment = index;
+                        recovery.torn_offset = offset;
+                        break;
+                    }
+
+                    fn(recovery.last_sequence + 1, std::span<const std::byte>(payload, length));
+                    ++recovery.last_sequence;
+                    ++recovery.records;
+                    offset += record_overhead + length;
+                }
+                end_offset = offset;
+                if(recovery.torn)
+                {
+                    break;
+                }
+            }
+            return end_offset;
+        }
+
+        /***
+        * @brief       Removes segment files from index on, up to the first missing one.
+        */
+        void remove_segments_from(uint64_t index)
+        {
+            while(std::remove(segment_name(m_path, index).c_str()) == 0)
+            {
+                ++index;
+            }
+        }
+
+        /***
+        * @brief       Creates, preallocates and syncs a new segment and makes it current.
+        *
+        * @details     Preallocation is best effort: without it the log still works,
+        *              appends just pay for block allocation as they go.
+        */
+        void create_segment(uint64_t index, uint64_t first_sequence)
+        {
+            File segment(segment_name(m_path, index), "w+b", BufferMode::Full, m_options.buffer_size);
+            (void)segment.try_preallocate(0, static_cast<int64_t>(m_options.segment_size));
+
+            unsigned char header[header_size];
+            memcpy(header, &segment_magic, 4);
+            memcpy(header + 4, &segment_version, 4);
+            memcpy(header + 8, &first_sequence, 8);
+            if(segment.write(header, 1, sizeof(header)) != sizeof(header) || !segment.sync_all() || file_detail::sync_parent_directory(m_path) != 0)
+            {
+                FileError::from_errno().throw_error();
+            }
+
+            m_segment.emplace(std::move(segment));
+            m_segment_index = index;
+            m_offset = header_size;
+        }
+
+        /***
+        * @brief       Makes the current segment durable and switches to the next one.
+        *
+        * @details     Called with m_mutex held and no sync running. Failures are
+        *              recorded in m_error.
+        */
+        void roll()
+        {
+            try
+            {
+                if(!m_segment->sync_data())
+                {
+                    FileError::from_errno().throw_error();
+                }
+                m_durable_sequence = m_last_sequence;
+                create_segment(m_segment_index + 1, m_last_sequence + 1);
+            }
+            catch(const std::system_error& e)
+            {
+                m_error = e.code().value();
+            }
+            catch(const std::runtime_error&)
+            {
+                m_error = errno ? errno : EIO;
+            }
+            m_cv.notify_all();
+        }
+
+        /***
+        * @brief       Waits for sequence to become durable, syncing if lead is true
+        *              and no other sync is running. Called with m_mutex held.
+        */
+        FileResult<void> wait_locked(std::unique_lock<std::mutex>& lock, uint64_t sequence, bool lead, std::source_location location)
+        {
+            for(;;)
+            {
+                if(m_durable_sequence >= sequence)
+                {
+                    return FileResult<void>();
+                }
+                if(m_error != 0)
+                {
+                    return FileError(m_error, location);
+                }
+                if(m_syncing || !lead)
+                {
+                    m_cv.wait(lock);
+                    continue;
+                }
+                sync_locked(lock);
+            }
+        }
+
+        /***
+        * @brief       Flushes the buffered records and runs one fdatasync for all of them.
+        *
+        * @details     Called with m_mutex held and no sync running. The buffer is
+        *              flushed under the lock, but fdatasync runs without it so
+        *              appenders keep going; roll() waits for it to finish.
+        */
+        void sync_locked(std::unique_lock<std::mutex>& lock)
+        {
+            m_syncing = true;
+            ++m_sync_count;
+            uint64_t target = m_last_sequence;
+            int fd = m_segment->get_descriptor();
+            bool flushed = m_segment->flush();
+            int error = flushed ? 0 : (errno ? errno : EIO);
+
+            lock.unlock();
+            if(error == 0 && file_detail::sync_descriptor(fd, true) != 0)
+            {
+                error = errno ? errno : EIO;
+            }
+            lock.lock();
+
+            m_syncing = false;
+            if(error == 0)
+            {
+                m_durable_sequence = target > m_durable_sequence ? target : m_durable_sequence;
+            }
+            else if(m_error == 0)
+            {
+                m_error = error;
+            }
+            m_cv.notify_all();
+        }
+
+        /***
+        * @brief       Flusher thread: syncs outstanding records every commit_interval.
+        */
+        void run_flusher()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            while(!m_stop)
+            {
+                m_flusher_cv.wait_for(lock, m_options.commit_interval);
+                if(!m_stop && !m_syncing && m_error == 0 && m_durable_sequence < m_last_sequence)
+                {
+                    sync_locked(lock);
+                }
+            }
+        }
+};
+
+
+#endif  // _LOG_FILE_H
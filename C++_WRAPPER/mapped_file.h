@@ -0,0 +1,299 @@
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+// Header inclusion
+#include "file.h"        // for File and its exception classes
+#include <cstddef>       // for std::byte
+#include <span>          // for zero-copy byte views
+#include <string_view>   // for zero-copy text views
+#include <sys/mman.h>    // for mmap, munmap, madvise (POSIX only)
+#include <sys/stat.h>    // for fstat
+#include <fcntl.h>       // for ::open
+#include <unistd.h>      // for ::close
+
+
+
+// Enum class for mapping options, combine with operator|
+enum class MapOptions : unsigned
+{
+    None       = 0,      // Lazy mapping, pages are faulted in on first touch
+    Populate   = 1 << 0, // Prefault the whole file at map time (MAP_POPULATE)
+    HugePages  = 1 << 1, // Ask for transparent huge pages (MADV_HUGEPAGE)
+    Sequential = 1 << 2  // Aggressive readahead for front-to-back scans (MADV_SEQUENTIAL)
+};
+
+inline MapOptions operator|(MapOptions lhs, MapOptions rhs)
+{
+    return static_cast<MapOptions>(static_cast<unsigned>(lhs) | static_cast<unsigned>(rhs));
+}
+
+inline bool operator&(MapOptions lhs, MapOptions rhs)
+{
+    return (static_cast<unsigned>(lhs) & static_cast<unsigned>(rhs)) != 0;
+}
+
+
+
+//==================== MappedFile Class ====================
+// Read-only memory-mapped companion of File. Scans go straight over the
+// page cache instead of being copied out of the stdio buffer by fread.
+class MappedFile
+{
+    private:
+        const std::byte* m_data; // start of the mapping, NULL for an empty file
+        size_t m_size;           // size of the mapping in bytes
+        bool m_is_open;          // true while the mapping is valid
+        std::string m_filename;  // for storing file name
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Maps the whole file read-only.
+        *
+        * @details     Opens filename read-only, maps its current size and closes
+        *              the descriptor again; the mapping keeps the file alive.
+        *              An empty file is valid and yields empty views.
+        *
+        * @param[in]   filename: name of the file to map.
+        * @param[in]   options: MapOptions flags controlling prefaulting and paging advice.
+        *
+        * @throws      error_opning_file: If Unable to open or map the file.
+        */
+        explicit MappedFile(const std::string& filename, MapOptions options = MapOptions::None)
+            : m_data(NULL), m_size(0), m_is_open(false), m_filename(filename)
+        {
+            int fd = ::open(m_filename.c_str(), O_RDONLY | O_CLOEXEC);
+            if(fd < 0 || !map(fd, options))
+            {
+                std::string error_msg = "Error: Failed to map \"" + m_filename + "\" - Reason: " + strerror(errno) +
+                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]";
+                if(fd >= 0)
+                {
+                    ::close(fd);
+                }
+                throw error_opning_file(error_msg);
+            }
+
+            ::close(fd);
+        }
+
+        /***
+        * @brief       Maps the file underlying an already open File.
+        *
+        * @details     Pending buffered output of file is flushed first so the
+        *              mapping sees everything written so far. The File stays
+        *              usable and may be closed independently of the mapping.
+        *              file must have been opened with a readable mode.
+        *
+        * @param[in]   file: open File whose contents should be mapped.
+        * @param[in]   options: MapOptions flags controlling prefaulting and paging advice.
+        *
+        * @throws      bad_file_discriptor: If file is not open.
+        * @throws      error_opning_file: If Unable to map the file.
+        */
+        explicit MappedFile(File& file, MapOptions options = MapOptions::None)
+            : m_data(NULL), m_size(0), m_is_open(false), m_filename(file.get_filename())
+        {
+            file.flush(); // throws bad_file_discriptor on a closed file
+
+            if(!map(fileno(file.get_handle()), options))
+            {
+                std::string error_msg = "Error: Failed to map \"" + m_filename + "\" - Reason: " + strerror(errno) +
+                                        ". Line[" + std::to_string(__LINE__) + "], Function[" + __func__ + "], File[" + __FILE__ + "]";
+                throw error_opning_file(error_msg);
+            }
+        }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /***
+        * @brief       Takes over the mapping of other, leaving other closed.
+        */
+        MappedFile(MappedFile&& other) noexcept
+            : m_data(other.m_data), m_size(other.m_size), m_is_open(other.m_is_open),
+              m_filename(std::move(other.m_filename))
+        {
+            other.m_data = NULL;
+            other.m_size = 0;
+            other.m_is_open = false;
+        }
+
+        /***
+        * @brief       Unmaps the current mapping and takes over the mapping of other.
+        */
+        MappedFile& operator=(MappedFile&& other) noexcept
+        {
+            if(this != &other)
+            {
+                close();
+                m_data = other.m_data;
+                m_size = other.m_size;
+                m_is_open = other.m_is_open;
+                m_filename = std::move(other.m_filename);
+                other.m_data = NULL;
+                other.m_size = 0;
+                other.m_is_open = false;
+            }
+            return *this;
+        }
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Unmaps the file.
+        */
+        ~MappedFile() noexcept
+        {
+            close();
+        }
+
+
+
+        //==================== STATUS / HELPER FUNCTIONS ====================
+        /***
+        * @brief   Checks mapping status.
+        *
+        * @return  true while the mapping is valid otherwise false.
+        */
+        bool is_open() const
+        {
+            return m_is_open;
+        }
+
+        /***
+        * @brief   Unmaps the file, views obtained earlier become dangling.
+        */
+        void close()
+        {
+            if(m_data)
+            {
+                munmap(const_cast<std::byte*>(m_data), m_size);
+            }
+            m_data = NULL;
+            m_size = 0;
+            m_is_open = false;
+        }
+
+
+
+        //==================== VIEWS ====================
+        /***
+        * @brief   Zero-copy view of the mapped bytes.
+        *
+        * @return  span over the whole file, valid until close() or destruction.
+        *
+        * @throws  bad_file_discriptor: If the mapping is closed.
+        */
+        std::span<const std::byte> bytes() const
+        {
+            if(!is_open())
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return std::span<const std::byte>(m_data, m_size);
+        }
+
+        /***
+        * @brief   Zero-copy text view of the mapped bytes.
+        *
+        * @return  string_view over the whole file, valid until close() or destruction.
+        *
+        * @throws  bad_file_discriptor: If the mapping is closed.
+        */
+        std::string_view view() const
+        {
+            if(!is_open())
+            {
+                throw_bad_file_discriptor(__func__, __LINE__);
+            }
+
+            return std::string_view(reinterpret_cast<const char*>(m_data), m_size);
+        }
+
+
+
+        //==================== GETTER FUNCTIONS ====================
+        /***
+        * @brief   To get mapped size.
+        *
+        * @return  number of mapped bytes, 0 when closed or empty.
+        */
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        /***
+        * @brief   To get file name.
+        *
+        * @return  returns file name, empty when mapped from a temporary File.
+        */
+        const std::string& get_filename() const
+        {
+            return m_filename;
+        }
+
+    private:
+        /***
+        * @brief       Maps the current size of fd and applies options.
+        *
+        * @return      true on success otherwise false with errno set.
+        */
+        bool map(int fd, MapOptions options)
+        {
+            struct stat st;
+            if(fstat(fd, &st) != 0)
+            {
+                return false;
+            }
+
+            m_size = static_cast<size_t>(st.st_size);
+            if(m_size == 0)
+            {
+                m_is_open = true; // mmap rejects zero length, an empty view is all we need
+                return true;
+            }
+
+            int flags = MAP_PRIVATE;
+#ifdef MAP_POPULATE
+            if(options & MapOptions::Populate)
+            {
+                flags |= MAP_POPULATE;
+            }
+#endif
+            void* addr = mmap(NULL, m_size, PROT_READ, flags, fd, 0);
+            if(addr == MAP_FAILED)
+            {
+                m_size = 0;
+                return false;
+            }
+
+            // paging advice is best effort, a refusal leaves a working mapping
+#ifdef MADV_HUGEPAGE
+            if(options & MapOptions::HugePages)
+            {
+                madvise(addr, m_size, MADV_HUGEPAGE);
+            }
+#endif
+            if(options & MapOptions::Sequential)
+            {
+                madvise(addr, m_size, MADV_SEQUENTIAL);
+            }
+
+            m_data = static_cast<const std::byte*>(addr);
+            m_is_open = true;
+            return true;
+        }
+
+        [[noreturn]] FILE_COLD_NOINLINE static void throw_bad_file_discriptor(const char* function, int line)
+        {
+            throw bad_file_discriptor("Error: Bad file discriptor. Line[" + std::to_string(line) + "], Function[" +
+                                      function + "], File[" + __FILE__ + "]");
+        }
+};
+
+
+#endif  // _MAPPED_FILE_H
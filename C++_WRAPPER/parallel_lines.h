@@ -0,0 +1,240 @@
+#ifndef _PARALLEL_LINES_H
+#define _PARALLEL_LINES_H
+
+// Header inclusion
+#include "file.h"        // for File, BufferPool, the positional I/O helpers and find_byte
+#include "thread_pool.h" // for the workers
+#include <exception>     // for passing worker exceptions to the caller
+#include <latch>         // for waiting on every chunk
+#include <optional>      // for the per-chunk results
+#include <string>        // for lines crossing a read block
+#include <string_view>   // for the lines handed to the map function
+#include <vector>        // for chunk ranges and results
+#include <sys/stat.h>    // for the file size
+
+
+
+// Byte range [begin, end) of a file holding whole lines
+struct LineRange
+{
+    int64_t begin = 0; // first byte of the first line
+    int64_t end = 0;   // one past the '\n' of the last line, or end of file
+};
+
+namespace file_detail
+{
+    /***
+    * @brief       Offset just past the first '\n' at or after offset, or size if none.
+    */
+    inline int64_t next_line_start(int fd, int64_t offset, int64_t size)
+    {
+        char probe[4096];
+        while(offset < size)
+        {
+            size_t want = static_cast<size_t>(size - offset) < sizeof(probe) ? static_cast<size_t>(size - offset) : sizeof(probe);
+            size_t got = pread_full(fd, probe, want, offset);
+            if(got == 0)
+            {
+                FileError::from_errno().throw_error();
+            }
+            const char* newline = find_byte(probe, got, '\n');
+            if(newline)
+            {
+                return offset + (newline - probe) + 1;
+            }
+            offset += static_cast<int64_t>(got);
+        }
+        return size;
+    }
+
+    /***
+    * @brief       Calls on_line(std::string_view) for every line of range, without
+    *              its '\n', reading with pread through a pooled buffer.
+    */
+    template <typename OnLine>
+    void for_each_line_in(int fd, LineRange range, OnLine&& on_line)
+    {
+        const size_t block = 1 << 20;
+        char* buffer = BufferPool::instance().acquire(block);
+        std::string carry; // start of a line cut by the end of the previous block
+        try
+        {
+            for(int64_t offset = range.begin; offset < range.end; )
+            {
+                size_t want = static_cast<size_t>(range.end - offset) < block ? static_cast<size_t>(range.end - offset) : block;
+                size_t got = pread_full(fd, buffer, want, offset);
+                if(got != want)
+                {
+                    FileError::from_errno().throw_error(); // the file shrank or the read failed
+                }
+                offset += static_cast<int64_t>(got);
+
+                const char* pos = buffer;
+                const char* end = buffer + got;
+                const char* newline;
+                while((newline = find_byte(pos, static_cast<size_t>(end - pos), '\n')) != NULL)
+                {
+                    if(carry.empty())
+                    {
+                        on_line(std::string_view(pos, static_cast<size_t>(newline - pos)));
+                    }
+                    else
+                    {
+                        carry.append(pos, static_cast<size_t>(newline - pos));
+                        on_line(std::string_view(carry));
+                        carry.clear();
+                    }
+                    pos = newline + 1;
+                }
+                carry.append(pos, static_cast<size_t>(end - pos));
+            }
+            if(!carry.empty())
+            {
+                on_line(std::string_view(carry)); // last line without '\n'
+            }
+        }
+        catch(...)
+        {
+            BufferPool::instance().release(buffer, block);
+            throw;
+        }
+        BufferPool::instance().release(buffer, block);
+    }
+}
+
+
+
+/***
+* @brief       Splits file into about chunk_count ranges of whole lines.
+*
+* @details     Cut points are spread evenly by size, then each moves forward past
+*              the next '\n' with a small pread, so no line is split and nothing is
+*              read twice. Ranges that would be empty, such as within one very long
+*              line, are dropped. The stream position of file is not used.
+*
+* @param[in]   file: open, readable File.
+* @param[in]   chunk_count: wanted number of ranges, at least 1.
+*
+* @return      contiguous ranges covering the whole file, none for an empty file.
+*
+* @throws      bad_file_discriptor: If file is not open.
+* @throws      std::system_error: If the size or a boundary can not be read.
+*/
+template <typename ThreadingPolicy>
+std::vector<LineRange> split_lines(const BasicFile<ThreadingPolicy>& file, size_t chunk_count)
+{
+    int fd = file.get_descriptor();
+    struct stat info;
+    if(fstat(fd, &info) != 0)
+    {
+        FileError::from_errno().throw_error();
+    }
+    int64_t size = static_cast<int64_t>(info.st_size);
+    if(chunk_count == 0)
+    {
+        chunk_count = 1;
+    }
+
+    std::vector<LineRange> ranges;
+    int64_t begin = 0;
+    for(size_t i = 1; i <= chunk_count && begin < size; ++i)
+    {
+        int64_t end = size;
+        if(i < chunk_count)
+        {
+            int64_t target = static_cast<int64_t>(static_cast<double>(size) * static_cast<double>(i) / static_cast<double>(chunk_count));
+            if(target <= begin)
+            {
+                continue;
+            }
+            end = file_detail::next_line_start(fd, target - 1, size); // a '\n' right before target already ends a line
+        }
+        ranges.push_back(LineRange{begin, end});
+        begin = end;
+    }
+    return ranges;
+}
+
+/***
+* @brief       Map-reduce over the lines of file on a ThreadPool.
+*
+* @details     The file is split with split_lines() and every range becomes one
+*              task. A task starts from a copy of init and calls map(T&, std::string_view)
+*              for each of its lines, read with pread so tasks never share a stream
+*              and split with the SIMD byte kernels. The results are folded with
+*              reduce(T, T) in file order, so reduce only needs to be associative. Lines are passed without their
+*              '\n' and are only valid during the call. Pending output of file is
+*              flushed first. Must not be called from a task running on pool.
+*
+* @param[in]   file: open, readable File.
+* @param[in]   pool: workers running the tasks.
+* @param[in]   init: starting value of every chunk, e.g. 0 for a count.
+* @param[in]   map: folds one line into a chunk's value.
+* @param[in]   reduce: combines the values of two neighbouring chunks.
+* @param[in]   chunk_count: number of ranges, 0 for four per worker to balance uneven lines.
+*
+* @return      reduce of all chunk values, or init for an empty file.
+*
+* @throws      bad_file_discriptor: If file is not open.
+* @throws      std::system_error: If reading fails.
+* @throws      Whatever map or reduce throw, the first chunk's exception in file order.
+*/
+template <typename T, typename ThreadingPolicy, typename MapFn, typename ReduceFn>
+T parallel_lines(BasicFile<ThreadingPolicy>& file, ThreadPool& pool, T init, MapFn map, ReduceFn reduce, size_t chunk_count = 0)
+{
+    file.flush(); // throws bad_file_discriptor on a closed file
+    if(chunk_count == 0)
+    {
+        chunk_count = pool.size() * 4;
+    }
+
+    std::vector<LineRange> ranges = split_lines(file, chunk_count);
+    if(ranges.empty())
+    {
+        return init;
+    }
+
+    int fd = file.get_descriptor();
+    std::vector<std::optional<T>> results(ranges.size()); // optional keeps std::vector<bool> out
+    std::vector<std::exception_ptr> errors(ranges.size());
+    std::latch done(static_cast<std::ptrdiff_t>(ranges.size()));
+
+    std::vector<std::function<void()>> tasks;
+    tasks.reserve(ranges.size());
+    for(size_t i = 0; i < ranges.size(); ++i)
+    {
+        tasks.emplace_back([&, i] {
+            try
+            {
+                T value = init; // task-local, so neighbouring results never share a cache line per line
+                file_detail::for_each_line_in(fd, ranges[i], [&](std::string_view line) { map(value, line); });
+                results[i] = std::move(value);
+            }
+            catch(...)
+            {
+                errors[i] = std::current_exception();
+            }
+            done.count_down();
+        });
+    }
+    pool.post(tasks);
+    done.wait();
+
+    for(std::exception_ptr& error : errors)
+    {
+        if(error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    T total = std::move(*results[0]);
+    for(size_t i = 1; i < results.size(); ++i)
+    {
+        total = reduce(std::move(total), std::move(*results[i]));
+    }
+    return total;
+}
+
+
+#endif  // _PARALLEL_LINES_H
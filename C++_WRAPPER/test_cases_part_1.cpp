@@ -5,6 +5,38 @@
 #include <iostream>  // For test status output (different from library output)
 #include <limits>    // For numeric_limits
 #include <algorithm> // For std::equal
+#include <cstdint>   // For uintptr_t
+#include <span>      // For typed read/write
+#include <thread>    // For concurrent positional reads
+#include <atomic>    // For the allocation counter
+#include <new>       // For replacing operator new/delete
+#include <cstdlib>   // For malloc/free
+#include <type_traits> // For move/copy traits
+#include <system_error> // For FileResult::value()
+#include <sys/stat.h>  // For file size and allocated blocks
+#include <fcntl.h>     // For opening raw descriptors
+#include <unistd.h>    // For pipe
+#include <sys/mman.h>  // For mincore
+
+// Counts every operator new, so tests can check that File needs no heap memory of its own.
+// Kept out of line so GCC does not pair the inlined malloc/free with new/delete expressions.
+static std::atomic<size_t> g_allocation_count(0);
+
+[[gnu::noinline]] void* operator new(std::size_t size) {
+    ++g_allocation_count;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
 
 // Helper function to clean up test files
 void cleanup_file(const std::string& filename) {
@@ -19,6 +51,21 @@ void test_text_io();
 void test_positioning();
 void test_reopen();
 void test_exceptions();
+void test_lines();
+void test_buffering();
+void test_single_threaded();
+void test_typed_io();
+void test_positional_io();
+void test_move_semantics();
+void test_error_codes();
+void test_print();
+void test_scan();
+void test_file_space();
+void test_durability();
+void test_from_descriptor();
+void test_copy_to();
+void test_count_lines();
+void test_access_pattern();
 
 int main() {
     try {
@@ -31,6 +78,21 @@ int main() {
         test_positioning();
         test_reopen();
         test_exceptions();
+        test_lines();
+        test_buffering();
+        test_single_threaded();
+        test_typed_io();
+        test_positional_io();
+        test_move_semantics();
+        test_error_codes();
+        test_print();
+        test_scan();
+        test_file_space();
+        test_durability();
+        test_from_descriptor();
+        test_copy_to();
+        test_count_lines();
+        test_access_pattern();
 
         std::cout << "\n--- All File Class Tests Passed Successfully! ---" << std::endl;
     } catch (const std::exception& e) {
@@ -406,4 +468,1126 @@ void test_exceptions() {
 
     std::cout << "Exception Handling Test Passed." << std::endl;
     cleanup_file(test_file); // Cleanup the file created in the second test
-}
\ No newline at end of file
+}
+
+void test_lines() {
+    std::cout << "\nTesting lines() iteration..." << std::endl;
+    const std::string test_file = "test_lines.txt";
+    cleanup_file(test_file);
+
+    const std::string long_line(10000, 'x'); // far beyond getstring's default 64
+    {
+        File writer(test_file, "w");
+        assert(writer.putstring("first\n"));
+        assert(writer.putstring((long_line + "\n").c_str()));
+        assert(writer.putstring("\n"));
+        assert(writer.putstring("no newline at end"));
+    }
+
+    // 1. Range-for sees every line, whole and without '\n'
+    {
+        File reader(test_file, "r");
+        std::vector<std::string> seen;
+        for (std::string_view line : reader.lines()) {
+            seen.emplace_back(line);
+        }
+        assert(seen.size() == 4);
+        assert(seen[0] == "first");
+        assert(seen[1] == long_line);
+        assert(seen[2].empty());
+        assert(seen[3] == "no newline at end");
+        assert(reader.is_eof());
+    }
+
+    // 2. Leaving the loop early keeps the stream right after the last line
+    {
+        File reader(test_file, "r");
+        for (std::string_view line : reader.lines()) {
+            assert(line == "first");
+            break;
+        }
+        assert(reader.getchar() == 'x');
+    }
+
+    // 3. Empty file yields no lines, closed file throws
+    {
+        File writer(test_file, "w");
+        writer.close();
+        File reader(test_file, "r");
+        size_t count = 0;
+        for (std::string_view line : reader.lines()) {
+            (void)line;
+            ++count;
+        }
+        assert(count == 0);
+
+        reader.close();
+        bool caught_bad_fd = false;
+        try {
+            reader.lines();
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+
+    std::cout << "lines() Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+// Size of a file as seen by another reader, i.e. what has left the stdio buffer
+long visible_size(const std::string& filename) {
+    File reader(filename, "rb");
+    reader.seek(0L, SeekOrigin::End);
+    return reader.tell();
+}
+
+void test_buffering() {
+    std::cout << "\nTesting buffering (set_buffer/BufferPool)..." << std::endl;
+    const std::string test_file = "test_buffering.txt";
+    cleanup_file(test_file);
+
+    const std::string block(8192, 'b'); // larger than the libc default buffer
+
+    // 1. Large full buffer holds data back until flush
+    {
+        File writer(test_file, "w", BufferMode::Full, 1024 * 1024);
+        assert(writer.putstring(block.c_str()));
+        assert(visible_size(test_file) == 0);
+        assert(writer.flush());
+        assert(visible_size(test_file) == static_cast<long>(block.size()));
+    }
+
+    // 2. Line buffering flushes on newline, no buffering flushes every call
+    {
+        File writer(test_file, "w");
+        assert(writer.set_buffer(BufferMode::Line));
+        assert(writer.putstring("partial"));
+        assert(visible_size(test_file) == 0);
+        assert(writer.putstring(" line\n"));
+        assert(visible_size(test_file) == 13);
+    }
+    {
+        File writer(test_file, "w", BufferMode::None);
+        assert(writer.putchar('x') == 'x');
+        assert(visible_size(test_file) == 1);
+    }
+
+    // 3. Policy survives reopen
+    {
+        File writer(test_file, "w", BufferMode::Full, 64 * 1024);
+        assert(writer.reopen(std::string("w")));
+        assert(writer.putstring(block.c_str()));
+        assert(visible_size(test_file) == 0);
+    }
+
+    // 4. Pool hands back the same aligned buffer instead of allocating again
+    BufferPool& pool = BufferPool::instance();
+    size_t size = BufferPool::round_size(100 * 1000);
+    assert(size == 128 * 1024);
+    char* first = pool.acquire(size);
+    assert(reinterpret_cast<uintptr_t>(first) % BufferPool::alignment == 0);
+    pool.release(first, size);
+    char* second = pool.acquire(size);
+    assert(second == first);
+    pool.release(second, size);
+
+    size_t cached_before = pool.cached_count();
+    for (int i = 0; i < 1000; ++i) {
+        File writer(test_file, "w", BufferMode::Full, 256 * 1024);
+        assert(writer.putchar('a') == 'a');
+    }
+    assert(pool.cached_count() <= cached_before + 1);
+
+    // 5. Closed file throws
+    bool caught_bad_fd = false;
+    try {
+        File writer(test_file, "w");
+        writer.close();
+        writer.set_buffer(BufferMode::Full);
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Buffering Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_single_threaded() {
+    std::cout << "\nTesting UnlockedFile (SingleThreaded policy)..." << std::endl;
+    const std::string test_file = "test_unlocked.txt";
+    cleanup_file(test_file);
+
+    // 1. Same results as the locking File
+    {
+        UnlockedFile writer(test_file, "w");
+        assert(writer.putchar('O') == 'O');
+        assert(writer.putchar('K') == 'K');
+        assert(writer.putchar('\n') == '\n');
+        assert(writer.putstring("0123456789\n"));
+        assert(writer.printInFile("%d\n", 42));
+    }
+    {
+        UnlockedFile reader(test_file, "r");
+        assert(reader.getchar() == 'O');
+        assert(reader.getchar() == 'K');
+        assert(reader.getchar() == '\n');
+
+        char buffer[8];
+        assert(reader.getstring(buffer, sizeof(buffer)) != nullptr); // split like fgets
+        assert(strcmp(buffer, "0123456") == 0);
+        assert(reader.getstring(buffer, sizeof(buffer)) != nullptr);
+        assert(strcmp(buffer, "789\n") == 0);
+        assert(reader.getstring(buffer, sizeof(buffer)) != nullptr);
+        assert(strcmp(buffer, "42\n") == 0);
+        assert(reader.getstring(buffer, sizeof(buffer)) == nullptr);
+        assert(reader.getchar() == EOF);
+        assert(reader.is_eof());
+    }
+
+    // 2. Closed file still throws
+    bool caught_bad_fd = false;
+    try {
+        UnlockedFile fp(test_file, "r");
+        fp.close();
+        fp.getchar();
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "UnlockedFile Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+struct Record {
+    int id;
+    double value;
+    char tag[4];
+};
+
+// Typed I/O only accepts trivially copyable element types
+template <typename T>
+concept can_read_span = requires(File& fp, std::span<T> items) { fp.read(items); };
+static_assert(can_read_span<Record>);
+static_assert(!can_read_span<std::string>);
+static_assert(!can_read_span<const int>);
+
+void test_typed_io() {
+    std::cout << "\nTesting typed read/write over spans..." << std::endl;
+    const std::string test_file = "test_typed.bin";
+    cleanup_file(test_file);
+
+    const std::vector<Record> records_out = {{1, 1.5, "abc"}, {2, -2.25, "def"}, {3, 1e10, "ghi"}};
+    const int tail_out[] = {7, 8, 9};
+
+    // 1. Write a const span and a fixed extent span
+    {
+        File writer(test_file, "wb");
+        assert(writer.write(std::span(records_out)) == records_out.size());
+        assert(writer.write_all(std::span(tail_out)) == 3);
+    }
+
+    // 2. Read back with read and read_exact
+    {
+        File reader(test_file, "rb");
+        Record records_in[3];
+        assert(reader.read(std::span(records_in)) == 3);
+        for (size_t i = 0; i < 3; ++i) {
+            assert(records_in[i].id == records_out[i].id);
+            assert(records_in[i].value == records_out[i].value);
+            assert(strcmp(records_in[i].tag, records_out[i].tag) == 0);
+        }
+
+        std::vector<int> tail_in(3);
+        assert(reader.read_exact(std::span(tail_in)) == 3);
+        assert(std::equal(tail_in.begin(), tail_in.end(), tail_out));
+    }
+
+    // 3. read_exact reports the complete elements before end of file
+    {
+        File reader(test_file, "rb");
+        assert(reader.seek(static_cast<long>(sizeof(records_out[0]) * 3), SeekOrigin::Set));
+        int too_many[5] = {};
+        assert(reader.read_exact(std::span(too_many)) == 3);
+        assert(too_many[2] == 9);
+        assert(reader.is_eof());
+    }
+
+    // 4. Closed file throws
+    bool caught_bad_fd = false;
+    try {
+        File fp(test_file, "rb");
+        fp.close();
+        int value;
+        fp.read_exact(std::span(&value, 1));
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Typed I/O Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_positional_io() {
+    std::cout << "\nTesting positional I/O (read_at/write_at/FileCursor)..." << std::endl;
+    const std::string test_file = "test_positional.bin";
+    cleanup_file(test_file);
+
+    const size_t count = 64 * 1024;
+    std::vector<uint32_t> data_out(count);
+    for (size_t i = 0; i < count; ++i) {
+        data_out[i] = static_cast<uint32_t>(i * 2654435761u);
+    }
+    {
+        File writer(test_file, "wb");
+        assert(writer.write(std::span(data_out)) == count);
+    }
+
+    File fp(test_file, "r+b");
+    assert(fp.seek(12L, SeekOrigin::Set));
+
+    // 1. read_at / write_at leave the stream position alone
+    uint32_t value = 0;
+    assert(fp.read_at(4 * 100, std::span(&value, 1)) == 1);
+    assert(value == data_out[100]);
+    const uint32_t marker = 0xdeadbeef;
+    assert(fp.write_at(4 * 200, std::span(&marker, 1)) == 1);
+    assert(fp.read_at(4 * 200, std::span(&value, 1)) == 1);
+    assert(value == marker);
+    data_out[200] = marker;
+    assert(fp.tell() == 12L);
+
+    // 2. Reads past end of file are short
+    uint32_t past_end[4];
+    assert(fp.read_at(4 * (count - 2), std::span(past_end)) == 2);
+
+    // 3. Several threads with their own cursors on one descriptor
+    const size_t thread_count = 4;
+    const size_t per_thread = count / thread_count;
+    std::vector<int> ok(thread_count, 0);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+        threads.emplace_back([&, t] {
+            FileCursor cursor(fp, static_cast<int64_t>(4 * t * per_thread));
+            std::vector<uint32_t> chunk(256);
+            bool match = true;
+            for (size_t done = 0; done < per_thread; done += chunk.size()) {
+                if (cursor.read(std::span(chunk)) != chunk.size()) {
+                    match = false;
+                    break;
+                }
+                match = match && std::equal(chunk.begin(), chunk.end(), data_out.begin() + t * per_thread + done);
+            }
+            ok[t] = match && cursor.tell() == static_cast<int64_t>(4 * (t + 1) * per_thread);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (int result : ok) {
+        assert(result);
+    }
+    assert(fp.tell() == 12L);
+
+    // 4. Cursor writes advance the cursor only
+    FileCursor cursor(fp, 8);
+    const uint32_t pair[2] = {1, 2};
+    assert(cursor.write(std::span(pair)) == 2);
+    assert(cursor.tell() == 16);
+    cursor.seek(8);
+    uint32_t pair_in[2];
+    assert(cursor.read(std::span(pair_in)) == 2);
+    assert(pair_in[0] == 1 && pair_in[1] == 2);
+
+    // 5. Closed file throws
+    fp.close();
+    bool caught_bad_fd = false;
+    try {
+        fp.read_at(0, std::span(&value, 1));
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Positional I/O Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+static_assert(!std::is_copy_constructible_v<File>);
+static_assert(!std::is_copy_assignable_v<File>);
+static_assert(std::is_nothrow_move_constructible_v<File>);
+static_assert(std::is_nothrow_move_assignable_v<File>);
+
+File make_file(const std::string& filename) {
+    File fp(filename, "w");
+    fp.putstring("made");
+    return fp; // returned by value, no heap indirection
+}
+
+void test_move_semantics() {
+    std::cout << "\nTesting move semantics and containers..." << std::endl;
+    const std::string test_file = "test_move.txt";
+    const std::string other_file = "test_move2.txt";
+    cleanup_file(test_file);
+    cleanup_file(other_file);
+
+    // 1. Move construction leaves the source closed
+    {
+        File source(test_file, "w", BufferMode::Full, 64 * 1024);
+        assert(source.putstring("moved "));
+        File target(std::move(source));
+        assert(!source.is_open());
+        assert(target.is_open());
+        assert(target.get_filename() == test_file);
+        assert(target.putstring("data"));
+
+        // 2. Move assignment closes the old file first
+        File other(other_file, "w");
+        other = std::move(target);
+        assert(!target.is_open());
+        assert(other.get_filename() == test_file);
+        assert(other.putstring("!"));
+
+        // 3. A moved-from File can be reopened
+        assert(source.open(other_file, "w"));
+        assert(source.putstring("reused"));
+    }
+    {
+        File reader(test_file, "r");
+        char buffer[32];
+        assert(reader.getstring(buffer, sizeof(buffer)) != nullptr);
+        assert(strcmp(buffer, "moved data!") == 0);
+    }
+
+    // 4. Return by value
+    {
+        File fp = make_file(test_file);
+        assert(fp.is_open());
+        assert(fp.putstring(" again"));
+    }
+
+    // 5. Thousands of Files in a vector, no allocation beyond the vector itself
+    {
+        const size_t file_count = 2000;
+        std::vector<File> files;
+        files.reserve(file_count);
+
+        size_t allocations_before = g_allocation_count.load();
+        for (size_t i = 0; i < file_count; ++i) {
+            files.emplace_back(); // temporary files, no filename to store
+        }
+#if !defined(FILE_ENABLE_STATS) // with statistics every File allocates its counters
+        assert(g_allocation_count.load() == allocations_before);
+#endif
+
+        // Growing the vector moves every File, only the new storage is allocated
+        allocations_before = g_allocation_count.load();
+        files.emplace_back();
+#if !defined(FILE_ENABLE_STATS)
+        assert(g_allocation_count.load() == allocations_before + 1);
+#endif
+
+        for (File& fp : files) {
+            assert(fp.is_open());
+            assert(fp.putchar('x') == 'x');
+        }
+
+        // Moving the whole container steals the storage
+        allocations_before = g_allocation_count.load();
+        std::vector<File> moved = std::move(files);
+        assert(g_allocation_count.load() == allocations_before);
+        assert(moved.size() == file_count + 1);
+    }
+
+    std::cout << "Move Semantics Test Passed." << std::endl;
+    cleanup_file(test_file);
+    cleanup_file(other_file);
+}
+
+void test_error_codes() {
+    std::cout << "\nTesting non-throwing try_* API..." << std::endl;
+    const std::string test_file = "test_error_codes.txt";
+    const std::string missing_file = "no_such_dir/missing.txt";
+    cleanup_file(test_file);
+
+    // 1. Probing a missing file returns an error instead of throwing
+    unsigned probe_line = __LINE__ + 1;
+    FileResult<File> missing = File::try_open(missing_file, "r");
+    assert(!missing);
+    assert(missing.error().code() == ENOENT);
+    assert(missing.error().error_code() == std::errc::no_such_file_or_directory);
+    assert(missing.error().location().line() == probe_line);
+    std::string message = missing.error().message();
+    assert(message.find(strerror(ENOENT)) == 0);
+    assert(message.find("Line[" + std::to_string(probe_line) + "]") != std::string::npos);
+    assert(message.find("test_error_codes") != std::string::npos);
+
+    bool caught_system_error = false;
+    try {
+        missing.value();
+    } catch (const std::system_error& e) {
+        caught_system_error = e.code().value() == ENOENT;
+    }
+    assert(caught_system_error);
+
+    // 2. Success path, the File moves out of the result
+    FileResult<File> opened = File::try_open(test_file, "w+");
+    assert(opened.has_value());
+    File fp = std::move(opened).value();
+    const char text[] = "try api";
+    FileResult<size_t> written = fp.try_write(text, 1, sizeof(text) - 1);
+    assert(written && *written == sizeof(text) - 1);
+    assert(fp.try_write(NULL, 1, 0).value_or(1) == 0); // empty buffers may be NULL
+    assert(fp.try_flush());
+    FileResult<long> offset = fp.try_tell();
+    assert(offset.value() == static_cast<long>(sizeof(text) - 1));
+
+    FileResult<fpos_t> start = fp.try_get_pos();
+    assert(start);
+    assert(fp.try_seek(0, SeekOrigin::Set));
+    char buffer[16] = {};
+    assert(fp.try_read(buffer, 1, sizeof(buffer)).value_or(0) == sizeof(text) - 1);
+    assert(strcmp(buffer, text) == 0);
+    assert(fp.try_set_pos(*start));
+    assert(fp.tell() == static_cast<long>(sizeof(text) - 1));
+
+    // 3. End of file is a short count, not an error
+    FileResult<size_t> at_eof = fp.try_read(buffer, 1, sizeof(buffer));
+    assert(at_eof && *at_eof == 0);
+
+    // 4. Real I/O failures keep their errno
+    assert(fp.try_seek(-100, SeekOrigin::Set).error().code() == EINVAL);
+    {
+        File read_only(test_file, "r");
+        FileResult<size_t> failed_write = read_only.try_write(text, 1, sizeof(text) - 1);
+        assert(!failed_write);
+        assert(failed_write.error().code() == EBADF);
+        assert(read_only.write(text, 1, sizeof(text) - 1) == 0); // throwing API keeps its old result
+    }
+
+    // 5. A closed file is EBADF, no exception
+    fp.close();
+    assert(fp.try_read(buffer, 1, 1).error().code() == EBADF);
+    assert(fp.try_write(text, 1, 1).error().code() == EBADF);
+    assert(fp.try_flush().error().code() == EBADF);
+    assert(fp.try_tell().error().code() == EBADF);
+    assert(fp.try_reopen("r").error().code() == EBADF);
+
+    // 6. An invalid mode is refused before freopen, reopen() reports it as before
+    {
+        File reader(test_file, "r");
+        assert(reader.try_reopen("invalid mode").error().code() == EINVAL);
+        assert(reader.is_open());
+        assert(reader.try_reopen("rb+").has_value());
+        assert(reader.is_open());
+
+        File other(test_file, "r");
+        bool caught_open_error = false;
+        try {
+            other.reopen("invalid mode");
+        } catch (const error_opning_file& e) {
+            caught_open_error = std::string(e.what()).find("Failed to reopen") != std::string::npos &&
+                                std::string(e.what()).find("Function[reopen]") != std::string::npos;
+        }
+        assert(caught_open_error);
+    }
+
+    std::cout << "Error Code API Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+// Reads the whole file back as a string
+std::string read_all(const std::string& filename) {
+    File fp(filename, "rb");
+    std::string text;
+    char buffer[256];
+    size_t read;
+    while ((read = fp.read(buffer, 1, sizeof(buffer))) > 0) {
+        text.append(buffer, read);
+    }
+    return text;
+}
+
+void test_print() {
+    std::cout << "\nTesting compile-time checked print()..." << std::endl;
+    const std::string test_file = "test_print.txt";
+    cleanup_file(test_file);
+
+    std::string owned = "owned";
+    std::string_view view = "view";
+    std::string long_text(3000, 'x'); // longer than the stack buffer
+    {
+        File fp(test_file, "w");
+        // 1. Integers, bases, width and zero padding
+        assert(fp.print("{} {} {:x} {:X} {:b} [{:5}] [{:05}] [{:05d}]\n", 42, -7LL, 255u, 0xabcULL, 5, 42, -42, 7));
+        // 2. Floating point: shortest, fixed, scientific, general
+        assert(fp.print("{} {:.3f} {:.2f} {:f} {:e} {:.3} [{:8.2f}] [{:08.2f}]\n", 1.5, 3.14159, -0.001, 2.5f, 12345.678, 0.0001234, 3.14159, -3.14159));
+        // 3. Strings, char, bool and escaped braces
+        assert(fp.print("{} {} {} {:.3} [{:6}] {}{:c} {:d} {} {:s} {{literal}}\n", "literal", owned, view, owned, "ab", 'x', 'y', 'A', true, false));
+        // 4. No arguments, long output
+        assert(fp.print("plain}}\n"));
+        assert(fp.print("{}\n", long_text));
+    }
+
+    std::string expected =
+        "42 -7 ff ABC 101 [   42] [-0042] [00007]\n"
+        "1.5 3.142 -0.00 2.500000 1.234568e+04 0.000123 [    3.14] [-0003.14]\n"
+        "literal owned view own [ab    ] xy 65 true false {literal}\n"
+        "plain}\n" + long_text + "\n";
+    assert(read_all(test_file) == expected);
+
+    // 5. Fixed notation matches printf, including rounding ties
+    {
+        File fp(test_file, "w");
+        const double values[] = {0.125, 0.375, 2.5, 1e15, -1e-9, 123456.789, 0.1 + 0.2, 1e300};
+        for (double value : values) {
+            assert(fp.print("{:.2f} {:.0f} {:.9f} {:.12f}\n", value, value, value, value));
+        }
+        fp.close();
+
+        std::string printed;
+        for (double value : values) {
+            char line[2048];
+            snprintf(line, sizeof(line), "%.2f %.0f %.9f %.12f\n", value, value, value, value);
+            printed += line;
+        }
+        assert(read_all(test_file) == printed);
+    }
+
+    // long double stays fixed-point beyond the sink's room
+    {
+        File fp(test_file, "w");
+        assert(fp.print("{:.2f}|{:12.1f}", 1e600L, -1.5e3000L));
+        fp.close();
+        char line[8192];
+        snprintf(line, sizeof(line), "%.2Lf|%12.1Lf", 1e600L, -1.5e3000L);
+        assert(read_all(test_file) == line);
+    }
+
+    // 6. UnlockedFile takes the same format strings
+    {
+        UnlockedFile fp(test_file, "w");
+        assert(fp.print("{}-{:x}", 1, 255));
+    }
+    assert(read_all(test_file) == "1-ff");
+
+    // 7. Closed file throws like printInFile
+    bool caught_bad_fd = false;
+    try {
+        File fp(test_file, "r");
+        fp.close();
+        fp.print("{}", 1);
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Print Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_scan() {
+    std::cout << "\nTesting typed scan()..." << std::endl;
+    const std::string test_file = "test_scan.txt";
+    cleanup_file(test_file);
+    {
+        File fp(test_file, "w");
+        fp.putstring("31 March 2000\n");
+        fp.putstring("  +5\t-2.5e3  x  extra fields\r\n");
+        fp.putstring("1,, 3 ,word\n");
+        fp.putstring("7 12abc\n");
+        fp.putstring("99999999999\n");
+        fp.putstring("\n");
+        fp.putstring("42 tail"); // no final newline
+    }
+
+    File fp(test_file, "r");
+
+    // 1. The sscanf_demo pattern, with the day/month/year as typed fields
+    ScanResult<int, std::string_view, int> date = fp.scan<int, std::string_view, int>();
+    assert(date);
+    assert(date.matched == 3);
+    auto [day, month, year] = date.values;
+    assert(day == 31 && month == "March" && year == 2000);
+
+    // 2. Blank runs, '+' signs, exponents, CRLF and ignored trailing fields
+    ScanResult<long, double, char> mixed = fp.scan<long, double, char>();
+    assert(mixed && mixed.matched == 3);
+    assert(std::get<0>(mixed.values) == 5);
+    assert(std::get<1>(mixed.values) == -2500.0);
+    assert(std::get<2>(mixed.values) == 'x');
+
+    // 3. Explicit separator keeps empty fields and trims blanks
+    ScanResult<int, std::string, int, std::string> csv = fp.scan<int, std::string, int, std::string>(',');
+    assert(csv && csv.matched == 4);
+    assert(std::get<1>(csv.values).empty());
+    assert(std::get<2>(csv.values) == 3);
+    assert(std::get<3>(csv.values) == "word");
+
+    // 4. Partial numbers are rejected with the column of the field
+    ScanResult<int, int> partial = fp.scan<int, int>();
+    assert(partial.status == ScanStatus::InvalidField);
+    assert(partial.matched == 1);
+    assert(std::get<0>(partial.values) == 7);
+    assert(partial.column == 2);
+    assert(partial.line == "7 12abc");
+
+    // 5. Overflow is reported separately
+    ScanResult<int> overflow = fp.scan<int>();
+    assert(overflow.status == ScanStatus::OutOfRange);
+    assert(overflow.column == 0);
+
+    // 6. Empty line: first field missing at the end of the line
+    ScanResult<int> empty = fp.scan<int>();
+    assert(empty.status == ScanStatus::MissingField);
+    assert(empty.matched == 0 && empty.column == 0);
+
+    // 7. Missing field in the last line, then end of file
+    ScanResult<int, std::string_view, int> last = fp.scan<int, std::string_view, int>();
+    assert(last.status == ScanStatus::MissingField);
+    assert(last.matched == 2);
+    assert(last.column == last.line.size());
+    assert(fp.scan<int>().status == ScanStatus::EndOfFile);
+
+    // 8. Closed file throws like scanInFile
+    fp.close();
+    bool caught_bad_fd = false;
+    try {
+        fp.scan<int>();
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Scan Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+// Size and allocated bytes of a file as seen by the OS
+struct stat stat_file(const std::string& filename) {
+    struct stat st;
+    assert(stat(filename.c_str(), &st) == 0);
+    return st;
+}
+
+void test_file_space() {
+    std::cout << "\nTesting 64-bit offsets, preallocate, truncate and punch_hole..." << std::endl;
+    const std::string test_file = "test_file_space.bin";
+    cleanup_file(test_file);
+
+    File fp(test_file, "w+b");
+
+    // 1. seek64/tell64 past 4 GiB (sparse, nothing is written in between)
+    const int64_t far_offset = 5LL * 1024 * 1024 * 1024;
+    assert(fp.seek64(far_offset, SeekOrigin::Set));
+    assert(fp.putchar('z') == 'z');
+    assert(fp.tell64() == far_offset + 1);
+    assert(fp.flush());
+    assert(stat_file(test_file).st_size == far_offset + 1);
+    assert(fp.seek64(-1, SeekOrigin::End));
+    assert(fp.getchar() == 'z');
+    assert(fp.try_seek64(-1, SeekOrigin::Set).error().code() == EINVAL);
+
+    // 2. truncate shrinks the file, the unflushed byte is written before it
+    assert(fp.seek64(0, SeekOrigin::Set));
+    assert(fp.putchar('a') == 'a');
+    assert(fp.truncate(4096));
+    assert(stat_file(test_file).st_size == 4096);
+    assert(fp.seek64(0, SeekOrigin::Set));
+    assert(fp.getchar() == 'a');
+
+    // 3. preallocate with keep_size reserves blocks past the end, without it the file grows
+    const int64_t reserve = 1024 * 1024;
+    FileResult<void> kept = fp.try_preallocate(0, reserve, true);
+    if (kept) {
+        struct stat st = stat_file(test_file);
+        assert(st.st_size == 4096);
+        assert(st.st_blocks * 512 >= reserve);
+    } else {
+        std::cout << "  preallocate(keep_size) not supported here: " << kept.error().message() << std::endl;
+    }
+    assert(fp.preallocate(0, 2 * reserve));
+    assert(stat_file(test_file).st_size == 2 * reserve);
+
+    // 4. punch_hole frees blocks, keeps the size and reads back zeros
+    std::vector<char> ones(static_cast<size_t>(reserve), 1);
+    assert(fp.seek64(0, SeekOrigin::Set));
+    assert(fp.write(ones.data(), 1, ones.size()) == ones.size());
+    FileResult<void> punched = fp.try_punch_hole(0, reserve);
+    if (punched) {
+        struct stat st = stat_file(test_file);
+        assert(st.st_size == 2 * reserve);
+        char byte = 1;
+        assert(fp.read_at(4096, std::span(&byte, 1)) == 1);
+        assert(byte == 0);
+    } else {
+        std::cout << "  punch_hole not supported here: " << punched.error().message() << std::endl;
+    }
+
+    // 5. Closed file
+    fp.close();
+    assert(fp.try_truncate(0).error().code() == EBADF);
+    assert(fp.try_tell64().error().code() == EBADF);
+    bool caught_bad_fd = false;
+    try {
+        fp.preallocate(0, 1);
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "File Space Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_durability() {
+    std::cout << "\nTesting sync_data, sync_all and sync_range..." << std::endl;
+    const std::string test_file = "test_durability.txt";
+    cleanup_file(test_file);
+
+    File fp(test_file, "w+");
+
+    // 1. Each level flushes the stdio buffer first
+    assert(fp.putstring("record one\n"));
+    assert(fp.sync_data());
+    assert(stat_file(test_file).st_size == 11);
+
+    assert(fp.putstring("record two\n"));
+    assert(fp.sync_all());
+    assert(stat_file(test_file).st_size == 22);
+
+    assert(fp.putstring("record three\n"));
+    assert(fp.sync_range(0, 0, false)); // start writeback only
+    assert(stat_file(test_file).st_size == 35);
+    assert(fp.sync_range(11, 24));
+
+    // 2. Closed file
+    fp.close();
+    assert(fp.try_sync_data().error().code() == EBADF);
+    assert(fp.try_sync_range(0, 0).error().code() == EBADF);
+    bool caught_bad_fd = false;
+    try {
+        fp.sync_all();
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "Durability Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_from_descriptor() {
+    std::cout << "\nTesting try_from_descriptor..." << std::endl;
+    const std::string test_file = "test_from_descriptor.txt";
+    cleanup_file(test_file);
+
+    // 1. The File owns the descriptor and writes through it
+    int fd = ::open(test_file.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    assert(fd >= 0);
+    {
+        FileResult<File> fp = File::try_from_descriptor(fd, "w+b", test_file);
+        assert(fp.has_value());
+        assert(fp->get_descriptor() == fd);
+        assert(fp->get_filename() == test_file);
+        assert(fp->putstring("adopted\n"));
+    }
+    assert(fcntl(fd, F_GETFD) == -1 && errno == EBADF); // closed with the File
+    assert(read_all(test_file) == "adopted\n");
+
+    // 2. A mode the descriptor does not allow fails and the descriptor is closed
+    fd = ::open(test_file.c_str(), O_RDONLY | O_CLOEXEC);
+    assert(fd >= 0);
+    FileResult<File> failed = File::try_from_descriptor(fd, "wb", test_file);
+    assert(!failed);
+    assert(failed.error().code() == EINVAL);
+    assert(fcntl(fd, F_GETFD) == -1 && errno == EBADF);
+
+    std::cout << "try_from_descriptor Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_copy_to() {
+    std::cout << "\nTesting copy_to and copy_file..." << std::endl;
+    const std::string src_file = "test_copy_src.bin";
+    const std::string dst_file = "test_copy_dst.bin";
+    cleanup_file(src_file);
+    cleanup_file(dst_file);
+
+    std::string data(3 * 1024 * 1024 + 123, '\0');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    }
+    {
+        File fp(src_file, "wb");
+        assert(fp.write(data.data(), 1, data.size()) == data.size());
+    }
+    assert(chmod(src_file.c_str(), 0640) == 0);
+
+    // 1. Whole file, the destination position moves past the copy
+    File src(src_file, "rb");
+    {
+        File dst(dst_file, "wb");
+        assert(dst.putstring("header:"));
+        CopyResult result = src.copy_to(dst);
+        assert(result.bytes == data.size());
+        assert(result.method != CopyMethod::None);
+        std::cout << "  copied " << result.bytes << " bytes with " << copy_method_name(result.method) << std::endl;
+        assert(dst.tell64() == static_cast<int64_t>(7 + data.size()));
+        assert(dst.putstring(":footer"));
+    }
+    assert(read_all(dst_file) == "header:" + data + ":footer");
+
+    // 2. A range, clipped at end of file, leaves the source position alone
+    assert(src.seek64(100, SeekOrigin::Set));
+    {
+        File dst(dst_file, "wb");
+        assert(src.copy_to(dst, 5000, 10).bytes == 10);
+        assert(src.copy_to(dst, static_cast<int64_t>(data.size()) - 4, 100).bytes == 4);
+        CopyResult past_end = src.copy_to(dst, static_cast<int64_t>(data.size()) + 10);
+        assert(past_end.bytes == 0 && past_end.method == CopyMethod::None);
+    }
+    assert(src.tell64() == 100);
+    assert(read_all(dst_file) == data.substr(5000, 10) + data.substr(data.size() - 4));
+
+    // 3. copy_file replaces the destination and keeps the permission bits
+    CopyResult copied = copy_file(src_file, dst_file);
+    assert(copied.bytes == data.size());
+    assert(read_all(dst_file) == data);
+    assert((stat_file(dst_file).st_mode & 07777) == 0640);
+
+    // 4. Errors
+    assert(try_copy_file("no_such_file.bin", dst_file).error().code() == ENOENT);
+    const std::string link_file = "test_copy_link.bin";
+    cleanup_file(link_file);
+    assert(link(src_file.c_str(), link_file.c_str()) == 0);
+    assert(try_copy_file(src_file, src_file).error().code() == EINVAL); // the source survives
+    assert(try_copy_file(src_file, link_file).error().code() == EINVAL);
+    assert(read_all(src_file) == data);
+    cleanup_file(link_file);
+    {
+        File dst(dst_file, "wb");
+        assert(src.try_copy_to(dst, -1).error().code() == EINVAL);
+        src.close();
+        assert(src.try_copy_to(dst).error().code() == EBADF);
+        bool caught_bad_fd = false;
+        try {
+            src.copy_to(dst);
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+
+    std::cout << "copy_to Test Passed." << std::endl;
+    cleanup_file(src_file);
+    cleanup_file(dst_file);
+}
+
+void test_count_lines() {
+    std::cout << "\nTesting count_lines and the byte scanning kernels..." << std::endl;
+    const std::string test_file = "test_count_lines.txt";
+    cleanup_file(test_file);
+
+    // 1. Every kernel agrees with a plain loop for all lengths and alignments
+    std::vector<char> data(1200);
+    uint32_t seed = 12345;
+    for (char& c : data) {
+        seed = seed * 1103515245 + 12345;
+        c = "ab,\n\xff"[(seed >> 16) % 5];
+    }
+    std::vector<file_detail::ByteScanKernels> kernels;
+    kernels.push_back({file_detail::count_byte_scalar, file_detail::find_byte_scalar, file_detail::find_either_scalar, "scalar"});
+#if defined(__x86_64__) || defined(_M_X64)
+    kernels.push_back({file_detail::count_byte_sse2, file_detail::find_byte_sse2, file_detail::find_either_sse2, "sse2"});
+#endif
+#if defined(FILE_HAS_AVX2_DISPATCH)
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.push_back({file_detail::count_byte_avx2, file_detail::find_byte_avx2, file_detail::find_either_avx2, "avx2"});
+    }
+#endif
+    kernels.push_back(file_detail::byte_scan_kernels());
+    std::cout << "  dispatched kernels: " << file_detail::byte_scan_kernels().name << std::endl;
+    for (const file_detail::ByteScanKernels& kernel : kernels) {
+        for (size_t offset = 0; offset < 40; ++offset) {
+            for (size_t length = 0; offset + length <= data.size(); length += (length < 140 ? 1 : 97)) {
+                const char* p = data.data() + offset;
+                for (char byte : {'\n', ',', '\xff', 'z'}) {
+                    size_t count = 0;
+                    const char* first = NULL;
+                    for (size_t i = 0; i < length; ++i) {
+                        if (p[i] == byte) {
+                            ++count;
+                            first = first ? first : p + i;
+                        }
+                    }
+                    assert(kernel.count(p, length, byte) == count);
+                    assert(kernel.find(p, length, byte) == first);
+                }
+                const char* either = NULL;
+                for (size_t i = 0; i < length && !either; ++i) {
+                    either = (p[i] == ',' || p[i] == '\xff') ? p + i : NULL;
+                }
+                assert(kernel.find_either(p, length, ',', '\xff') == either);
+            }
+        }
+    }
+    std::vector<char> newlines(100000, '\n'); // more than 255 hits per counter lane
+    for (const file_detail::ByteScanKernels& kernel : kernels) {
+        assert(kernel.count(newlines.data(), newlines.size(), '\n') == newlines.size());
+    }
+
+    // 2. count_lines counts from the current position and restores it
+    {
+        File fp(test_file, "w+");
+        assert(fp.count_lines() == 0);
+        std::string text;
+        for (int i = 0; i < 100000; ++i) {
+            text += "line " + std::to_string(i) + "\n";
+        }
+        text += "no newline at the end";
+        assert(fp.write(text.data(), 1, text.size()) == text.size());
+        fp.rewind();
+        assert(fp.count_lines() == 100001);
+        assert(fp.tell() == 0);
+        assert(fp.count_lines(' ') == 100005); // one space per "line N", four more, then the trailing record
+        std::string_view first;
+        for (std::string_view line : fp.lines()) {
+            first = line;
+            break;
+        }
+        assert(first == "line 0");
+        assert(fp.count_lines() == 100000);
+        assert(fp.seek(0, SeekOrigin::End));
+        assert(fp.count_lines() == 0);
+    }
+
+    // 3. Write-only and closed files
+    {
+        File fp(test_file, "w");
+        FileResult<uint64_t> failed = fp.try_count_lines();
+        assert(!failed && failed.error().code() == EBADF);
+        fp.close();
+        assert(fp.try_count_lines().error().code() == EBADF);
+        bool caught_bad_fd = false;
+        try {
+            fp.count_lines();
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+
+    std::cout << "count_lines Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+// Number of pages of filename in the page cache
+size_t resident_pages(const std::string& filename) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    assert(fd >= 0);
+    struct stat info;
+    assert(fstat(fd, &info) == 0);
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t pages = (static_cast<size_t>(info.st_size) + page - 1) / page;
+    void* map = mmap(NULL, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    assert(map != MAP_FAILED);
+    std::vector<unsigned char> residency(pages);
+    assert(mincore(map, static_cast<size_t>(info.st_size), residency.data()) == 0);
+    munmap(map, static_cast<size_t>(info.st_size));
+    ::close(fd);
+    return static_cast<size_t>(std::count_if(residency.begin(), residency.end(), [](unsigned char r) { return r & 1; }));
+}
+
+void test_access_pattern() {
+    std::cout << "\n--- Testing Access Pattern Hints ---" << std::endl;
+    const std::string test_file = "test_access_pattern.txt";
+    cleanup_file(test_file);
+    const std::string content(1 << 20, 'p');
+    {
+        File fp(test_file, "w");
+        assert(fp.write(content.data(), 1, content.size()) == content.size());
+    }
+
+    // 1. Every pattern opens and reads normally, and sticks through open() and reopen()
+    const AccessPattern patterns[] = {AccessPattern::Normal, AccessPattern::Sequential, AccessPattern::Random,
+                                      AccessPattern::UseOnce, AccessPattern::WillNeed};
+    for (AccessPattern pattern : patterns) {
+        File fp(test_file, "r", pattern);
+        assert(fp.access_pattern() == pattern);
+        std::string data(content.size(), '\0');
+        assert(fp.read(data.data(), 1, data.size()) == content.size());
+        assert(data == content);
+    }
+    {
+        File fp;
+        assert(fp.access_pattern() == AccessPattern::Normal);
+        assert(fp.open(test_file, "r", AccessPattern::Random));
+        assert(fp.reopen("r"));
+        assert(fp.access_pattern() == AccessPattern::Random);
+        assert(fp.set_access_pattern(AccessPattern::Sequential));
+        assert(fp.access_pattern() == AccessPattern::Sequential);
+        assert(fp.prefetch(0, 0));
+        assert(fp.prefetch(4096, 65536));
+    }
+
+    // 2. drop_cache writes back and evicts what was just written
+    {
+        File fp(test_file, "r+");
+        assert(fp.write("q", 1, 1) == 1); // still in the stdio buffer
+        assert(fp.drop_cache());
+        assert(resident_pages(test_file) == 0);
+        assert(fp.prefetch(0, 0));
+    }
+    {
+        File fp(test_file, "r");
+        assert(fp.getchar() == 'q');
+    }
+
+    // 3. UseOnce releases the pages read on close()
+    {
+        File warm(test_file, "r");
+        std::string data(content.size(), '\0');
+        assert(warm.read(data.data(), 1, data.size()) == content.size());
+    }
+    assert(resident_pages(test_file) > 0);
+    {
+        File fp(test_file, "r", AccessPattern::UseOnce);
+        std::string data(content.size(), '\0');
+        assert(fp.read(data.data(), 1, data.size()) == content.size());
+    }
+    assert(resident_pages(test_file) == 0);
+
+    // 4. Pipes reject the hint but keep the pattern, closed files throw
+    {
+        int fds[2];
+        assert(pipe(fds) == 0);
+        ::close(fds[1]);
+        FileResult<File> reader = File::try_from_descriptor(fds[0], "r", "pipe");
+        assert(reader);
+        FileResult<void> hinted = reader->try_set_access_pattern(AccessPattern::Random);
+        assert(!hinted && hinted.error().code() == ESPIPE);
+        assert(reader->access_pattern() == AccessPattern::Random);
+        assert(!reader->drop_cache());
+    }
+    {
+        File fp(test_file, "r");
+        fp.close();
+        assert(fp.try_prefetch(0, 0).error().code() == EBADF);
+        assert(fp.try_drop_cache().error().code() == EBADF);
+        assert(fp.try_set_access_pattern(AccessPattern::Random).error().code() == EBADF);
+        bool caught_bad_fd = false;
+        try {
+            fp.drop_cache();
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+
+    std::cout << "Access Pattern Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
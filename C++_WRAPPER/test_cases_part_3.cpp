@@ -0,0 +1,1152 @@
+// The extension tests run with the I/O statistics and the trace recorder
+// compiled in, so the companions are exercised on an instrumented File and
+// test_file_stats and test_file_trace can check what was recorded.
+#if !defined(FILE_ENABLE_STATS)
+#define FILE_ENABLE_STATS
+#endif
+#if !defined(FILE_ENABLE_TRACE)
+#define FILE_ENABLE_TRACE
+#endif
+#include "file.h"
+#include "mapped_file.h"
+#include "async_file.h"
+#include "coro_file.h"
+#include "group_commit.h"
+#include "log_file.h"
+#include "atomic_file.h"
+#include "parallel_lines.h"
+#include "direct_file.h"
+#include "file_stats.h"
+#include "file_trace.h"
+#include "concurrent_appender.h"
+#include <cassert>
+#include <cstring>   // For memcmp
+#include <iostream>  // For test status output
+#include <string>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <unistd.h> // For closing a descriptor behind GroupCommit
+#include <fcntl.h>  // For checking O_APPEND under ConcurrentAppender
+#include <charconv> // For parsing numbers in parallel_lines
+#include <sys/stat.h> // For file sizes
+#include <algorithm> // For std::equal
+
+// Helper function to clean up test files
+void cleanup_file(const std::string& filename) {
+    std::remove(filename.c_str());
+}
+
+// Test function declarations
+void test_mapped_file();
+void test_async_file();
+void test_coro_file();
+void test_group_commit();
+void test_log_file();
+void test_atomic_file_writer();
+void test_parallel_lines();
+void test_direct_file();
+void test_file_stats();
+void test_file_trace();
+void test_concurrent_appender();
+
+int main() {
+    try {
+        std::cout << "--- Running File Extension Tests ---" << std::endl;
+
+        test_mapped_file();
+        test_async_file();
+        test_coro_file();
+        test_group_commit();
+        test_log_file();
+        test_atomic_file_writer();
+        test_parallel_lines();
+        test_direct_file();
+        test_file_stats();
+        test_file_trace();
+        test_concurrent_appender();
+
+        std::cout << "\n--- All File Extension Tests Passed Successfully! ---" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "\n--- Test FAILED: Uncaught exception: " << e.what() << std::endl;
+        return 1;
+    } catch (...) {
+        std::cerr << "\n--- Test FAILED: Unknown exception caught! ---" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+// --- Test Case Implementations ---
+
+void test_mapped_file() {
+    std::cout << "\nTesting MappedFile (mmap views)..." << std::endl;
+    const std::string test_file = "test_mapped.txt";
+    const std::string empty_file = "test_mapped_empty.txt";
+    cleanup_file(test_file);
+    cleanup_file(empty_file);
+
+    const char text[] = "mapped line one\nmapped line two\n";
+    {
+        File writer(test_file, "wb");
+        assert(writer.write(text, 1, sizeof(text) - 1) == sizeof(text) - 1);
+    }
+    { File creator(empty_file, "w"); }
+
+    // 1. Map by name, both views see the file contents
+    {
+        MappedFile map(test_file, MapOptions::Populate | MapOptions::Sequential);
+        assert(map.is_open());
+        assert(map.get_filename() == test_file);
+        assert(map.size() == sizeof(text) - 1);
+        assert(map.view() == text);
+        assert(std::memcmp(map.bytes().data(), text, map.size()) == 0);
+
+        // 2. Move leaves the source closed
+        MappedFile moved(std::move(map));
+        assert(moved.view() == text);
+        assert(!map.is_open());
+    }
+
+    // 3. Empty file maps to empty views
+    {
+        MappedFile map(empty_file);
+        assert(map.is_open());
+        assert(map.size() == 0);
+        assert(map.view().empty());
+        assert(map.bytes().empty());
+    }
+
+    // 4. Map an open File, unflushed output is visible
+    {
+        File fp(test_file, "a+b");
+        assert(fp.putstring("tail"));
+        MappedFile map(fp, MapOptions::HugePages);
+        assert(map.size() == sizeof(text) - 1 + 4);
+        assert(map.view().substr(map.size() - 4) == "tail");
+        fp.close();
+        assert(map.view().substr(0, 6) == "mapped"); // mapping outlives the File
+    }
+
+    // 5. Exceptions match File
+    bool caught_open_error = false;
+    try {
+        MappedFile map("no_such_file_here.txt");
+    } catch (const error_opning_file& e) {
+        caught_open_error = true;
+        std::cout << "  Caught expected open error: " << e.what() << std::endl;
+    }
+    assert(caught_open_error);
+
+    bool caught_bad_fd = false;
+    try {
+        MappedFile map(test_file);
+        map.close();
+        map.view();
+    } catch (const bad_file_discriptor& e) {
+        caught_bad_fd = std::string(e.what()).find("mapped_file.h]") != std::string::npos;
+        std::cout << "  Caught expected bad descriptor error: " << e.what() << std::endl;
+    }
+    assert(caught_bad_fd);
+
+    bool caught_closed_file = false;
+    try {
+        File fp(test_file, "r");
+        fp.close();
+        MappedFile map(fp);
+    } catch (const bad_file_discriptor&) {
+        caught_closed_file = true;
+    }
+    assert(caught_closed_file);
+
+    std::cout << "MappedFile Test Passed." << std::endl;
+    cleanup_file(test_file);
+    cleanup_file(empty_file);
+}
+
+void run_async_backend(AsyncBackend backend, const std::string& test_file) {
+    cleanup_file(test_file);
+    const size_t block_size = 4096;
+    const size_t block_count = 64;
+
+    File fp(test_file, "w+b");
+    AsyncIoEngine engine(16, backend, 2);
+    AsyncFile async_fp(fp, engine);
+
+    // 1. Batched writes through futures, more than the queue depth
+    std::vector<std::vector<char>> blocks(block_count, std::vector<char>(block_size));
+    std::vector<std::future<size_t>> writes;
+    for (size_t i = 0; i < block_count; ++i) {
+        std::fill(blocks[i].begin(), blocks[i].end(), static_cast<char>('A' + i % 26));
+        writes.push_back(async_fp.async_write(static_cast<int64_t>(i * block_size), std::span(blocks[i])));
+    }
+    async_fp.submit();
+    for (std::future<size_t>& write : writes) {
+        assert(write.get() == block_size);
+    }
+
+    // 2. Reads through callbacks, in reverse order
+    std::vector<std::vector<char>> read_back(block_count, std::vector<char>(block_size));
+    std::atomic<size_t> matched(0);
+    for (size_t i = block_count; i-- > 0;) {
+        async_fp.async_read(static_cast<int64_t>(i * block_size), std::span(read_back[i]),
+            [&, i](int64_t result) {
+                if (result == static_cast<int64_t>(block_size) && read_back[i] == blocks[i]) {
+                    ++matched;
+                }
+            });
+    }
+    engine.drain();
+    assert(matched == block_count);
+
+    // 3. Read past end of file completes short
+    char past_end[16];
+    std::future<size_t> short_read = async_fp.async_read(static_cast<int64_t>(block_count * block_size - 8), std::span(past_end));
+    async_fp.submit();
+    assert(short_read.get() == 8);
+
+    // 4. Failures surface as std::system_error
+    File read_only(test_file, "rb");
+    AsyncFile async_ro(read_only, engine);
+    std::future<size_t> failed = async_ro.async_write(0, std::span(past_end));
+    async_ro.submit();
+    bool caught_error = false;
+    try {
+        failed.get();
+    } catch (const std::system_error& e) {
+        caught_error = e.code().value() == EBADF;
+    }
+    assert(caught_error);
+}
+
+void test_async_file() {
+    std::cout << "\nTesting AsyncFile (io_uring and thread pool backends)..." << std::endl;
+    const std::string test_file = "test_async.bin";
+
+    {
+        AsyncIoEngine engine;
+        std::cout << "  Auto backend selected: "
+                  << (engine.backend() == AsyncBackend::IoUring ? "io_uring" : "thread pool") << std::endl;
+        if (engine.backend() == AsyncBackend::IoUring) {
+            run_async_backend(AsyncBackend::IoUring, test_file);
+
+            // A short read is resubmitted until the buffer is full, as with the thread pool
+            int fds[2];
+            assert(pipe(fds) == 0);
+            assert(write(fds[1], "hello", 5) == 5);
+            char piped[10];
+            std::promise<int64_t> piped_result;
+            engine.prepare_read(fds[0], 0, piped, sizeof(piped),
+                [&](int64_t result) { piped_result.set_value(result); });
+            engine.submit();
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            assert(write(fds[1], "world", 5) == 5);
+            assert(piped_result.get_future().get() == 10);
+            assert(memcmp(piped, "helloworld", 10) == 0);
+            close(fds[0]);
+            close(fds[1]);
+        }
+    }
+    run_async_backend(AsyncBackend::ThreadPool, test_file);
+
+    // Closed file throws
+    bool caught_bad_fd = false;
+    try {
+        File fp(test_file, "rb");
+        fp.close();
+        AsyncIoEngine engine(4, AsyncBackend::ThreadPool, 1);
+        AsyncFile async_fp(fp, engine);
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "AsyncFile Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+// Writes one record at its slot, reads it back and counts a match
+Task<void> record_round_trip(CoFile& file, size_t slot, size_t& matched) {
+    char out[64];
+    std::snprintf(out, sizeof(out), "record %06zu", slot);
+    size_t written = co_await file.write_async(static_cast<int64_t>(slot * sizeof(out)), std::span(out));
+    char in[64] = {};
+    size_t read = co_await file.read_async(static_cast<int64_t>(slot * sizeof(out)), std::span(in));
+    if (written == sizeof(out) && read == sizeof(in) && std::memcmp(in, out, sizeof(out)) == 0) {
+        ++matched;
+    }
+}
+
+Task<size_t> sequential_sum(CoFile& file) {
+    size_t total = 0;
+    char chunk[100];
+    for (;;) {
+        size_t read = co_await file.read_async(std::span(chunk));
+        total += read;
+        if (read < sizeof(chunk)) {
+            co_return total;
+        }
+    }
+}
+
+Task<void> sequential_reader(CoFile& file, size_t& total) {
+    total = co_await sequential_sum(file);
+}
+
+Task<void> read_closed(CoFile& file, bool& caught_bad_fd) {
+    char chunk[8];
+    try {
+        co_await file.read_async(std::span(chunk));
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+}
+
+Task<void> failing_task() {
+    throw std::runtime_error("escaped");
+    co_return;
+}
+
+void test_coro_file() {
+    std::cout << "\nTesting CoFile (coroutine awaitables)..." << std::endl;
+    const std::string test_file = "test_coro.bin";
+    cleanup_file(test_file);
+
+    // 1. Thousands of operations in flight from one thread
+    const size_t task_count = 2000;
+    size_t matched = 0;
+    {
+        File fp(test_file, "w+b");
+        IoExecutor executor(256);
+        CoFile co_fp(fp, executor);
+        for (size_t slot = 0; slot < task_count; ++slot) {
+            executor.spawn(record_round_trip(co_fp, slot, matched));
+        }
+        executor.run();
+    }
+    assert(matched == task_count);
+
+    // 2. Sequential reads advance the CoFile's offset, nested tasks return values
+    {
+        File fp(test_file, "rb");
+        IoExecutor executor(8, AsyncBackend::ThreadPool);
+        CoFile co_fp(fp, executor);
+        size_t total = 0;
+        executor.spawn(sequential_reader(co_fp, total));
+        executor.run();
+        assert(total == task_count * 64);
+        assert(co_fp.tell() == static_cast<int64_t>(total));
+    }
+
+    // 3. Closed File surfaces as bad_file_discriptor inside the coroutine
+    {
+        File fp(test_file, "rb");
+        IoExecutor executor(8);
+        CoFile co_fp(fp, executor);
+        fp.close();
+        bool caught_bad_fd = false;
+        executor.spawn(read_closed(co_fp, caught_bad_fd));
+        executor.run();
+        assert(caught_bad_fd);
+    }
+
+    // 4. Exceptions escaping a spawned task are rethrown by run()
+    {
+        IoExecutor executor(8);
+        executor.spawn(failing_task());
+        bool caught = false;
+        try {
+            executor.run();
+        } catch (const std::runtime_error&) {
+            caught = true;
+        }
+        assert(caught);
+    }
+
+    std::cout << "CoFile Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_group_commit() {
+    std::cout << "\nTesting GroupCommit (shared fdatasync)..." << std::endl;
+    const std::string test_file = "test_group_commit.txt";
+    cleanup_file(test_file);
+
+    // 1. Concurrent writers all get their commits, with fewer syncs than commits
+    const unsigned writer_count = 8;
+    const size_t commits_per_writer = 50;
+    std::atomic<size_t> committed(0);
+    uint64_t syncs = 0;
+    {
+        File fp(test_file, "w");
+        GroupCommit group(fp);
+        std::vector<std::thread> writers;
+        for (unsigned t = 0; t < writer_count; ++t) {
+            writers.emplace_back([&, t] {
+                char record[16];
+                std::snprintf(record, sizeof(record), "writer %u\n", t);
+                for (size_t i = 0; i < commits_per_writer; ++i) {
+                    fp.putstring(record);
+                    if (group.commit()) {
+                        ++committed;
+                    }
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        syncs = group.sync_count();
+
+        // The buffered tail was flushed by the last commit
+        File reader(test_file, "r");
+        size_t lines = 0;
+        for (std::string_view line : reader.lines()) {
+            assert(line.substr(0, 7) == "writer ");
+            ++lines;
+        }
+        assert(lines == writer_count * commits_per_writer);
+    }
+    assert(committed == writer_count * commits_per_writer);
+    assert(syncs >= 1 && syncs <= writer_count * commits_per_writer);
+    std::cout << "  " << writer_count * commits_per_writer << " commits took " << syncs << " fdatasync calls" << std::endl;
+
+    // 2. A failed sync is sticky
+    {
+        File fp(test_file, "w");
+        GroupCommit group(fp);
+        assert(group.commit());
+        int fd = fp.get_descriptor();
+        int saved = dup(fd);
+        close(fd); // make the next fdatasync fail
+        FileResult<void> failed = group.try_commit();
+        assert(!failed);
+        assert(failed.error().code() == EBADF);
+        dup2(saved, fd); // the descriptor works again, the GroupCommit stays failed
+        close(saved);
+        assert(!group.commit());
+    }
+
+    // 3. Closed file throws
+    bool caught_bad_fd = false;
+    try {
+        File fp(test_file, "r");
+        fp.close();
+        GroupCommit group(fp);
+    } catch (const bad_file_discriptor&) {
+        caught_bad_fd = true;
+    }
+    assert(caught_bad_fd);
+
+    std::cout << "GroupCommit Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_log_file() {
+    std::cout << "\nTesting LogFile (write-ahead log)..." << std::endl;
+    const std::string log_path = "test_log_file.wal";
+    auto cleanup_log = [&] {
+        for (uint64_t index = 1; index < 64; ++index) {
+            cleanup_file(LogFile::segment_name(log_path, index));
+        }
+    };
+    auto record_text = [](uint64_t sequence) {
+        return "record " + std::to_string(sequence) + std::string(sequence % 50, 'x');
+    };
+    cleanup_log();
+
+    // 1. Concurrent appends roll over small segments and become durable
+    LogOptions options;
+    options.segment_size = 4096;
+    options.commit_interval = std::chrono::microseconds(200);
+    const unsigned writer_count = 4;
+    const uint64_t records_per_writer = 100;
+    {
+        LogFile log(log_path, options);
+        std::vector<std::thread> writers;
+        for (unsigned t = 0; t < writer_count; ++t) {
+            writers.emplace_back([&] {
+                for (uint64_t i = 0; i < records_per_writer; ++i) {
+                    uint64_t sequence = log.append("pending");
+                    assert(sequence >= 1);
+                    if (i % 10 == 9) {
+                        assert(log.wait_durable(sequence));
+                        assert(log.durable_sequence() >= sequence);
+                    }
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        assert(log.last_sequence() == writer_count * records_per_writer);
+        assert(log.segment_index() > 1);
+    }
+    LogRecovery recovery = LogFile::replay(log_path, [](uint64_t, std::span<const std::byte> payload) {
+        assert(std::string_view(reinterpret_cast<const char*>(payload.data()), payload.size()) == "pending");
+    });
+    assert(recovery.records == writer_count * records_per_writer);
+    assert(!recovery.torn);
+    cleanup_log();
+
+    // 2. Reopening continues the sequence, replay returns every record in order
+    options.segment_size = 1024;
+    options.commit_interval = std::chrono::microseconds(0);
+    {
+        LogFile log(log_path, options);
+        for (uint64_t sequence = 1; sequence <= 60; ++sequence) {
+            assert(log.append(record_text(sequence)) == sequence);
+        }
+        assert(log.sync());
+        assert(log.durable_sequence() == 60);
+    }
+    {
+        LogFile log(log_path, options);
+        assert(log.last_sequence() == 60);
+        for (uint64_t sequence = 61; sequence <= 100; ++sequence) {
+            assert(log.append(record_text(sequence)) == sequence);
+        }
+        assert(log.wait_durable(100));
+        assert(log.try_append(std::span<const std::byte>(static_cast<const std::byte*>(NULL), 0)).value() == 101);
+        assert(log.sync_count() >= 1);
+    }
+    uint64_t expected = 1;
+    recovery = LogFile::replay(log_path, [&](uint64_t sequence, std::span<const std::byte> payload) {
+        assert(sequence == expected++);
+        std::string_view text(reinterpret_cast<const char*>(payload.data()), payload.size());
+        assert(sequence == 101 ? text.empty() : text == record_text(sequence));
+    });
+    assert(recovery.records == 101 && recovery.last_sequence == 101);
+    assert(recovery.segments >= 3);
+
+    // 3. A torn record ends the log, later segments are dropped and appends resume there
+    const std::string torn_segment = LogFile::segment_name(log_path, 2);
+    {
+        File fp(torn_segment, "r+b");
+        unsigned char byte = 0;
+        assert(fp.read_at(LogFile::header_size + 20, std::span<unsigned char>(&byte, 1)) == 1);
+        byte ^= 0xFF;
+        assert(fp.write_at(LogFile::header_size + 20, std::span<const unsigned char>(&byte, 1)) == 1);
+    }
+    recovery = LogFile::replay(log_path, [](uint64_t, std::span<const std::byte>) {});
+    assert(recovery.torn && recovery.torn_segment == 2 && recovery.torn_offset >= LogFile::header_size);
+    uint64_t survivors = recovery.records;
+    {
+        LogFile log(log_path, options);
+        assert(log.last_sequence() == survivors);
+        assert(log.segment_index() == 2);
+        assert(log.append("after recovery") == survivors + 1);
+    }
+    recovery = LogFile::replay(log_path, [](uint64_t, std::span<const std::byte>) {});
+    assert(!recovery.torn && recovery.records == survivors + 1 && recovery.segments == 2);
+    assert(!File::try_open(LogFile::segment_name(log_path, 3), "rb"));
+
+    // 4. Records larger than a segment are refused
+    {
+        LogFile log(log_path, options);
+        std::vector<std::byte> huge(options.segment_size);
+        FileResult<uint64_t> refused = log.try_append(huge);
+        assert(!refused && refused.error().code() == EFBIG);
+    }
+
+    std::cout << "LogFile Test Passed." << std::endl;
+    cleanup_log();
+}
+
+void test_atomic_file_writer() {
+    std::cout << "\nTesting AtomicFileWriter (atomic replace)..." << std::endl;
+    const std::string test_file = "test_atomic_file.txt";
+    cleanup_file(test_file);
+    auto contents = [&] {
+        File reader(test_file, "r");
+        std::string text;
+        for (std::string_view line : reader.lines()) {
+            text += line;
+        }
+        return text;
+    };
+
+    // 1. A new file appears only at commit
+    {
+        AtomicFileWriter writer(test_file);
+        assert(writer.file().putstring("first version"));
+        assert(!File::try_open(test_file, "r"));
+        assert(writer.commit());
+        assert(!writer.uses_tmpfile());
+    }
+    assert(contents() == "first version");
+
+    // 2. Replacing keeps the old contents visible until commit
+    {
+        AtomicFileWriter writer(test_file, 0600);
+        assert(writer.file().putstring("second version"));
+        assert(writer.file().flush());
+        assert(contents() == "first version");
+        assert(writer.commit());
+    }
+    assert(contents() == "second version");
+    struct stat info;
+    assert(stat(test_file.c_str(), &info) == 0);
+    assert((info.st_mode & 0777) == 0600);
+
+    // 3. Abort and destruction leave the target alone
+    {
+        AtomicFileWriter writer(test_file);
+        assert(writer.file().putstring("discarded"));
+        writer.abort();
+        assert(!writer.try_commit() && writer.try_commit().error().code() == EBADF);
+        bool caught_bad_fd = false;
+        try {
+            writer.file();
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+    {
+        AtomicFileWriter writer(test_file);
+        assert(writer.file().putstring("dropped"));
+    }
+    assert(contents() == "second version");
+
+    // 4. A missing directory throws
+    bool caught_open_error = false;
+    try {
+        AtomicFileWriter writer("no_such_directory/test_atomic_file.txt");
+    } catch (const error_opning_file&) {
+        caught_open_error = true;
+    }
+    assert(caught_open_error);
+
+    std::cout << "AtomicFileWriter Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_parallel_lines() {
+    std::cout << "\nTesting parallel_lines (chunked map-reduce)..." << std::endl;
+    const std::string test_file = "test_parallel_lines.txt";
+    cleanup_file(test_file);
+
+    // Lines of varied length, some empty, a few longer than a read block, the last without '\n'
+    std::vector<std::string> expected;
+    uint64_t expected_sum = 0;
+    {
+        File fp(test_file, "wb");
+        for (uint64_t i = 0; i < 50000; ++i) {
+            std::string line = (i % 97 == 0) ? std::string() : std::to_string(i) + std::string(i % 13, ' ');
+            if (i % 20000 == 1) {
+                line = std::to_string(i) + std::string(3 << 20, ' ');
+            }
+            expected.push_back(line);
+            expected_sum += line.empty() ? 0 : std::stoull(line);
+            fp.putstring(line.c_str());
+            if (i + 1 < 50000) {
+                fp.putchar('\n');
+            }
+        }
+    }
+
+    File fp(test_file, "r");
+    ThreadPool pool(4);
+    auto add = [](uint64_t a, uint64_t b) { return a + b; };
+
+    // 1. Ranges are contiguous, cover the file and start at line starts
+    std::vector<LineRange> ranges = split_lines(fp, 16);
+    assert(!ranges.empty() && ranges.size() <= 16);
+    assert(ranges.front().begin == 0);
+    for (size_t i = 1; i < ranges.size(); ++i) {
+        assert(ranges[i].begin == ranges[i - 1].end);
+        char before = 0;
+        assert(fp.read_at(ranges[i].begin - 1, std::span<char>(&before, 1)) == 1);
+        assert(before == '\n');
+    }
+    struct stat info;
+    assert(stat(test_file.c_str(), &info) == 0);
+    assert(ranges.back().end == info.st_size);
+
+    // 2. Count, sum and an order-preserving collect agree with the sequential answer
+    for (size_t chunks : {size_t(0), size_t(1), size_t(7), size_t(100000)}) {
+        uint64_t lines = parallel_lines(fp, pool, uint64_t(0), [](uint64_t& n, std::string_view) { ++n; }, add, chunks);
+        assert(lines == expected.size());
+
+        uint64_t sum = parallel_lines(fp, pool, uint64_t(0), [](uint64_t& total, std::string_view line) {
+            uint64_t value = 0;
+            std::from_chars(line.data(), line.data() + line.size(), value);
+            total += value;
+        }, add, chunks);
+        assert(sum == expected_sum);
+    }
+    std::vector<std::string> kept = parallel_lines(fp, pool, std::vector<std::string>(),
+        [](std::vector<std::string>& out, std::string_view line) {
+            if (line.size() > 20) {
+                out.emplace_back(line);
+            }
+        },
+        [](std::vector<std::string> a, std::vector<std::string> b) {
+            a.insert(a.end(), std::make_move_iterator(b.begin()), std::make_move_iterator(b.end()));
+            return a;
+        });
+    std::vector<std::string> long_lines;
+    for (const std::string& line : expected) {
+        if (line.size() > 20) {
+            long_lines.push_back(line);
+        }
+    }
+    assert(kept == long_lines);
+
+    // bool results work too (no std::vector<bool> bits shared between tasks)
+    bool any_long = parallel_lines(fp, pool, false, [](bool& found, std::string_view line) {
+        found = found || line.size() > 20;
+    }, [](bool a, bool b) { return a || b; });
+    assert(any_long == !long_lines.empty());
+
+    // 3. Exceptions from map reach the caller
+    bool caught = false;
+    try {
+        parallel_lines(fp, pool, 0, [](int&, std::string_view line) {
+            if (line == "4238") {
+                throw std::runtime_error("bad line");
+            }
+        }, [](int a, int b) { return a + b; });
+    } catch (const std::runtime_error&) {
+        caught = true;
+    }
+    assert(caught);
+
+    // 4. Empty file and closed file
+    {
+        File empty(test_file, "w+");
+        assert(split_lines(empty, 8).empty());
+        assert(parallel_lines(empty, pool, 5, [](int& n, std::string_view) { ++n; }, [](int a, int b) { return a + b; }) == 5);
+        empty.close();
+        bool caught_bad_fd = false;
+        try {
+            parallel_lines(empty, pool, 0, [](int&, std::string_view) {}, [](int a, int b) { return a + b; });
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+
+    std::cout << "parallel_lines Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_direct_file() {
+    std::cout << "\nTesting DirectFile (O_DIRECT and fallback)..." << std::endl;
+    const std::string test_file = "test_direct_file.bin";
+    cleanup_file(test_file);
+
+    // Unaligned size, so the tail needs padding and truncation
+    const size_t data_size = 3 * 65536 + 5000;
+    std::vector<char> data(data_size);
+    for (size_t i = 0; i < data_size; ++i) {
+        data[i] = static_cast<char>(i * 131 + i / 512);
+    }
+
+    for (DirectIo mode : {DirectIo::Auto, DirectIo::Fallback}) {
+        // 1. Odd sized writes, an aligned zero-copy write, then the tail on close
+        {
+            DirectFile writer(test_file, "w", mode, 65536);
+            assert(mode == DirectIo::Fallback ? !writer.is_direct() : true);
+            assert(writer.alignment() >= 512 && writer.alignment() <= BufferPool::alignment);
+            assert(writer.write(data.data(), 100) == 100);
+            assert(writer.write(data.data() + 100, 65436) == 65436); // completes one buffer
+            AlignedBuffer aligned(2 * 65536);
+            memcpy(aligned.data(), data.data() + 65536, 2 * 65536);
+            assert(writer.write(aligned.data(), 2 * 65536) == 2 * 65536);
+            assert(writer.write(data.data() + 3 * 65536, 5000) == 5000);
+            assert(writer.sync_data());
+            assert(writer.close());
+            assert(writer.close()); // second close is a no-op
+        }
+        struct stat info;
+        assert(stat(test_file.c_str(), &info) == 0);
+        assert(static_cast<size_t>(info.st_size) == data_size);
+        std::vector<char> check(data_size);
+        {
+            File fp(test_file, "rb");
+            assert(fp.read(check.data(), 1, data_size) == data_size);
+        }
+        assert(check == data);
+
+        // 2. Reading back in odd pieces stops cleanly at end of file
+        {
+            DirectFile reader(test_file, "r", mode, 65536);
+            std::vector<char> back(data_size + 100);
+            size_t got = reader.read(back.data(), 7);
+            got += reader.read(back.data() + got, 70000);
+            got += reader.read(back.data() + got, back.size() - got);
+            assert(got == data_size);
+            assert(std::equal(data.begin(), data.end(), back.begin()));
+            assert(reader.read(back.data(), 10) == 0);
+            assert(reader.error() == 0);
+        }
+    }
+    std::cout << "  O_DIRECT " << (DirectFile(test_file, "r").is_direct() ? "in effect" : "rejected, fallback used") << std::endl;
+
+    // 3. Wrong direction, bad mode and a missing file
+    {
+        DirectFile reader(test_file, "r");
+        bool caught_bad_fd = false;
+        try {
+            reader.write(data.data(), 1);
+        } catch (const bad_file_discriptor&) {
+            caught_bad_fd = true;
+        }
+        assert(caught_bad_fd);
+    }
+    bool caught_mode = false;
+    try {
+        DirectFile bad(test_file, "a");
+    } catch (const std::invalid_argument&) {
+        caught_mode = true;
+    }
+    assert(caught_mode);
+    bool caught_open_error = false;
+    try {
+        DirectFile missing("no_such_directory/test_direct_file.bin", "w");
+    } catch (const error_opning_file&) {
+        caught_open_error = true;
+    }
+    assert(caught_open_error);
+
+    std::cout << "DirectFile Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_file_stats() {
+    std::cout << "\nTesting I/O statistics..." << std::endl;
+    const std::string test_file = "test_file_stats.txt";
+    cleanup_file(test_file);
+    FileStatsSnapshot before = FileStatsRegistry::instance().totals();
+
+    // 1. Calls and bytes per operation class of one File
+    {
+        File fp(test_file, "w+");
+        char block[100];
+        memset(block, 'x', sizeof(block));
+        assert(fp.write(block, 1, sizeof(block)) == sizeof(block));
+        assert(fp.putchar('a') == 'a');
+        assert(fp.putstring("line\n"));
+        assert(fp.print("{} {}\n", 42, "print"));
+        assert(fp.printInFile("%d\n", 7));
+        assert(fp.flush());
+        fp.rewind();
+        assert(fp.read(block, 1, 50) == 50);
+        assert(fp.getchar() == 'x');
+        assert(fp.seek(0, SeekOrigin::End));
+
+        FileStatsSnapshot stats = fp.stats();
+        assert(stats[FileOp::Open].calls == 1);
+        assert(stats[FileOp::Write].calls == 5);
+        assert(stats[FileOp::Write].bytes == 100 + 1 + 5 + 9 + 2);
+        assert(stats[FileOp::Write].timeable == 4); // putchar is counted, never timed
+        assert(stats[FileOp::Write].timed() <= 4);  // reads and writes are sampled
+        assert(stats[FileOp::Read].calls == 2 && stats[FileOp::Read].bytes == 51);
+        assert(stats[FileOp::Seek].calls == 2 && stats[FileOp::Seek].timed() == 2);
+        assert(stats[FileOp::Flush].calls == 1);
+        assert(stats[FileOp::Close].calls == 0);
+        assert(stats.total_ns(FileOp::Seek) > 0.0);
+        assert(stats.percentile_ns(FileOp::Seek, 0.5) <= stats.percentile_ns(FileOp::Seek, 0.99));
+
+        // A full sample period of writes times at least one of them
+        for (uint32_t i = 0; i < file_stats_sample_period; ++i) {
+            assert(fp.write(block, 1, 1) == 1);
+        }
+        stats = fp.stats();
+        assert(stats[FileOp::Write].calls == 5 + file_stats_sample_period);
+        assert(stats[FileOp::Write].timed() >= 1 && stats.total_ns(FileOp::Write) > 0.0);
+
+        // Moving the File keeps its counters and its registry entry
+        File moved = std::move(fp);
+        assert(moved.stats()[FileOp::Write].calls == 5 + file_stats_sample_period);
+        assert(fp.stats()[FileOp::Write].calls == 0);
+        bool listed = false;
+        for (const auto& [name, snapshot] : FileStatsRegistry::instance().files()) {
+            listed = listed || (name == test_file && snapshot[FileOp::Write].calls == 5 + file_stats_sample_period);
+        }
+        assert(listed);
+        std::string json = FileStatsRegistry::instance().to_json();
+        assert(json.find("\"name\": \"" + test_file + "\"") != std::string::npos);
+        assert(json.find("\"le_ns\"") != std::string::npos);
+        assert(FileStatsRegistry::instance().to_text().find(test_file) != std::string::npos);
+
+        // Calls from a thread other than the one that opened the File count as well
+        std::thread([&] { assert(moved.putstring("x")); }).join();
+        assert(moved.stats()[FileOp::Write].calls == 6 + file_stats_sample_period);
+    }
+
+    // 2. Closed files drop out of the list, other threads still count in the totals
+    for (const auto& entry : FileStatsRegistry::instance().files()) {
+        assert(entry.first != test_file);
+    }
+    std::thread writer([&] {
+        UnlockedFile fp(test_file, "w");
+        for (int i = 0; i < 1000; ++i) {
+            fp.putchar('t');
+        }
+        std::vector<char> lines(4096, '\n');
+        assert(fp.write_all(std::span<const char>(lines)) == lines.size());
+    });
+    writer.join();
+    {
+        File fp(test_file, "r");
+        size_t count = 0;
+        for (std::string_view line : fp.lines()) {
+            assert(line.empty() == (count > 0));
+            ++count;
+        }
+        assert(count == 4096);
+    }
+
+    // 3. A File closed after its thread's block was destroyed still counts
+    //    (as a File with static storage duration does at exit)
+    struct LateCloser {
+        File* fp = NULL;
+        ~LateCloser() {
+            assert(fp->putstring("late"));
+            delete fp;
+        }
+    };
+    FileStatsSnapshot before_late = FileStatsRegistry::instance().totals();
+    std::thread([&] {
+        thread_local LateCloser closer; // constructed before the thread's block, so destroyed after it
+        closer.fp = new File(test_file, "a");
+    }).join();
+    FileStatsSnapshot after_late = FileStatsRegistry::instance().totals();
+    assert(after_late[FileOp::Write].calls - before_late[FileOp::Write].calls == 1);
+    assert(after_late[FileOp::Close].calls - before_late[FileOp::Close].calls == 1);
+
+    FileStatsSnapshot after = FileStatsRegistry::instance().totals();
+    assert(after[FileOp::Write].calls - before[FileOp::Write].calls >= 6 + file_stats_sample_period + 1000 + 1);
+    assert(after[FileOp::Write].bytes - before[FileOp::Write].bytes >= 117 + file_stats_sample_period + 1000 + 4096);
+    assert(after[FileOp::Read].calls - before[FileOp::Read].calls >= 2 + 4096);
+    assert(after[FileOp::Close].calls - before[FileOp::Close].calls >= 3);
+
+    std::cout << "FileStats Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
+
+void test_file_trace() {
+    std::cout << "\nTesting I/O trace recorder..." << std::endl;
+    const std::string test_file = "test_file_trace.txt";
+    const std::string trace_file = "test_file_trace.json";
+    cleanup_file(test_file);
+    FileTraceRegistry& registry = FileTraceRegistry::instance();
+    registry.clear();
+
+    // 1. Calls of this thread, in order, with fd, offset and bytes
+    int fd = -1;
+    {
+        File fp(test_file, "w+");
+        fd = fp.get_descriptor();
+        char block[64] = {};
+        assert(fp.write(block, 1, sizeof(block)) == sizeof(block));
+        assert(fp.putchar('c') == 'c'); // not traced
+        assert(fp.flush());
+        assert(fp.write_at(100, std::span<const char>(block, 8)) == 8);
+        assert(fp.sync_data());
+    }
+    std::vector<const FileTraceEvent*> mine;
+    std::vector<FileTraceThread> threads = registry.threads();
+    for (const FileTraceThread& thread : threads) {
+        for (const FileTraceEvent& event : thread.events) {
+            if (event.fd == fd) {
+                mine.push_back(&event);
+            }
+        }
+    }
+    assert(mine.size() == 6);
+    const FileOp ops[] = {FileOp::Open, FileOp::Write, FileOp::Flush, FileOp::Write, FileOp::Flush, FileOp::Close};
+    for (size_t i = 0; i < mine.size(); ++i) {
+        assert(mine[i]->op == ops[i]);
+        assert(i == 0 || mine[i]->start >= mine[i - 1]->start);
+    }
+    assert(std::string(mine[0]->name) == "open");
+    assert(mine[1]->bytes == 64 && mine[1]->offset == -1);
+    assert(std::string(mine[3]->name) == "write_at" && mine[3]->offset == 100 && mine[3]->bytes == 8);
+    assert(std::string(mine[4]->name) == "try_sync_data");
+
+    // 2. Other threads get their own ring and name, kept after they exit
+    std::thread worker([&] {
+        registry.set_thread_name("trace \"worker\"");
+        File fp(test_file, "r");
+        char block[16];
+        assert(fp.read(block, 1, sizeof(block)) == sizeof(block));
+    });
+    worker.join();
+    bool found_worker = false;
+    for (const FileTraceThread& thread : registry.threads()) {
+        if (thread.name == "trace \"worker\"") {
+            found_worker = true;
+            assert(thread.events.size() == 3 && thread.events[1].op == FileOp::Read && thread.events[1].bytes == 16);
+        }
+    }
+    assert(found_worker);
+
+    // 3. Chrome trace JSON, and nothing recorded while disabled
+    assert(registry.save(trace_file));
+    {
+        File fp(trace_file, "r");
+        std::string json(4096, '\0');
+        json.resize(fp.read(json.data(), 1, json.size()));
+        assert(json.rfind("{\"traceEvents\": [", 0) == 0);
+        assert(json.find("\"ph\": \"X\"") != std::string::npos);
+        assert(json.find("\"name\": \"write_at\", \"cat\": \"write\"") != std::string::npos);
+        assert(json.find("\"offset\": 100, \"bytes\": 8") != std::string::npos);
+        assert(json.find("\"name\": \"trace \\\"worker\\\"\"") != std::string::npos);
+        assert(json.find("\"dropped_events\": 0") != std::string::npos);
+    }
+    registry.clear();
+    registry.set_enabled(false);
+    {
+        File fp(test_file, "r");
+    }
+    registry.set_enabled(true);
+    for (const FileTraceThread& thread : registry.threads()) {
+        assert(thread.events.empty());
+    }
+
+    // 4. A full ring keeps the newest events and counts the rest as dropped
+    {
+        File fp(test_file, "r");
+        char c;
+        for (size_t i = 0; i < file_trace_capacity + 10; ++i) {
+            assert(fp.read(&c, 1, 1) <= 1);
+        }
+    }
+    for (const FileTraceThread& thread : registry.threads()) {
+        if (!thread.events.empty()) {
+            assert(thread.events.size() == file_trace_capacity);
+            assert(thread.dropped == 12); // open plus the first 11 reads
+            assert(thread.events.back().op == FileOp::Close);
+        }
+    }
+    registry.clear();
+
+    std::cout << "FileTrace Test Passed." << std::endl;
+    cleanup_file(test_file);
+    cleanup_file(trace_file);
+}
+
+void test_concurrent_appender() {
+    std::cout << "\nTesting ConcurrentAppender..." << std::endl;
+    const std::string test_file = "test_concurrent_appender.txt";
+    cleanup_file(test_file);
+    const size_t thread_count = 32;
+    const size_t records_per_thread = 2500; // 80000 records, the sequence numbers wrap
+    const size_t record_size = 16;
+
+    // 1. Records of many threads land whole, each at the offset append reported
+    {
+        File fp(test_file, "w");
+        assert(fp.putstring("header\n")); // buffered, flushed by the appender
+        ConcurrentAppender appender(fp, 1 << 16);
+        assert(appender.written() == 7 && appender.reserved() == 7);
+
+        std::atomic<bool> offsets_ok{true};
+        std::vector<std::thread> writers;
+        for (size_t t = 0; t < thread_count; ++t) {
+            writers.emplace_back([&, t] {
+                char record[record_size + 1];
+                for (size_t i = 0; i < records_per_thread; ++i) {
+                    snprintf(record, sizeof(record), "T%02zu-%011zu\n", t, i);
+                    auto offset = appender.try_append(record, record_size);
+                    if (!offset || (offset.value() - 7) % record_size != 0) {
+                        offsets_ok = false;
+                    }
+                }
+            });
+        }
+        for (std::thread& writer : writers) {
+            writer.join();
+        }
+        assert(offsets_ok);
+        const uint64_t end = 7 + thread_count * records_per_thread * record_size;
+        assert(appender.reserved() == end && appender.written() == end);
+        assert(appender.durable() == 7);
+        assert(appender.sync() && appender.durable() == end);
+        assert(appender.try_sync().value() == end); // nothing new to sync
+        assert(appender.append(std::string_view("")));
+    }
+    {
+        File fp(test_file, "r");
+        char line[64];
+        assert(fp.getstring(line, sizeof(line)) && std::string(line) == "header\n");
+        std::vector<size_t> next(thread_count, 0);
+        std::vector<size_t> seen(thread_count * records_per_thread, 0);
+        size_t count = 0;
+        while (fp.getstring(line, sizeof(line))) {
+            assert(strlen(line) == record_size && line[0] == 'T' && line[3] == '-');
+            size_t t = static_cast<size_t>(atoi(line + 1));
+            size_t i = static_cast<size_t>(atoll(line + 4));
+            assert(t < thread_count && i < records_per_thread);
+            assert(i == next[t]++); // one thread's records keep their order
+            ++seen[t * records_per_thread + i];
+            ++count;
+        }
+        assert(count == thread_count * records_per_thread);
+        assert(std::all_of(seen.begin(), seen.end(), [](size_t n) { return n == 1; }));
+    }
+
+    // 2. In append mode records still land at the offsets they reserved
+    {
+        File fp(test_file, "a");
+        const uint64_t start = 7 + thread_count * records_per_thread * record_size;
+        const size_t append_threads = 8;
+        const size_t append_records = 2000;
+        std::vector<std::vector<uint64_t>> offsets(append_threads);
+        {
+            ConcurrentAppender appender(fp);
+            assert(appender.written() == start);
+            assert((fcntl(fp.get_descriptor(), F_GETFL) & O_APPEND) == 0); // pwrite would ignore the offsets
+            std::vector<std::thread> writers;
+            for (size_t t = 0; t < append_threads; ++t) {
+                writers.emplace_back([&, t] {
+                    char record[record_size + 1];
+                    for (size_t i = 0; i < append_records; ++i) {
+                        snprintf(record, sizeof(record), "A%02zu-%011zu\n", t, i);
+                        offsets[t].push_back(appender.try_append(record, record_size).value());
+                    }
+                });
+            }
+            for (std::thread& writer : writers) {
+                writer.join();
+            }
+            assert(appender.written() == start + append_threads * append_records * record_size);
+        }
+        assert((fcntl(fp.get_descriptor(), F_GETFL) & O_APPEND) != 0);
+        assert(fp.putstring("tail\n") && fp.flush());
+
+        File in(test_file, "rb");
+        char record[record_size + 1];
+        char read_back[record_size];
+        for (size_t t = 0; t < append_threads; ++t) {
+            for (size_t i = 0; i < append_records; ++i) {
+                snprintf(record, sizeof(record), "A%02zu-%011zu\n", t, i);
+                assert(in.read_at(static_cast<int64_t>(offsets[t][i]), std::span(read_back)) == record_size);
+                assert(memcmp(read_back, record, record_size) == 0);
+            }
+        }
+        const uint64_t end = start + append_threads * append_records * record_size;
+        char tail[5];
+        assert(in.read_at(static_cast<int64_t>(end), std::span(tail)) == 5 && memcmp(tail, "tail\n", 5) == 0);
+    }
+
+    // 3. A failed write is sticky and holds the watermark
+    {
+        File fp(test_file, "r");
+        ConcurrentAppender appender(fp);
+        uint64_t start = appender.written();
+        auto result = appender.try_append("record\n", 7);
+        assert(!result && result.error().code() == EBADF);
+        assert(!appender.append(std::string_view("again\n")));
+        assert(!appender.sync());
+        assert(appender.written() == start && appender.durable() == start);
+    }
+
+    std::cout << "ConcurrentAppender Test Passed." << std::endl;
+    cleanup_file(test_file);
+}
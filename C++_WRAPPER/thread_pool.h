@@ -0,0 +1,140 @@
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+// Header inclusion
+#include <condition_variable> // for waking idle workers
+#include <deque>              // for the task queue
+#include <functional>         // for std::function tasks
+#include <mutex>              // for guarding the task queue
+#include <thread>             // for worker threads
+#include <vector>             // for worker list and task batches
+
+
+
+//==================== ThreadPool Class ====================
+// Fixed set of worker threads draining one FIFO task queue. Used by the
+// async I/O fallback and the parallel file drivers.
+class ThreadPool
+{
+    private:
+        std::vector<std::thread> m_workers;        // worker threads
+        std::deque<std::function<void()>> m_tasks; // queued tasks
+        std::mutex m_mutex;                        // guards m_tasks and m_stop
+        std::condition_variable m_cv;              // signals new tasks or stop
+        bool m_stop;                               // set by the destructor
+
+    public:
+        //==================== CONSTRUCTORS ====================
+        /***
+        * @brief       Starts thread_count workers.
+        *
+        * @param[in]   thread_count: number of workers, 0 means one per hardware thread.
+        */
+        explicit ThreadPool(unsigned thread_count = 0) : m_stop(false)
+        {
+            if(thread_count == 0)
+            {
+                thread_count = std::thread::hardware_concurrency();
+            }
+            if(thread_count == 0)
+            {
+                thread_count = 1;
+            }
+
+            m_workers.reserve(thread_count);
+            for(unsigned i = 0; i < thread_count; ++i)
+            {
+                m_workers.emplace_back([this] { run(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+
+
+        //==================== DESTRUCTOR ====================
+        /***
+        * @brief   Runs the tasks still queued, then joins the workers.
+        */
+        ~ThreadPool() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stop = true;
+            }
+            m_cv.notify_all();
+
+            for(std::thread& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+
+
+        //==================== OPERATIONS ====================
+        /***
+        * @brief       Queues one task.
+        */
+        void post(std::function<void()> task)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_cv.notify_one();
+        }
+
+        /***
+        * @brief       Queues a batch of tasks with one lock and one wakeup.
+        *
+        * @param[in]   tasks: tasks to run, left empty.
+        */
+        void post(std::vector<std::function<void()>>& tasks)
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                for(std::function<void()>& task : tasks)
+                {
+                    m_tasks.push_back(std::move(task));
+                }
+            }
+            tasks.clear();
+            m_cv.notify_all();
+        }
+
+        /***
+        * @brief   To get the number of workers.
+        */
+        size_t size() const
+        {
+            return m_workers.size();
+        }
+
+    private:
+        /***
+        * @brief   Worker loop, exits once stopped and the queue is empty.
+        */
+        void run()
+        {
+            for(;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_cv.wait(lock, [this] { return m_stop || !m_tasks.empty(); });
+                    if(m_tasks.empty())
+                    {
+                        return;
+                    }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+};
+
+
+#endif  // _THREAD_POOL_H